@@ -0,0 +1,159 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "portable.h"
+#include "ring.h"
+#include "risc.h"
+
+// cost of allocating a ring & building its program as cx_ensure_ring does, not run by ctest
+// common buffers come from a simulated allocator that hands out made-up bus addresses,
+// only the program buffers are backed by memory, the data chunks are never touched here
+//
+//   bench_alloc [ring mbytes, default 256] [passes, default 5]
+
+#define MB (1024 * 1024)
+#define CHUNK_SIZE (2 * MB)
+
+typedef struct _SIM_ALLOC
+{
+    ULONG next_addr;
+    ULONG count;
+} SIM_ALLOC;
+
+static double now(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// WdfCommonBufferCreate, backed by memory only if va is wanted
+static ULONG sim_alloc(SIM_ALLOC* alloc, ULONG len, PUCHAR* va)
+{
+    ULONG addr = alloc->next_addr;
+
+    if (va && !(*va = malloc(len)))
+    {
+        fprintf(stderr, "out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    alloc->next_addr += len;
+    alloc->count++;
+    return addr;
+}
+
+static void bench(ULONG ring_size, ULONG write_len, int passes)
+{
+    double best_alloc = 0;
+    double best_build = 0;
+    SIM_ALLOC alloc = { 0 };
+
+    for (int pass = 0; pass < passes; pass++)
+    {
+        CX_RING ring;
+        CX_RISC_PROG prog;
+
+        alloc = (SIM_ALLOC){ .next_addr = 0x10000000 };
+
+        double start = now();
+
+        // cx_alloc_risc_prog, then cx_init_dma_chunks
+        ULONG buf_count = cx_risc_buf_count(ring_size, write_len);
+        PCX_RISC_BUF bufs = calloc(buf_count, sizeof(CX_RISC_BUF));
+
+        for (ULONG i = 0; i < buf_count; i++)
+        {
+            bufs[i].addr = sim_alloc(&alloc, CX_RISC_BUF_SIZE, &bufs[i].va);
+        }
+
+        cx_ring_init(&ring, ring_size, CHUNK_SIZE);
+
+        PULONG chunk_addrs = calloc(ring.chunk_count, sizeof(ULONG));
+
+        for (ULONG i = 0; i < ring.chunk_count; i++)
+        {
+            chunk_addrs[i] = sim_alloc(&alloc, CHUNK_SIZE, NULL);
+        }
+
+        double alloc_time = now() - start;
+
+        // cx_init_risc
+        start = now();
+        cx_ring_set_irq_period(&ring, CX_IOCTL_IRQ_PERIOD_DEFAULT);
+        cx_risc_prog_begin(&prog, bufs, buf_count);
+
+        for (ULONG i = 0; i < ring.chunk_count; i++)
+        {
+            if (!cx_risc_prog_write(&prog, &ring, write_len, chunk_addrs[i], CHUNK_SIZE))
+            {
+                fprintf(stderr, "%u program buffers too few\n", buf_count);
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        cx_risc_prog_end(&prog);
+        double build_time = now() - start;
+
+        if (!pass || alloc_time < best_alloc)
+        {
+            best_alloc = alloc_time;
+        }
+
+        if (!pass || build_time < best_build)
+        {
+            best_build = build_time;
+        }
+
+        for (ULONG i = 0; i < buf_count; i++)
+        {
+            free(bufs[i].va);
+        }
+
+        free(chunk_addrs);
+        free(bufs);
+    }
+
+    // the program was one contiguous buffer of this size before it was split
+    ULONG buf_count = cx_risc_buf_count(ring_size, write_len);
+    ULONG contiguous = (ring_size / write_len) * sizeof(CX_RISC_INSTR_WRITE) + PAGE_SIZE;
+
+    printf("%6u %8u %7u %9u %10u KB %10.2f %10.2f\n",
+        ring_size / MB, write_len, alloc.count, buf_count, contiguous / 1024,
+        best_alloc * 1e3, best_build * 1e3);
+}
+
+int main(int argc, char** argv)
+{
+    ULONG mbytes = argc > 1 ? strtoul(argv[1], NULL, 10) : 256;
+    int passes = argc > 2 ? atoi(argv[2]) : 5;
+
+    if (mbytes < 2 || mbytes > 1024 || (mbytes % 2) || passes < 1)
+    {
+        fprintf(stderr, "usage: bench_alloc [ring mbytes, 2-1024 in steps of 2] [passes]\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("best of %d, %u KB data chunks, %u KB program buffers\n", passes, CHUNK_SIZE / 1024, CX_RISC_BUF_SIZE / 1024);
+    printf("%6s %8s %7s %9s %13s %10s %10s\n", "ring", "cdt_len", "allocs", "prog bufs", "was one of", "alloc ms", "build ms");
+
+    // the smallest & largest fifo clusters
+    bench(mbytes * MB, 256, passes);
+    bench(mbytes * MB, 2048, passes);
+
+    return EXIT_SUCCESS;
+}
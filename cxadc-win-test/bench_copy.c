@@ -0,0 +1,155 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "portable.h"
+#include "ring.h"
+
+// throughput of cx_ring_copy out of a ring of separate chunks against memcpy out of one flat
+// buffer of the same size, not run by ctest
+// reads start at random page offsets & wrap the ring like reads of a running capture
+//
+//   bench_copy [ring mbytes, default 64] [read kbytes, default 1024] [mbytes copied per pass, default 4096]
+
+#define MB (1024 * 1024)
+
+typedef struct _COPY_CTX
+{
+    PUCHAR* chunks;
+    PUCHAR dst;
+} COPY_CTX;
+
+static double now(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// xorshift64
+static ULONG64 next(ULONG64* state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static BOOLEAN copy_span(PVOID ctx, ULONG chunk_idx, ULONG chunk_off, ULONG span, LONG64 done)
+{
+    COPY_CTX* copy = ctx;
+    memcpy(copy->dst + done, copy->chunks[chunk_idx] + chunk_off, span);
+    return TRUE;
+}
+
+// the same reads out of a flat ring, split only where they wrap
+static void copy_flat(PUCHAR flat, ULONG ring_size, PUCHAR dst, ULONG off, ULONG len)
+{
+    ULONG first = min(len, ring_size - off);
+
+    memcpy(dst, flat + off, first);
+    memcpy(dst + first, flat, len - first);
+}
+
+int main(int argc, char** argv)
+{
+    ULONG mbytes = argc > 1 ? strtoul(argv[1], NULL, 10) : 64;
+    ULONG read_len = (argc > 2 ? strtoul(argv[2], NULL, 10) : 1024) * 1024;
+    ULONG64 total = (argc > 3 ? strtoull(argv[3], NULL, 10) : 4096) * MB;
+    ULONG ring_size = mbytes * MB;
+
+    static const ULONG chunk_sizes[] = { 64 * 1024, 128 * 1024, 256 * 1024, 512 * 1024, MB, 2 * MB };
+
+    if (mbytes < 2 || mbytes > 1024 || (mbytes % 2) || !read_len || read_len > ring_size || total < read_len)
+    {
+        fprintf(stderr, "usage: bench_copy [ring mbytes, 2-1024 in steps of 2] [read kbytes] [mbytes per pass]\n");
+        return EXIT_FAILURE;
+    }
+
+    ULONG64 reads = total / read_len;
+    PUCHAR flat = malloc(ring_size);
+    PUCHAR dst = malloc(read_len);
+
+    if (!flat || !dst)
+    {
+        fprintf(stderr, "out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    memset(flat, 0x5A, ring_size);
+    memset(dst, 0, read_len);
+
+    ULONG64 state = 0x9E3779B97F4A7C15ULL;
+    double start = now();
+
+    for (ULONG64 i = 0; i < reads; i++)
+    {
+        copy_flat(flat, ring_size, dst, (ULONG)(next(&state) % (ring_size / PAGE_SIZE)) * PAGE_SIZE, read_len);
+    }
+
+    double flat_time = now() - start;
+
+    printf("%u MB ring, %u KB reads, %llu MB per pass\n", mbytes, read_len / 1024, (unsigned long long)(total / MB));
+    printf("%-10s %10s %10s\n", "chunk KB", "MB/s", "vs flat");
+    printf("%-10s %10.1f %10s\n", "flat", total / MB / flat_time, "1.00x");
+
+    for (size_t i = 0; i < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); i++)
+    {
+        CX_RING ring;
+        cx_ring_init(&ring, ring_size, chunk_sizes[i]);
+
+        COPY_CTX copy = { .chunks = calloc(ring.chunk_count, sizeof(PUCHAR)), .dst = dst };
+
+        for (ULONG j = 0; j < ring.chunk_count; j++)
+        {
+            if (!(copy.chunks[j] = malloc(ring.chunk_size)))
+            {
+                fprintf(stderr, "out of memory\n");
+                return EXIT_FAILURE;
+            }
+
+            memset(copy.chunks[j], 0x5A, ring.chunk_size);
+        }
+
+        state = 0x9E3779B97F4A7C15ULL;
+        start = now();
+
+        for (ULONG64 j = 0; j < reads; j++)
+        {
+            LONG64 pos = (LONG64)(next(&state) % (ring_size / PAGE_SIZE)) * PAGE_SIZE;
+            cx_ring_copy(&ring, 0, pos, read_len, copy_span, &copy);
+        }
+
+        double elapsed = now() - start;
+
+        printf("%-10u %10.1f %9.2fx\n", chunk_sizes[i] / 1024, total / MB / elapsed, flat_time / elapsed);
+
+        for (ULONG j = 0; j < ring.chunk_count; j++)
+        {
+            free(copy.chunks[j]);
+        }
+
+        free(copy.chunks);
+    }
+
+    // keeps the copies from being optimized away
+    printf("check %u\n", dst[read_len - 1]);
+
+    free(flat);
+    free(dst);
+    return EXIT_SUCCESS;
+}
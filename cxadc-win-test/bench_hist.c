@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <threads.h>
+#include <time.h>
+
+#include "portable.h"
+#include "hist.h"
+
+// cost of cx_hist_add per call, on one thread & with several threads adding to one histogram
+// as the isr, dpc & work item of several devices can, not run by ctest
+//
+//   bench_hist [calls per thread, default 20000000] [max threads, default 8]
+
+#define MAX_THREADS 64
+#define VALUES 4096
+
+typedef struct _WORKER
+{
+    PCX_LATENCY_HIST hist;
+    ULONG64 calls;
+    ULONG offset;
+} WORKER;
+
+// spread over the buckets like performance counter ticks of real latencies
+static LONG64 values[VALUES];
+
+static double now(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int worker(void* arg)
+{
+    WORKER* w = arg;
+
+    for (ULONG64 i = 0; i < w->calls; i++)
+    {
+        cx_hist_add(w->hist, values[(i + w->offset) % VALUES]);
+    }
+
+    return 0;
+}
+
+static double run(int threads, ULONG64 calls, BOOLEAN shared)
+{
+    static CX_LATENCY_HIST hists[MAX_THREADS];
+    thrd_t thread[MAX_THREADS];
+    WORKER workers[MAX_THREADS];
+
+    for (int i = 0; i < threads; i++)
+    {
+        workers[i] = (WORKER){ .hist = shared ? &hists[0] : &hists[i], .calls = calls, .offset = (ULONG)i * 97 };
+    }
+
+    double start = now();
+
+    for (int i = 0; i < threads; i++)
+    {
+        thrd_create(&thread[i], worker, &workers[i]);
+    }
+
+    for (int i = 0; i < threads; i++)
+    {
+        thrd_join(thread[i], NULL);
+    }
+
+    // wall time per call, of all threads together
+    return (now() - start) * 1e9 / (calls * threads);
+}
+
+int main(int argc, char** argv)
+{
+    ULONG64 calls = argc > 1 ? strtoull(argv[1], NULL, 10) : 20000000;
+    int max_threads = argc > 2 ? atoi(argv[2]) : 8;
+
+    if (!calls || max_threads < 1 || max_threads > MAX_THREADS)
+    {
+        fprintf(stderr, "usage: bench_hist [calls per thread] [max threads, 1-%d]\n", MAX_THREADS);
+        return EXIT_FAILURE;
+    }
+
+    ULONG64 state = 0x9E3779B97F4A7C15ULL;
+
+    for (int i = 0; i < VALUES; i++)
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        values[i] = (LONG64)(state >> (40 + (state & 15)));
+    }
+
+    // with fewer cpus than threads the threads take turns and nothing contends
+    printf("%llu calls per thread, ns of wall time per call\n", (unsigned long long)calls);
+    printf("%8s %10s %10s\n", "threads", "one hist", "one each");
+
+    for (int threads = 1; threads <= max_threads; threads *= 2)
+    {
+        double shared = run(threads, calls, TRUE);
+        double separate = run(threads, calls, FALSE);
+
+        printf("%8d %10.2f %10.2f\n", threads, shared, separate);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "portable.h"
+#include "pack.h"
+
+// throughput of cx_pack10 against cx_pack10_scalar, not run by ctest
+//
+//   bench_pack [mbytes of raw16 input, default 64] [passes, default 20]
+
+typedef VOID (*PACK_FN)(PUCHAR dst, const UCHAR* src, size_t groups);
+
+static double now(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double bench(PACK_FN fn, PUCHAR dst, const UCHAR* src, size_t groups, int passes)
+{
+    double best = 0;
+
+    for (int i = 0; i < passes; i++)
+    {
+        double start = now();
+        fn(dst, src, groups);
+        double elapsed = now() - start;
+
+        if (!i || elapsed < best)
+        {
+            best = elapsed;
+        }
+    }
+
+    return best;
+}
+
+int main(int argc, char** argv)
+{
+    size_t mbytes = argc > 1 ? strtoul(argv[1], NULL, 10) : 64;
+    int passes = argc > 2 ? atoi(argv[2]) : 20;
+    size_t groups = mbytes * 1024 * 1024 / CX_PACK10_GROUP_IN;
+
+    PUCHAR src = malloc(groups * CX_PACK10_GROUP_IN);
+    PUCHAR dst = malloc(groups * CX_PACK10_GROUP_OUT);
+
+    if (!src || !dst || !groups || passes < 1)
+    {
+        fprintf(stderr, "usage: bench_pack [mbytes] [passes]\n");
+        return EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; i < groups * CX_PACK10_GROUP_IN; i++)
+    {
+        src[i] = (UCHAR)(i * 2654435761u >> 24);
+    }
+
+    double scalar = bench(cx_pack10_scalar, dst, src, groups, passes);
+    double packed = bench(cx_pack10, dst, src, groups, passes);
+
+    // throughput is of raw16 input, what the ring holds
+    printf("%zu MB raw16, best of %d\n", mbytes, passes);
+    printf("cx_pack10_scalar %8.1f MB/s\n", mbytes / scalar);
+    printf("cx_pack10        %8.1f MB/s (%.2fx)\n", mbytes / packed, scalar / packed);
+
+    free(src);
+    free(dst);
+    return EXIT_SUCCESS;
+}
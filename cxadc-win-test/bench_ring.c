@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "portable.h"
+#include "ring.h"
+
+// cost of the ring index & wrap math a read does before it copies, not run by ctest
+// each read takes what is available at its position, finds its ring offset and walks
+// the chunk spans it covers, as cx_service_read & cx_copy_from_ring do
+//
+//   bench_ring [ring mbytes, default 64] [reads, default 10000000]
+
+#define MB (1024 * 1024)
+
+static double now(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// xorshift64
+static ULONG64 next(ULONG64* state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static void bench(ULONG ring_size, ULONG chunk_size, ULONG read_len, ULONG64 reads)
+{
+    CX_RING ring;
+    ULONG64 state = 0x9E3779B97F4A7C15ULL;
+    ULONG64 spans = 0;
+    volatile ULONG64 sink = 0;
+
+    cx_ring_init(&ring, ring_size, chunk_size);
+    cx_ring_set_irq_period(&ring, 2 * MB);
+
+    // a capture well past its first lap, readers anywhere in the last ring's worth
+    LONG64 write_pos = 1000LL * ring_size;
+    LONG initial_page = (LONG)(next(&state) % (ring_size / ring.gp_size));
+
+    double start = now();
+
+    for (ULONG64 i = 0; i < reads; i++)
+    {
+        LONG64 read_pos = write_pos - (LONG64)(next(&state) % ring_size);
+        LONG64 len = min((LONG64)read_len, cx_ring_available(&ring, write_pos, read_pos));
+        ULONG ring_off = cx_ring_offset(&ring, initial_page, read_pos);
+
+        while (len > 0)
+        {
+            ULONG chunk_idx;
+            ULONG chunk_off;
+            ULONG span = cx_ring_span(&ring, ring_off, len, &chunk_idx, &chunk_off);
+
+            sink += chunk_idx + chunk_off;
+            ring_off = (ring_off + span) % ring.size;
+            len -= span;
+            spans++;
+        }
+
+        write_pos += read_len;
+    }
+
+    double elapsed = now() - start;
+
+    printf("%8u %8u %8u %10.2f %10.1f\n",
+        ring_size / MB, chunk_size / 1024, read_len / 1024,
+        (double)spans / reads, elapsed * 1e9 / reads);
+}
+
+int main(int argc, char** argv)
+{
+    ULONG mbytes = argc > 1 ? strtoul(argv[1], NULL, 10) : 64;
+    ULONG64 reads = argc > 2 ? strtoull(argv[2], NULL, 10) : 10000000;
+
+    static const ULONG chunk_sizes[] = { 64 * 1024, 2 * MB };
+    static const ULONG read_lens[] = { 4096, 64 * 1024, MB };
+
+    if (mbytes < 2 || mbytes > 1024 || (mbytes % 2) || !reads)
+    {
+        fprintf(stderr, "usage: bench_ring [ring mbytes, 2-1024 in steps of 2] [reads]\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("%llu reads\n", (unsigned long long)reads);
+    printf("%8s %8s %8s %10s %10s\n", "ring MB", "chunk KB", "read KB", "spans", "ns/read");
+
+    for (size_t i = 0; i < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); i++)
+    {
+        for (size_t j = 0; j < sizeof(read_lens) / sizeof(read_lens[0]); j++)
+        {
+            bench(mbytes * MB, chunk_sizes[i], read_lens[j], reads);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,112 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "portable.h"
+#include "fifo.h"
+
+// monte carlo estimate of fifo overflows per preset & sample rate, not run by ctest
+// a WRITE takes the cluster's transfer time on the bus, and with some probability an exponentially distributed stall
+// on top, standing in for bus grant latency behind busy bridges
+//
+//   fifo_model [stall probability, default 0.001] [mean stall us, default 100] [clusters, default 10000000]
+
+#define BUS_RATE 120000000 // bytes per second a WRITE moves at once granted, under the 133 MB/s of 32-bit 33 MHz PCI
+
+typedef struct _MODEL
+{
+    ULONG64 state;
+    double stall_p;
+    double stall_mean;
+    LONG64 transfer;
+} MODEL, *PMODEL;
+
+// xorshift64*, uniform in (0, 1)
+static double uniform(PMODEL model)
+{
+    model->state ^= model->state >> 12;
+    model->state ^= model->state << 25;
+    model->state ^= model->state >> 27;
+    return ((model->state * 2685821657736338717ULL >> 11) + 0.5) / 9007199254740992.0;
+}
+
+static LONG64 model_latency(PVOID ctx)
+{
+    PMODEL model = ctx;
+    LONG64 latency = model->transfer;
+
+    if (uniform(model) < model->stall_p)
+    {
+        latency += (LONG64)(-log(uniform(model)) * model->stall_mean);
+    }
+
+    return latency;
+}
+
+int main(int argc, char** argv)
+{
+    static const struct { ULONG preset; const char* name; } presets[] =
+    {
+        { CX_FIFO_PRESET_DEFAULT, "default" },
+        { CX_FIFO_PRESET_40MHZ, "40mhz" },
+        { CX_FIFO_PRESET_50MHZ, "50mhz" }
+    };
+
+    // 8-bit & tenbit at the usual crystals, bytes per second
+    static const ULONG rates[] = { 28636363, 40000000, 50000000, 57272726, 80000000, 100000000 };
+
+    double stall_p = argc > 1 ? atof(argv[1]) : 0.001;
+    double stall_us = argc > 2 ? atof(argv[2]) : 100;
+    ULONG64 clusters = argc > 3 ? strtoull(argv[3], NULL, 10) : 10000000;
+
+    if (stall_p < 0 || stall_p > 1 || stall_us < 0 || !clusters)
+    {
+        fprintf(stderr, "usage: fifo_model [stall probability] [mean stall us] [clusters]\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("stall probability %g, mean stall %g us, %llu clusters\n\n", stall_p, stall_us, (unsigned long long)clusters);
+    printf("%-8s %10s %14s %14s %14s\n", "preset", "MB/s", "tolerance us", "p(overflow)", "overflows/s");
+
+    for (size_t i = 0; i < sizeof(presets) / sizeof(presets[0]); i++)
+    {
+        CX_FIFO_GEOMETRY fifo;
+        cx_fifo_preset(&fifo, presets[i].preset);
+
+        for (size_t j = 0; j < sizeof(rates) / sizeof(rates[0]); j++)
+        {
+            MODEL model =
+            {
+                .state = 0x9E3779B97F4A7C15ULL,
+                .stall_p = stall_p,
+                .stall_mean = stall_us * 1000,
+                .transfer = (LONG64)fifo.cdt_len * 1000000000 / BUS_RATE
+            };
+
+            ULONG64 overflows = cx_fifo_simulate(&fifo, rates[j], model_latency, &model, clusters);
+            double p = (double)overflows / clusters;
+
+            printf("%-8s %10.1f %14.1f %14.3g %14.3g\n",
+                presets[i].name,
+                rates[j] / 1e6,
+                cx_fifo_stall_tolerance(&fifo, rates[j]) / 1e3,
+                p,
+                p * rates[j] / fifo.cdt_len);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
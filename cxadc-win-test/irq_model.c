@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "portable.h"
+#include "ring.h"
+
+// interrupt rate & cpu cost against how old data is when readers are woken, per irq_period &
+// sample rate, not run by ctest
+// the engine fills the ring at the sample rate, every irq_period it raises IRQ1 and the dpc runs
+// some latency later, reading gp_cnt & publishing up to its last IRQ1 boundary (cx_ring_gp_round)
+// the age at wake-up is how long ago the oldest byte that dpc published was written
+//
+//   irq_model [dpc latency us, default 50] [us of cpu per interrupt, default 20] [seconds, default 10]
+
+#define MB (1024 * 1024)
+#define RING_SIZE (64 * MB)
+
+int main(int argc, char** argv)
+{
+    // 8-bit & tenbit at the usual crystals, bytes per second
+    static const ULONG rates[] = { 28636363, 40000000, 50000000, 57272726, 80000000, 100000000 };
+
+    double latency = (argc > 1 ? atof(argv[1]) : 50) / 1e6;
+    double cost = (argc > 2 ? atof(argv[2]) : 20) / 1e6;
+    double seconds = argc > 3 ? atof(argv[3]) : 10;
+
+    if (latency < 0 || cost < 0 || seconds <= 0)
+    {
+        fprintf(stderr, "usage: irq_model [dpc latency us] [us of cpu per interrupt] [seconds]\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("%u MB ring, dpc latency %g us, %g us per interrupt, %g s\n\n", RING_SIZE / MB, latency * 1e6, cost * 1e6, seconds);
+    printf("%10s %10s %12s %8s %14s\n", "MB/s", "irq KB", "interrupts/s", "cpu %", "worst age ms");
+
+    for (size_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++)
+    {
+        for (ULONG period = 64 * 1024; period <= 8 * MB; period *= 2)
+        {
+            CX_RING ring;
+            cx_ring_init(&ring, RING_SIZE, 2 * MB);
+            cx_ring_set_irq_period(&ring, period);
+
+            LONG gp_count = (LONG)(ring.size / ring.gp_size);
+            LONG last_gp_cnt = 0;
+            LONG64 write_pos = 0;
+            ULONG64 interrupts = 0;
+            double worst = 0;
+
+            for (ULONG64 k = 1; (double)k * ring.irq_period / rates[i] < seconds; k++)
+            {
+                double dpc_time = (double)k * ring.irq_period / rates[i] + latency;
+                LONG64 engine_pos = (LONG64)(dpc_time * rates[i]);
+                LONG gp_cnt = cx_ring_gp_round(&ring, (LONG)((engine_pos / ring.gp_size) % gp_count));
+
+                interrupts++;
+
+                // a late dpc may find the engine past a later IRQ1, it publishes that far
+                LONG64 delta = cx_ring_gp_delta(&ring, last_gp_cnt, gp_cnt);
+
+                if (!delta)
+                {
+                    continue;
+                }
+
+                double age = dpc_time - (double)write_pos / rates[i];
+                worst = max(worst, age);
+
+                write_pos += delta;
+                last_gp_cnt = gp_cnt;
+            }
+
+            double per_second = interrupts / seconds;
+
+            printf("%10.1f %10u %12.1f %8.2f %14.3f\n",
+                rates[i] / 1e6, ring.irq_period / 1024, per_second, per_second * cost * 100, worst * 1e3);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,178 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "portable.h"
+#include "sched.h"
+
+// completion latency of reads of several sizes outstanding at once, replayed against a timed
+// interrupt schedule, not run by ctest
+// every irq_period the dpc publishes write_pos after an exponentially distributed latency, then the
+// read work item passes over the parked reads as cx_read_ready & cx_service_read do, with
+// cx_read_wake_pos deciding which are worth servicing & cx_read_step what to do with them
+// each reader reads sequentially from the start of the capture & issues its next read as soon as one completes
+// latency is from the engine writing the last byte a read returns to the read completing
+//
+//   read_model [MB/s, default 28.6] [irq_period kbytes, default 2048] [mean dpc latency us, default 100] [seconds, default 60]
+
+#define MB (1024 * 1024)
+#define RING_SIZE (64 * MB)
+#define MAX_SAMPLES 1000000
+
+typedef struct _READER
+{
+    LONG64 len;
+    LONG64 read_pos;
+    LONG64 done;
+    ULONG count;
+    ULONG overruns;
+    double* latency;
+} READER;
+
+// xorshift64*, uniform in (0, 1)
+static double uniform(ULONG64* state)
+{
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return ((*state * 2685821657736338717ULL >> 11) + 0.5) / 9007199254740992.0;
+}
+
+static int compare(const void* a, const void* b)
+{
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// one visit of the work item, TRUE if the read completed
+static BOOLEAN service(PCX_RING ring, READER* reader, LONG64 write_pos, double now, double rate)
+{
+    LONG64 remaining = reader->len - reader->done;
+    LONG64 len;
+
+    // cx_read_ready, a read still filling waits until it can be filled in one go
+    CX_READ_ACTION action = cx_read_step(ring, write_pos, reader->read_pos, reader->done, remaining,
+        CX_OVERRUN_POLICY_SKIP, TRUE, &len);
+
+    if ((action == CX_READ_WAIT || action == CX_READ_COPY) &&
+        write_pos < cx_read_wake_pos(ring, reader->read_pos, remaining))
+    {
+        return FALSE;
+    }
+
+    // cx_service_read
+    do
+    {
+        action = cx_read_step(ring, write_pos, reader->read_pos, reader->done, reader->len - reader->done,
+            CX_OVERRUN_POLICY_SKIP, TRUE, &len);
+
+        if (action == CX_READ_COPY)
+        {
+            reader->done += len;
+        }
+        else if (action == CX_READ_SKIP)
+        {
+            reader->overruns++;
+        }
+
+        reader->read_pos += len;
+    } while (action == CX_READ_COPY || action == CX_READ_SKIP);
+
+    if (action == CX_READ_WAIT)
+    {
+        return FALSE;
+    }
+
+    if (reader->count < MAX_SAMPLES)
+    {
+        reader->latency[reader->count] = now - (double)reader->read_pos / rate;
+    }
+
+    reader->count++;
+    reader->done = 0;
+    return TRUE;
+}
+
+int main(int argc, char** argv)
+{
+    static const LONG64 read_lens[] = { 4096, 64 * 1024, MB, 8 * MB, 48 * MB };
+
+    double rate = (argc > 1 ? atof(argv[1]) : 28.6) * 1e6;
+    ULONG irq_period = (argc > 2 ? strtoul(argv[2], NULL, 10) : 2048) * 1024;
+    double dpc_mean = (argc > 3 ? atof(argv[3]) : 100) / 1e6;
+    double seconds = argc > 4 ? atof(argv[4]) : 60;
+
+    if (rate <= 0 || !irq_period || (irq_period & (irq_period - 1)) || dpc_mean < 0 || seconds <= 0)
+    {
+        fprintf(stderr, "usage: read_model [MB/s] [irq_period kbytes, power of 2] [mean dpc latency us] [seconds]\n");
+        return EXIT_FAILURE;
+    }
+
+    CX_RING ring;
+    cx_ring_init(&ring, RING_SIZE, 2 * MB);
+    cx_ring_set_irq_period(&ring, irq_period);
+
+    size_t reader_count = sizeof(read_lens) / sizeof(read_lens[0]);
+    READER readers[sizeof(read_lens) / sizeof(read_lens[0])];
+
+    for (size_t i = 0; i < reader_count; i++)
+    {
+        readers[i] = (READER){ .len = read_lens[i], .latency = malloc(MAX_SAMPLES * sizeof(double)) };
+    }
+
+    ULONG64 state = 0x9E3779B97F4A7C15ULL;
+    double last_dpc = 0;
+
+    for (ULONG64 k = 1; (double)k * ring.irq_period / rate < seconds; k++)
+    {
+        // dpcs run in order, a late one delays the next
+        double dpc_time = max(last_dpc, (double)k * ring.irq_period / rate - log(uniform(&state)) * dpc_mean);
+        LONG64 write_pos = (LONG64)k * ring.irq_period;
+
+        last_dpc = dpc_time;
+
+        for (size_t i = 0; i < reader_count; i++)
+        {
+            while (service(&ring, &readers[i], write_pos, dpc_time, rate))
+            {
+            }
+        }
+    }
+
+    printf("%.1f MB/s, %u KB irq_period, %g us mean dpc latency, %g s, %u MB ring\n\n",
+        rate / 1e6, ring.irq_period / 1024, dpc_mean * 1e6, seconds, RING_SIZE / MB);
+    printf("%10s %8s %9s %10s %10s %10s %10s\n", "read KB", "reads", "overruns", "p50 ms", "p90 ms", "p99 ms", "max ms");
+
+    for (size_t i = 0; i < reader_count; i++)
+    {
+        ULONG n = min(readers[i].count, MAX_SAMPLES);
+
+        qsort(readers[i].latency, n, sizeof(double), compare);
+
+        printf("%10lld %8u %9u %10.3f %10.3f %10.3f %10.3f\n",
+            (long long)(readers[i].len / 1024), readers[i].count, readers[i].overruns,
+            n ? readers[i].latency[n / 2] * 1e3 : 0,
+            n ? readers[i].latency[n * 9 / 10] * 1e3 : 0,
+            n ? readers[i].latency[n * 99 / 100] * 1e3 : 0,
+            n ? readers[i].latency[n - 1] * 1e3 : 0);
+
+        free(readers[i].latency);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,437 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#include <threads.h>
+#include <time.h>
+
+#include "test.h"
+
+#include "capture.h"
+
+#define MS CX_CAPTURE_TICKS_PER_MS
+
+static void test_join(void)
+{
+    CX_CAPTURE capture = { 0 };
+    BOOLEAN is_reader = FALSE;
+
+    // nothing running, the first read starts a capture
+    CHECK_EQ(cx_capture_join(&capture), CX_CAPTURE_START);
+    CHECK(cx_capture_arm(&capture));
+    CHECK(!cx_capture_arm(&capture));
+
+    cx_capture_add_reader(&capture, &is_reader);
+    CHECK(is_reader);
+    CHECK_EQ(capture.reader_count, 1);
+
+    // more reads on the handle neither start nor count it again
+    CHECK_EQ(cx_capture_join(&capture), CX_CAPTURE_NONE);
+    cx_capture_add_reader(&capture, &is_reader);
+    CHECK_EQ(capture.reader_count, 1);
+
+    // an armed capture that never ran is released
+    cx_capture_disarm(&capture);
+    CHECK_EQ(capture.is_capturing, FALSE);
+    CHECK_EQ(cx_capture_join(&capture), CX_CAPTURE_START);
+}
+
+static void test_leave(void)
+{
+    CX_CAPTURE capture = { 0 };
+    BOOLEAN first = FALSE;
+    BOOLEAN second = FALSE;
+    BOOLEAN never_read = FALSE;
+
+    cx_capture_arm(&capture);
+    cx_capture_add_reader(&capture, &first);
+    cx_capture_add_reader(&capture, &second);
+
+    // a handle that never read leaves nothing behind
+    CHECK_EQ(cx_capture_leave(&capture, &never_read, FALSE, 0, 100), CX_CAPTURE_NONE);
+    CHECK_EQ(capture.reader_count, 2);
+
+    // the capture runs on for the other reader
+    CHECK_EQ(cx_capture_leave(&capture, &first, FALSE, 0, 100), CX_CAPTURE_NONE);
+    CHECK(!first);
+    CHECK_EQ(capture.reader_count, 1);
+
+    // leaving twice counts once
+    CHECK_EQ(cx_capture_leave(&capture, &first, FALSE, 0, 100), CX_CAPTURE_NONE);
+    CHECK_EQ(capture.reader_count, 1);
+
+    // the last reader stops it without keep_alive
+    CHECK_EQ(cx_capture_leave(&capture, &second, FALSE, 0, 100), CX_CAPTURE_STOP);
+    CHECK_EQ(capture.reader_count, 0);
+
+    // a capture into a client ring runs until the ring is detached
+    cx_capture_add_reader(&capture, &first);
+    CHECK_EQ(cx_capture_leave(&capture, &first, TRUE, 0, 100), CX_CAPTURE_NONE);
+
+    // or is kept alive from the time the last reader left
+    cx_capture_add_reader(&capture, &first);
+    CHECK_EQ(cx_capture_leave(&capture, &first, FALSE, 50, 100), CX_CAPTURE_KEEP_ALIVE);
+    CHECK_EQ(capture.idle_time, 100);
+
+    // a new reader takes it back
+    CHECK_EQ(cx_capture_join(&capture), CX_CAPTURE_RESUME);
+    CHECK_EQ(capture.idle_time, 0);
+
+    // a stopped capture is not kept alive
+    cx_capture_stop(&capture);
+    CHECK_EQ(cx_capture_idle(&capture, 50, 200), CX_CAPTURE_STOP);
+    CHECK_EQ(capture.idle_time, 0);
+}
+
+static void test_idle_timer(void)
+{
+    CX_CAPTURE capture = { 0 };
+    BOOLEAN is_reader = FALSE;
+    LONG64 left;
+
+    cx_capture_arm(&capture);
+    cx_capture_add_reader(&capture, &is_reader);
+    cx_capture_leave(&capture, &is_reader, FALSE, 10, 1000);
+
+    // early, it waits for the rest
+    CHECK_EQ(cx_capture_idle_timer(&capture, 10, 1000 + 4 * MS, &left), CX_CAPTURE_WAIT);
+    CHECK_EQ(left, 6 * MS);
+
+    CHECK_EQ(cx_capture_idle_timer(&capture, 10, 1000 + 10 * MS, &left), CX_CAPTURE_STOP);
+    CHECK_EQ(left, 0);
+
+    // a reader joined since the timer was armed
+    cx_capture_leave(&capture, &is_reader, FALSE, 10, 1000);
+    cx_capture_add_reader(&capture, &is_reader);
+    cx_capture_leave(&capture, &is_reader, FALSE, 10, 1000);
+    cx_capture_join(&capture);
+    CHECK_EQ(cx_capture_idle_timer(&capture, 10, 1000 + 20 * MS, &left), CX_CAPTURE_NONE);
+}
+
+static void test_set_keep_alive(void)
+{
+    CX_CAPTURE capture = { 0 };
+    BOOLEAN is_reader = FALSE;
+
+    cx_capture_arm(&capture);
+
+    // a capture with readers is left alone
+    cx_capture_add_reader(&capture, &is_reader);
+    CHECK_EQ(cx_capture_set_keep_alive(&capture, 0, 100), CX_CAPTURE_NONE);
+
+    // one being kept alive waits the new time from now, or stops
+    cx_capture_leave(&capture, &is_reader, FALSE, 10, 100);
+    CHECK_EQ(cx_capture_set_keep_alive(&capture, 20, 300), CX_CAPTURE_KEEP_ALIVE);
+    CHECK_EQ(capture.idle_time, 300);
+    CHECK_EQ(cx_capture_set_keep_alive(&capture, 0, 400), CX_CAPTURE_STOP);
+}
+
+// the lifecycle run by threads standing in for readers, the producer, the idle timer & an application
+// setting keep_alive, each decision made under what stands in for capture_lock
+// readers open a handle, read from it a few times & close it, a read waits for data from the producer,
+// the idle timer can be stopped without waiting & so run once the reader it was armed for has joined again
+
+#define READERS 4
+#define HANDLES 1500
+#define READS_MAX 4
+
+typedef struct _CAPTURE_TEST
+{
+    mtx_t capture_lock;
+    CX_CAPTURE capture;
+    ULONG keep_alive;
+
+    // the idle timer, armed & stopped apart from capture_lock like a WDFTIMER
+    mtx_t timer_lock;
+    int timer_armed;
+    LONG64 timer_due;
+
+    LONG64 write_pos;
+    LONG64 readers_done;
+
+    long long starts;
+    long long stops;
+    long long resumes;
+    long long double_starts;        // START while a capture runs
+    long long idle_stops;           // STOP without a capture running
+    long long stops_with_reader;
+    long long negative_count;
+    LONG64 lost_capture;            // a reader saw the capture stop under it
+} CAPTURE_TEST;
+
+static CAPTURE_TEST capture_test;
+
+static ULONG lcg_next(ULONG* state)
+{
+    *state = *state * 1103515245 + 12345;
+    return *state >> 8;
+}
+
+// KeQueryInterruptTime
+static LONG64 now(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (LONG64)ts.tv_sec * 10000000 + ts.tv_nsec / 100;
+}
+
+static void timer_start(LONG64 ticks)
+{
+    mtx_lock(&capture_test.timer_lock);
+    capture_test.timer_armed = 1;
+    capture_test.timer_due = now() + ticks;
+    mtx_unlock(&capture_test.timer_lock);
+}
+
+// WdfTimerStop without waiting, a tick already taken still runs
+static void timer_stop(void)
+{
+    mtx_lock(&capture_test.timer_lock);
+    capture_test.timer_armed = 0;
+    mtx_unlock(&capture_test.timer_lock);
+}
+
+// cx_apply_capture_action, called with capture_lock held
+static void apply(CX_CAPTURE_ACTION action, LONG64 left)
+{
+    switch (action)
+    {
+    case CX_CAPTURE_KEEP_ALIVE:
+        timer_start((LONG64)capture_test.keep_alive * MS);
+        break;
+
+    case CX_CAPTURE_WAIT:
+        timer_start(left);
+        break;
+
+    case CX_CAPTURE_STOP:
+        capture_test.idle_stops += !capture_test.capture.is_capturing;
+        capture_test.stops_with_reader += capture_test.capture.reader_count > 0;
+        capture_test.stops++;
+        cx_capture_stop(&capture_test.capture);
+        break;
+
+    default:
+        break;
+    }
+}
+
+// cx_evt_io_read, a capture can not fail to start here
+static void read_once(PBOOLEAN is_reader)
+{
+    mtx_lock(&capture_test.capture_lock);
+
+    CX_CAPTURE_ACTION action = cx_capture_join(&capture_test.capture);
+
+    if (action == CX_CAPTURE_START)
+    {
+        capture_test.double_starts += !cx_capture_arm(&capture_test.capture);
+        capture_test.starts++;
+    }
+    else if (action == CX_CAPTURE_RESUME)
+    {
+        timer_stop();
+        capture_test.resumes++;
+    }
+
+    cx_capture_add_reader(&capture_test.capture, is_reader);
+    mtx_unlock(&capture_test.capture_lock);
+
+    // parked until the producer publishes past it
+    LONG64 want = InterlockedCompareExchange64(&capture_test.write_pos, 0, 0) + 1;
+
+    while (InterlockedCompareExchange64(&capture_test.write_pos, 0, 0) < want)
+    {
+        if (!InterlockedCompareExchange(&capture_test.capture.is_capturing, 0, 0))
+        {
+            InterlockedIncrement64(&capture_test.lost_capture);
+            break;
+        }
+
+        thrd_yield();
+    }
+}
+
+// cx_evt_file_close
+static void close_handle(PBOOLEAN is_reader)
+{
+    mtx_lock(&capture_test.capture_lock);
+
+    apply(cx_capture_leave(&capture_test.capture, is_reader, FALSE, capture_test.keep_alive, now()), 0);
+    capture_test.negative_count += capture_test.capture.reader_count < 0;
+
+    mtx_unlock(&capture_test.capture_lock);
+}
+
+static int reader(void* arg)
+{
+    ULONG seed = (ULONG)(uintptr_t)arg * 7919;
+
+    for (int i = 0; i < HANDLES; i++)
+    {
+        BOOLEAN is_reader = FALSE;
+        ULONG reads = lcg_next(&seed) % (READS_MAX + 1);
+
+        for (ULONG r = 0; r < reads; r++)
+        {
+            read_once(&is_reader);
+        }
+
+        close_handle(&is_reader);
+
+        // gaps between handles let the capture idle out & be kept alive
+        if (!(lcg_next(&seed) % 8))
+        {
+            thrd_sleep(&(struct timespec) { .tv_nsec = (lcg_next(&seed) % 2000) * 1000 }, NULL);
+        }
+    }
+
+    InterlockedIncrement64(&capture_test.readers_done);
+    return 0;
+}
+
+// the dpc or poll tick, publishing while a capture runs
+static int producer(void* arg)
+{
+    (void)arg;
+
+    while (InterlockedCompareExchange64(&capture_test.readers_done, 0, 0) < READERS)
+    {
+        if (InterlockedCompareExchange(&capture_test.capture.is_capturing, 0, 0))
+        {
+            InterlockedIncrement64(&capture_test.write_pos);
+        }
+
+        thrd_yield();
+    }
+
+    return 0;
+}
+
+// cx_evt_idle_timer, a tick is taken before capture_lock so a reader can join in between
+static int idle_timer(void* arg)
+{
+    (void)arg;
+
+    while (InterlockedCompareExchange64(&capture_test.readers_done, 0, 0) < READERS)
+    {
+        int fire = 0;
+
+        mtx_lock(&capture_test.timer_lock);
+
+        if (capture_test.timer_armed && now() >= capture_test.timer_due)
+        {
+            capture_test.timer_armed = 0;
+            fire = 1;
+        }
+
+        mtx_unlock(&capture_test.timer_lock);
+
+        if (!fire)
+        {
+            thrd_yield();
+            continue;
+        }
+
+        thrd_yield();
+
+        mtx_lock(&capture_test.capture_lock);
+
+        LONG64 left;
+        CX_CAPTURE_ACTION action = cx_capture_idle_timer(&capture_test.capture, capture_test.keep_alive, now(), &left);
+        apply(action, left);
+
+        mtx_unlock(&capture_test.capture_lock);
+    }
+
+    return 0;
+}
+
+// cx_set_keep_alive from another application now & then
+static int set_keep_alive(void* arg)
+{
+    ULONG seed = (ULONG)(uintptr_t)arg;
+
+    while (InterlockedCompareExchange64(&capture_test.readers_done, 0, 0) < READERS)
+    {
+        thrd_sleep(&(struct timespec) { .tv_nsec = 500000 + (lcg_next(&seed) % 2000) * 1000 }, NULL);
+
+        mtx_lock(&capture_test.capture_lock);
+        capture_test.keep_alive = lcg_next(&seed) % 3;
+        apply(cx_capture_set_keep_alive(&capture_test.capture, capture_test.keep_alive, now()), 0);
+        mtx_unlock(&capture_test.capture_lock);
+    }
+
+    return 0;
+}
+
+static void test_stress(void)
+{
+    thrd_t reader_threads[READERS];
+    thrd_t producer_thread;
+    thrd_t timer_thread;
+    thrd_t keep_alive_thread;
+
+    mtx_init(&capture_test.capture_lock, mtx_plain);
+    mtx_init(&capture_test.timer_lock, mtx_plain);
+    capture_test.keep_alive = 1;
+
+    for (int i = 0; i < READERS; i++)
+    {
+        CHECK(thrd_create(&reader_threads[i], reader, (void*)(uintptr_t)(i + 1)) == thrd_success);
+    }
+
+    CHECK(thrd_create(&producer_thread, producer, NULL) == thrd_success);
+    CHECK(thrd_create(&timer_thread, idle_timer, NULL) == thrd_success);
+    CHECK(thrd_create(&keep_alive_thread, set_keep_alive, (void*)(uintptr_t)17) == thrd_success);
+
+    for (int i = 0; i < READERS; i++)
+    {
+        thrd_join(reader_threads[i], NULL);
+    }
+
+    thrd_join(producer_thread, NULL);
+    thrd_join(timer_thread, NULL);
+    thrd_join(keep_alive_thread, NULL);
+
+    // the last capture, if kept alive, ends with keep_alive cleared
+    mtx_lock(&capture_test.capture_lock);
+    capture_test.keep_alive = 0;
+    apply(cx_capture_set_keep_alive(&capture_test.capture, 0, now()), 0);
+    mtx_unlock(&capture_test.capture_lock);
+
+    CHECK_EQ(capture_test.double_starts, 0);
+    CHECK_EQ(capture_test.idle_stops, 0);
+    CHECK_EQ(capture_test.stops_with_reader, 0);
+    CHECK_EQ(capture_test.negative_count, 0);
+    CHECK_EQ(capture_test.lost_capture, 0);
+
+    // every capture started once & stopped once
+    CHECK_EQ(capture_test.capture.reader_count, 0);
+    CHECK_EQ(capture_test.capture.is_capturing, FALSE);
+    CHECK_EQ(capture_test.starts, capture_test.stops);
+
+    // captures came & went, and some were taken back while kept alive
+    CHECK(capture_test.starts > 1);
+    CHECK(capture_test.resumes > 0);
+}
+
+int main(void)
+{
+    test_join();
+    test_leave();
+    test_idle_timer();
+    test_set_keep_alive();
+    test_stress();
+
+    return cx_test_result("capture");
+}
@@ -0,0 +1,140 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#include "test.h"
+
+#include "event.h"
+
+static CX_EVENT events[CX_EVENT_RING_SIZE];
+static CX_EVENT out[CX_EVENT_RING_SIZE];
+
+// record count events, each with its sequence as gp_cnt and stream_pos
+static void record(PLONG64 next_seq, ULONG count)
+{
+    for (ULONG i = 0; i < count; i++)
+    {
+        LONG64 seq = *next_seq;
+        cx_event_record(events, next_seq, CX_EVENT_FIFO_OVERFLOW, (ULONG)seq, seq, seq * 10);
+    }
+}
+
+static void reset(PLONG64 next_seq)
+{
+    for (ULONG i = 0; i < CX_EVENT_RING_SIZE; i++)
+    {
+        events[i] = (CX_EVENT) { .sequence = (ULONG64)-1 };
+    }
+
+    *next_seq = 0;
+}
+
+static void test_collect(void)
+{
+    LONG64 next_seq;
+    ULONG64 seq = 0;
+    ULONG lost;
+
+    reset(&next_seq);
+    record(&next_seq, 10);
+
+    CHECK_EQ(cx_event_collect(events, next_seq, &seq, out, CX_EVENT_RING_SIZE, &lost), 10);
+    CHECK_EQ(lost, 0);
+    CHECK_EQ(seq, 10);
+    CHECK_EQ(out[0].sequence, 0);
+    CHECK_EQ(out[9].sequence, 9);
+    CHECK_EQ(out[9].stream_pos, 9);
+    CHECK_EQ(out[9].timestamp, 90);
+
+    // nothing new
+    CHECK_EQ(cx_event_collect(events, next_seq, &seq, out, CX_EVENT_RING_SIZE, &lost), 0);
+    CHECK_EQ(seq, 10);
+
+    // a sequence from the future is clamped to next_seq
+    seq = 1000;
+    CHECK_EQ(cx_event_collect(events, next_seq, &seq, out, CX_EVENT_RING_SIZE, &lost), 0);
+    CHECK_EQ(seq, 10);
+
+    // max_count is honoured and collecting continues from there
+    seq = 0;
+    CHECK_EQ(cx_event_collect(events, next_seq, &seq, out, 4, &lost), 4);
+    CHECK_EQ(seq, 4);
+    CHECK_EQ(cx_event_collect(events, next_seq, &seq, out, 4, &lost), 4);
+    CHECK_EQ(out[0].sequence, 4);
+}
+
+static void test_wrap(void)
+{
+    LONG64 next_seq;
+    ULONG64 seq = 0;
+    ULONG lost;
+
+    reset(&next_seq);
+
+    // exactly full, nothing lost
+    record(&next_seq, CX_EVENT_RING_SIZE);
+
+    CHECK_EQ(cx_event_collect(events, next_seq, &seq, out, CX_EVENT_RING_SIZE, &lost), CX_EVENT_RING_SIZE);
+    CHECK_EQ(lost, 0);
+
+    // wrapped twice and a bit, a reader still at 0 loses everything before the oldest held
+    record(&next_seq, 2 * CX_EVENT_RING_SIZE + 5);
+
+    seq = 0;
+    CHECK_EQ(cx_event_collect(events, next_seq, &seq, out, CX_EVENT_RING_SIZE, &lost), CX_EVENT_RING_SIZE);
+    CHECK_EQ(lost, 2 * CX_EVENT_RING_SIZE + 5);
+    CHECK_EQ(out[0].sequence, 2 * CX_EVENT_RING_SIZE + 5);
+    CHECK_EQ(out[CX_EVENT_RING_SIZE - 1].sequence, next_seq - 1);
+    CHECK_EQ(seq, next_seq);
+
+    // each slot holds the event of its own sequence after the wrap
+    for (ULONG i = 0; i < CX_EVENT_RING_SIZE; i++)
+    {
+        CHECK_EQ(events[out[i].sequence % CX_EVENT_RING_SIZE].gp_cnt, (ULONG)out[i].sequence);
+    }
+
+    // a reader one event behind the oldest loses one
+    seq = (ULONG64)(next_seq - CX_EVENT_RING_SIZE - 1);
+    CHECK_EQ(cx_event_collect(events, next_seq, &seq, out, 1, &lost), 1);
+    CHECK_EQ(lost, 1);
+    CHECK_EQ(out[0].sequence, next_seq - CX_EVENT_RING_SIZE);
+}
+
+static void test_being_written(void)
+{
+    LONG64 next_seq;
+    ULONG64 seq = 0;
+    ULONG lost;
+
+    reset(&next_seq);
+    record(&next_seq, 8);
+
+    // the isr is rewriting slot 3, and slot 5 already holds a later sequence
+    events[3].sequence = (ULONG64)-1;
+    events[5].sequence = 5 + CX_EVENT_RING_SIZE;
+
+    CHECK_EQ(cx_event_collect(events, next_seq, &seq, out, CX_EVENT_RING_SIZE, &lost), 6);
+    CHECK_EQ(lost, 2);
+    CHECK_EQ(seq, 8);
+    CHECK_EQ(out[2].sequence, 2);
+    CHECK_EQ(out[3].sequence, 4);
+    CHECK_EQ(out[4].sequence, 6);
+}
+
+int main(void)
+{
+    test_collect();
+    test_wrap();
+    test_being_written();
+
+    return cx_test_result("event");
+}
@@ -0,0 +1,149 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#include "test.h"
+
+#include "fifo.h"
+
+#define MHZ 1000000
+
+static void check_layout(PCX_FIFO_GEOMETRY fifo, ULONG cdt_len, ULONG cdt_count)
+{
+    CHECK_EQ(fifo->cdt_len, cdt_len);
+    CHECK_EQ(fifo->cdt_count, cdt_count);
+    CHECK_EQ(fifo->size, cdt_len * cdt_count);
+
+    // the cdt sits at its fixed base, the clusters above it and inside sram
+    CHECK_EQ(fifo->cdt_base, 0x181000);
+    CHECK(fifo->cdt_base + cdt_count * sizeof(CX_CDT_DESCRIPTOR) <= fifo->buf_base);
+    CHECK_EQ(fifo->buf_base + fifo->size, CX_MEM_SRAM_END);
+    CHECK_EQ(fifo->buf_base % cdt_len, 0);
+}
+
+static void test_presets(void)
+{
+    CX_FIFO_GEOMETRY fifo;
+
+    CHECK(cx_fifo_preset(&fifo, CX_FIFO_PRESET_DEFAULT));
+    check_layout(&fifo, 2048, 8);
+
+    CHECK(cx_fifo_preset(&fifo, CX_FIFO_PRESET_40MHZ));
+    check_layout(&fifo, 2048, 12);
+
+    CHECK(cx_fifo_preset(&fifo, CX_FIFO_PRESET_50MHZ));
+    check_layout(&fifo, 2048, 13);
+
+    CHECK(!cx_fifo_preset(&fifo, CX_FIFO_PRESET_50MHZ + 1));
+    CHECK_EQ(fifo.size, 0);
+}
+
+static void test_plan(void)
+{
+    CX_FIFO_GEOMETRY fifo;
+
+    // 13 x 2048 is all the sram there is above the cdt
+    CHECK(!cx_fifo_plan(&fifo, 2048, 14));
+
+    // smaller clusters, more of them
+    CHECK(cx_fifo_plan(&fifo, 256, 100));
+    check_layout(&fifo, 256, 100);
+
+    // as many as fit with their descriptors
+    ULONG most = (CX_MEM_SRAM_END - CX_SRAM_CDT_BASE) / (256 + sizeof(CX_CDT_DESCRIPTOR));
+    CHECK(cx_fifo_plan(&fifo, 256, most));
+    check_layout(&fifo, 256, most);
+    CHECK(!cx_fifo_plan(&fifo, 256, most + 1));
+
+    CHECK(!cx_fifo_plan(&fifo, 128, 8));
+    CHECK(!cx_fifo_plan(&fifo, 4096, 2));
+    CHECK(!cx_fifo_plan(&fifo, 1536, 8));
+    CHECK(!cx_fifo_plan(&fifo, 2048, 1));
+}
+
+static LONG64 constant_latency(PVOID ctx)
+{
+    return *(PLONG64)ctx;
+}
+
+// one cluster's WRITE is stalled, the others take no time
+typedef struct _SPIKE
+{
+    ULONG64 at;
+    ULONG64 count;
+    LONG64 stall;
+} SPIKE, *PSPIKE;
+
+static LONG64 spike_latency(PVOID ctx)
+{
+    PSPIKE spike = ctx;
+    return spike->count++ == spike->at ? spike->stall : 0;
+}
+
+static void test_tolerance(void)
+{
+    CX_FIFO_GEOMETRY fifo;
+
+    // 7 free clusters of 2048 at 20 MB/s
+    CHECK(cx_fifo_preset(&fifo, CX_FIFO_PRESET_DEFAULT));
+    CHECK_EQ(cx_fifo_stall_tolerance(&fifo, 20 * MHZ), 7 * 2048 * 50);
+
+    // the larger presets ride out proportionally longer stalls at the rates they are meant for
+    CHECK(cx_fifo_preset(&fifo, CX_FIFO_PRESET_50MHZ));
+    CHECK_EQ(cx_fifo_stall_tolerance(&fifo, 50 * MHZ), 12 * 2048 * 20);
+}
+
+static void test_simulate(void)
+{
+    CX_FIFO_GEOMETRY fifo;
+    ULONG rate = 40 * MHZ;
+
+    CHECK(cx_fifo_preset(&fifo, CX_FIFO_PRESET_DEFAULT));
+
+    LONG64 tolerance = cx_fifo_stall_tolerance(&fifo, rate);
+    LONG64 fill = 2048LL * 1000000000 / rate;
+
+    // WRITEs that keep up never overflow
+    LONG64 latency = fill;
+    CHECK_EQ(cx_fifo_simulate(&fifo, rate, constant_latency, &latency, 100000), 0);
+
+    // ones that fall behind a little every time eventually always do
+    latency = fill + fill / 10;
+    ULONG64 overflows = cx_fifo_simulate(&fifo, rate, constant_latency, &latency, 100000);
+    CHECK(overflows > 90000 && overflows < 100000);
+
+    // a single stall up to the tolerance is absorbed
+    SPIKE spike = { .at = 50, .stall = tolerance };
+    CHECK_EQ(cx_fifo_simulate(&fifo, rate, spike_latency, &spike, 1000), 0);
+
+    // a longer one overflows the cluster, and the ones queued behind it until the backlog clears
+    spike = (SPIKE) { .at = 50, .stall = tolerance + 1 };
+    CHECK_EQ(cx_fifo_simulate(&fifo, rate, spike_latency, &spike, 1000), 1);
+
+    spike = (SPIKE) { .at = 50, .stall = tolerance + 3 * fill };
+    CHECK_EQ(cx_fifo_simulate(&fifo, rate, spike_latency, &spike, 1000), 3);
+
+    // the 50 MHz preset absorbs what overflowed the default one
+    CHECK(cx_fifo_preset(&fifo, CX_FIFO_PRESET_50MHZ));
+    spike = (SPIKE) { .at = 50, .stall = tolerance + 3 * fill };
+    CHECK_EQ(cx_fifo_simulate(&fifo, rate, spike_latency, &spike, 1000), 0);
+}
+
+int main(void)
+{
+    test_presets();
+    test_plan();
+    test_tolerance();
+    test_simulate();
+
+    return cx_test_result("fifo");
+}
@@ -0,0 +1,223 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#include "test.h"
+
+#include "frame.h"
+
+#define BLOCKS 8
+#define BLOCK_LEN 1000
+
+// record blocks first_seq up to next_seq, each BLOCK_LEN long and ending at timestamp (seq + 1) * 100
+static void record_blocks(PCX_BLOCK_INFO blocks, LONG64 first_seq, LONG64 next_seq)
+{
+    for (ULONG i = 0; i < BLOCKS; i++)
+    {
+        blocks[i] = (CX_BLOCK_INFO) { .sequence = -1 };
+    }
+
+    for (LONG64 seq = first_seq; seq < next_seq; seq++)
+    {
+        blocks[seq % BLOCKS] = (CX_BLOCK_INFO) {
+            .sequence = seq,
+            .start_pos = seq * BLOCK_LEN,
+            .end_pos = (seq + 1) * BLOCK_LEN,
+            .timestamp = (seq + 1) * 100,
+            .gp_cnt = (ULONG)seq
+        };
+    }
+}
+
+static void test_find_block(void)
+{
+    CX_BLOCK_INFO blocks[BLOCKS];
+    CX_BLOCK_INFO info;
+    LONG64 seq = 0;
+
+    record_blocks(blocks, 0, 5);
+
+    CHECK(cx_frame_find_block(blocks, BLOCKS, 5, 0, &seq, &info));
+    CHECK_EQ(seq, 0);
+    CHECK_EQ(info.start_pos, 0);
+
+    // searches forward from the last block found
+    CHECK(cx_frame_find_block(blocks, BLOCKS, 5, 3 * BLOCK_LEN + 10, &seq, &info));
+    CHECK_EQ(seq, 3);
+    CHECK_EQ(info.sequence, 3);
+    CHECK_EQ(info.end_pos, 4 * BLOCK_LEN);
+
+    // not recorded yet
+    CHECK(!cx_frame_find_block(blocks, BLOCKS, 5, 5 * BLOCK_LEN, &seq, &info));
+    CHECK_EQ(seq, 5);
+}
+
+static void test_find_block_reused(void)
+{
+    CX_BLOCK_INFO blocks[BLOCKS];
+    CX_BLOCK_INFO info;
+    LONG64 seq = 0;
+
+    // 0..11 have been overwritten by 12..19
+    record_blocks(blocks, 12, 20);
+
+    CHECK(!cx_frame_find_block(blocks, BLOCKS, 20, 0, &seq, &info));
+    CHECK_EQ(seq, 12);
+
+    seq = 0;
+    CHECK(cx_frame_find_block(blocks, BLOCKS, 20, 15 * BLOCK_LEN, &seq, &info));
+    CHECK_EQ(seq, 15);
+    CHECK_EQ(info.start_pos, 15 * BLOCK_LEN);
+}
+
+static void test_find_block_writing(void)
+{
+    CX_BLOCK_INFO blocks[BLOCKS];
+    CX_BLOCK_INFO info;
+    LONG64 seq = 0;
+
+    record_blocks(blocks, 0, 5);
+
+    // the dpc is rewriting block 2, it is skipped rather than returned part written
+    blocks[2].sequence = -1;
+    blocks[2].start_pos = 99 * BLOCK_LEN;
+
+    CHECK(!cx_frame_find_block(blocks, BLOCKS, 5, 2 * BLOCK_LEN, &seq, &info));
+
+    seq = 0;
+    CHECK(cx_frame_find_block(blocks, BLOCKS, 5, 3 * BLOCK_LEN, &seq, &info));
+    CHECK_EQ(seq, 3);
+
+    // a slot holding a later sequence than the one looked for is skipped too
+    record_blocks(blocks, 0, 5);
+    blocks[2].sequence = 10;
+
+    seq = 2;
+    CHECK(cx_frame_find_block(blocks, BLOCKS, 5, 3 * BLOCK_LEN, &seq, &info));
+    CHECK_EQ(info.sequence, 3);
+}
+
+static void test_time_pos(void)
+{
+    CX_BLOCK_INFO blocks[BLOCKS];
+
+    // block seq covers [seq * 1000, (seq + 1) * 1000) and ends at time (seq + 1) * 100, so pos is time * 10
+    record_blocks(blocks, 0, 5);
+
+    CHECK_EQ(cx_frame_time_pos(blocks, BLOCKS, 5, 250, -1), 2500);
+    CHECK_EQ(cx_frame_time_pos(blocks, BLOCKS, 5, 200, -1), 2000);
+    CHECK_EQ(cx_frame_time_pos(blocks, BLOCKS, 5, 499, -1), 4990);
+    CHECK_EQ(cx_frame_time_pos(blocks, BLOCKS, 5, 101, -1), 1010);
+
+    // at or after the newest block, its end
+    CHECK_EQ(cx_frame_time_pos(blocks, BLOCKS, 5, 500, -1), 5000);
+    CHECK_EQ(cx_frame_time_pos(blocks, BLOCKS, 5, 10000, -1), 5000);
+
+    // before the oldest block ended, its start
+    CHECK_EQ(cx_frame_time_pos(blocks, BLOCKS, 5, 50, -1), 0);
+    CHECK_EQ(cx_frame_time_pos(blocks, BLOCKS, 5, -10, -1), 0);
+
+    // nothing recorded, the caller's write_pos
+    CHECK_EQ(cx_frame_time_pos(blocks, BLOCKS, 0, 250, 1234), 1234);
+}
+
+static void test_time_pos_reused(void)
+{
+    CX_BLOCK_INFO blocks[BLOCKS];
+
+    // 0..11 have been overwritten by 12..19, the oldest still recorded is 12
+    record_blocks(blocks, 12, 20);
+
+    CHECK_EQ(cx_frame_time_pos(blocks, BLOCKS, 20, 1550, -1), 15500);
+    CHECK_EQ(cx_frame_time_pos(blocks, BLOCKS, 20, 0, -1), 12000);
+
+    // the dpc is rewriting 14, everything up to it is treated as gone and 15 is the oldest
+    blocks[14 % BLOCKS].sequence = -1;
+    CHECK_EQ(cx_frame_time_pos(blocks, BLOCKS, 20, 1650, -1), 16500);
+    CHECK_EQ(cx_frame_time_pos(blocks, BLOCKS, 20, 1550, -1), 15000);
+    CHECK_EQ(cx_frame_time_pos(blocks, BLOCKS, 20, 1350, -1), 15000);
+
+    // blocks published by one interrupt share a timestamp, no interpolation between them
+    record_blocks(blocks, 0, 3);
+    blocks[2].timestamp = blocks[1].timestamp;
+    CHECK_EQ(cx_frame_time_pos(blocks, BLOCKS, 3, 200, -1), 3000);
+    CHECK_EQ(cx_frame_time_pos(blocks, BLOCKS, 3, 150, -1), 1500);
+}
+
+static void test_fill_header(void)
+{
+    CX_FRAME_HEADER hdr;
+    CX_BLOCK_INFO info =
+    {
+        .sequence = 7,
+        .start_pos = 7000,
+        .end_pos = 8000,
+        .timestamp = 800,
+        .gp_cnt = 0x1234,
+        .flags = CX_FRAME_FLAG_OUFLOW,
+        .attrs = { .vmux = 1, .level = 20, .tenbit = 1, .sixdb = 0, .center_offset = 3, .irq_period = 4096 }
+    };
+
+    // the header keeps the data behind it 8-byte aligned
+    CHECK_EQ(sizeof(CX_FRAME_HEADER) % 8, 0);
+
+    cx_frame_fill_header(&hdr, &info, 7500, 500, CX_FRAME_FLAG_GAP, 10000000);
+
+    CHECK_EQ(hdr.magic, CX_FRAME_MAGIC);
+    CHECK_EQ(hdr.version, CX_FRAME_VERSION);
+    CHECK_EQ(hdr.header_size, sizeof(CX_FRAME_HEADER));
+    CHECK_EQ(hdr.data_size, 500);
+    CHECK_EQ(hdr.flags, CX_FRAME_FLAG_GAP | CX_FRAME_FLAG_OUFLOW);
+    CHECK_EQ(hdr.sequence, 7);
+    CHECK_EQ(hdr.block_pos, 7000);
+    CHECK_EQ(hdr.stream_pos, 7500);
+    CHECK_EQ(hdr.block_size, 1000);
+    CHECK_EQ(hdr.gp_cnt, 0x1234);
+    CHECK_EQ(hdr.timestamp, 800);
+    CHECK_EQ(hdr.timestamp_freq, 10000000);
+    CHECK_EQ(hdr.attrs.vmux, 1);
+    CHECK_EQ(hdr.attrs.level, 20);
+    CHECK_EQ(hdr.attrs.tenbit, 1);
+    CHECK_EQ(hdr.attrs.center_offset, 3);
+    CHECK_EQ(hdr.attrs.irq_period, 4096);
+}
+
+static void test_fill_header_no_info(void)
+{
+    CX_FRAME_HEADER hdr;
+
+    cx_frame_fill_header(&hdr, NULL, 7500, 500, 0, 10000000);
+
+    CHECK_EQ(hdr.magic, CX_FRAME_MAGIC);
+    CHECK_EQ(hdr.flags, CX_FRAME_FLAG_NO_INFO);
+    CHECK_EQ(hdr.sequence, (ULONG64)-1);
+    CHECK_EQ(hdr.block_pos, 7500);
+    CHECK_EQ(hdr.stream_pos, 7500);
+    CHECK_EQ(hdr.block_size, 500);
+    CHECK_EQ(hdr.data_size, 500);
+    CHECK_EQ(hdr.gp_cnt, 0);
+    CHECK_EQ(hdr.timestamp, 0);
+    CHECK_EQ(hdr.timestamp_freq, 10000000);
+}
+
+int main(void)
+{
+    test_find_block();
+    test_find_block_reused();
+    test_find_block_writing();
+    test_time_pos();
+    test_time_pos_reused();
+    test_fill_header();
+    test_fill_header_no_info();
+
+    return cx_test_result("frame");
+}
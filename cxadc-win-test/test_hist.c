@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#include "test.h"
+
+#include "hist.h"
+
+static void test_bucket_zero(void)
+{
+    CHECK_EQ(cx_hist_bucket(0), 0);
+    CHECK_EQ(cx_hist_bucket(-1), 0);
+    CHECK_EQ(cx_hist_bucket(INT64_MIN), 0);
+    CHECK_EQ(cx_hist_bucket(1), 1);
+}
+
+// bucket n counts [2^(n-1), 2^n)
+static void test_bucket_bounds(void)
+{
+    for (ULONG n = 1; n < CX_LATENCY_BUCKETS - 1; n++)
+    {
+        LONG64 low = 1LL << (n - 1);
+        LONG64 high = (1LL << n) - 1;
+
+        CHECK_EQ(cx_hist_bucket(low), n);
+        CHECK_EQ(cx_hist_bucket(high), n);
+        CHECK_EQ(cx_hist_bucket(high + 1), n + 1);
+    }
+}
+
+// the last bucket counts everything from 2^(CX_LATENCY_BUCKETS - 2) up
+static void test_bucket_overflow(void)
+{
+    ULONG last = CX_LATENCY_BUCKETS - 1;
+
+    CHECK_EQ(cx_hist_bucket((1LL << (last - 1)) - 1), last - 1);
+    CHECK_EQ(cx_hist_bucket(1LL << (last - 1)), last);
+    CHECK_EQ(cx_hist_bucket(1LL << last), last);
+    CHECK_EQ(cx_hist_bucket(1LL << 40), last);
+    CHECK_EQ(cx_hist_bucket(INT64_MAX), last);
+}
+
+static void test_add(void)
+{
+    CX_LATENCY_HIST hist = { 0 };
+
+    cx_hist_add(&hist, 0);
+    cx_hist_add(&hist, 1);
+    cx_hist_add(&hist, 2);
+    cx_hist_add(&hist, 3);
+    cx_hist_add(&hist, INT64_MAX);
+
+    CHECK_EQ(hist.count[0], 1);
+    CHECK_EQ(hist.count[1], 1);
+    CHECK_EQ(hist.count[2], 2);
+    CHECK_EQ(hist.count[CX_LATENCY_BUCKETS - 1], 1);
+}
+
+int main(void)
+{
+    test_bucket_zero();
+    test_bucket_bounds();
+    test_bucket_overflow();
+    test_add();
+
+    return cx_test_result("hist");
+}
@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#include "test.h"
+
+#include <string.h>
+
+#include "pack.h"
+
+#define GUARD 16
+
+// deterministic, so a failure can be reproduced
+static ULONG rand_state = 1;
+
+static UCHAR next_byte(void)
+{
+    rand_state = rand_state * 1103515245 + 12345;
+    return (UCHAR)(rand_state >> 16);
+}
+
+static void test_scalar_layout(void)
+{
+    // samples 0x3FF, 0x000, 0x155, 0x2AA in the top 10 bits
+    const UCHAR src[CX_PACK10_GROUP_IN] = { 0xC0, 0xFF, 0x00, 0x00, 0x40, 0x55, 0x80, 0xAA };
+    UCHAR dst[CX_PACK10_GROUP_OUT];
+
+    cx_pack10_scalar(dst, src, 1);
+
+    // 1111111111 0000000000 0101010101 1010101010
+    CHECK_EQ(dst[0], 0xFF);
+    CHECK_EQ(dst[1], 0xC0);
+    CHECK_EQ(dst[2], 0x05);
+    CHECK_EQ(dst[3], 0x56);
+    CHECK_EQ(dst[4], 0xAA);
+}
+
+// the vector path must match the scalar one for any group count, and write nothing past the last group
+static void test_match_scalar(void)
+{
+    static const size_t base[] = { 0, 8, 1000 };
+
+    for (size_t b = 0; b < sizeof(base) / sizeof(base[0]); b++)
+    {
+        for (size_t tail = 0; tail < 8; tail++)
+        {
+            size_t groups = base[b] + tail;
+            size_t in_len = groups * CX_PACK10_GROUP_IN;
+            size_t out_len = groups * CX_PACK10_GROUP_OUT;
+
+            PUCHAR src = malloc(in_len + 1);
+            PUCHAR expected = malloc(out_len + GUARD);
+            PUCHAR actual = malloc(out_len + GUARD);
+
+            for (size_t i = 0; i < in_len; i++)
+            {
+                src[i] = next_byte();
+            }
+
+            memset(expected, 0xEE, out_len + GUARD);
+            memset(actual, 0xEE, out_len + GUARD);
+
+            cx_pack10_scalar(expected, src, groups);
+            cx_pack10(actual, src, groups);
+
+            if (memcmp(expected, actual, out_len + GUARD))
+            {
+                fprintf(stderr, "%zu groups: packed output differs\n", groups);
+                cx_test_failures++;
+            }
+
+            free(src);
+            free(expected);
+            free(actual);
+        }
+    }
+}
+
+// the low 6 bits of a sample are dropped
+static void test_low_bits(void)
+{
+    UCHAR src[CX_PACK10_GROUP_IN * 4];
+    UCHAR masked[CX_PACK10_GROUP_IN * 4];
+    UCHAR a[CX_PACK10_GROUP_OUT * 4];
+    UCHAR b[CX_PACK10_GROUP_OUT * 4];
+
+    for (size_t i = 0; i < sizeof(src); i++)
+    {
+        src[i] = next_byte();
+        masked[i] = (i % 2) ? src[i] : (UCHAR)(src[i] & 0xC0);
+    }
+
+    cx_pack10(a, src, 4);
+    cx_pack10(b, masked, 4);
+
+    CHECK(!memcmp(a, b, sizeof(a)));
+}
+
+int main(void)
+{
+    test_scalar_layout();
+    test_match_scalar();
+    test_low_bits();
+
+    return cx_test_result("pack");
+}
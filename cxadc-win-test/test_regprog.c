@@ -0,0 +1,205 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#include "test.h"
+
+#include "regprog.h"
+
+#define REGS 16
+
+typedef struct _FAKE_REGS
+{
+    ULONG value[REGS];
+    ULONG ready_after;      // microseconds until reg 0 reads 1
+    ULONG waited;
+} FAKE_REGS, *PFAKE_REGS;
+
+static ULONG fake_read(PVOID ctx, ULONG addr)
+{
+    PFAKE_REGS regs = ctx;
+
+    if (!addr)
+    {
+        return regs->waited >= regs->ready_after;
+    }
+
+    return regs->value[addr / 4];
+}
+
+static VOID fake_write(PVOID ctx, ULONG addr, ULONG value)
+{
+    ((PFAKE_REGS)ctx)->value[addr / 4] = value;
+}
+
+// a sleep that overshoots, as a timer rounded delay does
+static ULONG fake_wait(PVOID ctx, ULONG us)
+{
+    ULONG waited = us * 3;
+
+    ((PFAKE_REGS)ctx)->waited += waited;
+    return waited;
+}
+
+static CX_REG_PROGRAM_OPS fake_ops =
+{
+    .read = fake_read,
+    .write = fake_write,
+    .wait = fake_wait
+};
+
+// a program of count ops, all of op on addr
+static PCX_REG_PROGRAM make_program(ULONG count, ULONG op, ULONG addr, ULONG poll_timeout, size_t* len)
+{
+    *len = FIELD_OFFSET(CX_REG_PROGRAM, ops) + count * sizeof(CX_REG_OP);
+
+    PCX_REG_PROGRAM prog = calloc(1, *len);
+    prog->count = count;
+    prog->poll_timeout = poll_timeout;
+
+    for (ULONG i = 0; i < count; i++)
+    {
+        prog->ops[i] = (CX_REG_OP) { .op = op, .addr = addr, .mask = 1, .value = 1 };
+    }
+
+    return prog;
+}
+
+static PCX_REG_PROGRAM_RESULT make_result(ULONG value_count)
+{
+    return calloc(1, cx_reg_program_result_size(value_count));
+}
+
+static void test_valid(void)
+{
+    size_t len;
+    ULONG value_count;
+    PCX_REG_PROGRAM prog = make_program(4, CX_REG_OP_READ, 8, 0, &len);
+
+    CHECK(cx_reg_program_valid(prog, len, 0, REGS * 4 - 4, &value_count));
+    CHECK_EQ(value_count, 4);
+
+    CHECK(!cx_reg_program_valid(prog, len - 1, 0, REGS * 4 - 4, &value_count));
+    CHECK(!cx_reg_program_valid(prog, len, 16, REGS * 4 - 4, &value_count));
+
+    prog->ops[1].addr = 9;
+    CHECK(!cx_reg_program_valid(prog, len, 0, REGS * 4 - 4, &value_count));
+
+    prog->ops[1] = (CX_REG_OP) { .op = CX_REG_OP_POLL + 1, .addr = 8 };
+    CHECK(!cx_reg_program_valid(prog, len, 0, REGS * 4 - 4, &value_count));
+
+    prog->ops[1] = (CX_REG_OP) { .op = CX_REG_OP_WRITE, .addr = 8 };
+    prog->poll_timeout = CX_REG_POLL_TIMEOUT_MAX + 1;
+    CHECK(!cx_reg_program_valid(prog, len, 0, REGS * 4 - 4, &value_count));
+
+    prog->poll_timeout = CX_REG_POLL_TIMEOUT_MAX;
+    CHECK(cx_reg_program_valid(prog, len, 0, REGS * 4 - 4, &value_count));
+    CHECK_EQ(value_count, 3);
+
+    free(prog);
+}
+
+static void test_run(void)
+{
+    FAKE_REGS regs = { .value = { 0, 0xAA } };
+    size_t len;
+    PCX_REG_PROGRAM prog = make_program(3, CX_REG_OP_READ, 4, 0, &len);
+    PCX_REG_PROGRAM_RESULT result = make_result(3);
+
+    prog->ops[1] = (CX_REG_OP) { .op = CX_REG_OP_MODIFY, .addr = 4, .mask = 0x0F, .value = 0x05 };
+    prog->ops[2] = (CX_REG_OP) { .op = CX_REG_OP_WRITE, .addr = 8, .value = 0x1234 };
+
+    cx_reg_program_run(&fake_ops, &regs, prog, result);
+
+    CHECK_EQ(result->done, 3);
+    CHECK_EQ(result->value_count, 2);
+    CHECK_EQ(result->values[0], 0xAA);
+    CHECK_EQ(result->values[1], 0xAA);
+    CHECK_EQ(regs.value[1], 0xA5);
+    CHECK_EQ(regs.value[2], 0x1234);
+
+    free(prog);
+    free(result);
+}
+
+static void test_poll(void)
+{
+    FAKE_REGS regs = { .ready_after = 1000 };
+    size_t len;
+    PCX_REG_PROGRAM prog = make_program(2, CX_REG_OP_POLL, 0, 2000, &len);
+    PCX_REG_PROGRAM_RESULT result = make_result(2);
+
+    // the time waited counts, not the interval asked for
+    cx_reg_program_run(&fake_ops, &regs, prog, result);
+
+    CHECK_EQ(result->done, 2);
+    CHECK_EQ(result->values[0], 1);
+    CHECK(regs.waited >= 1000 && regs.waited < 1000 + 3 * CX_REG_POLL_INTERVAL);
+
+    // times out, and stops the program
+    regs = (FAKE_REGS) { .ready_after = 5000 };
+    cx_reg_program_run(&fake_ops, &regs, prog, result);
+
+    CHECK_EQ(result->done, 0);
+    CHECK_EQ(result->value_count, 1);
+    CHECK_EQ(result->values[0], 0);
+    CHECK(regs.waited >= 2000 && regs.waited < 2000 + 3 * CX_REG_POLL_INTERVAL);
+
+    free(prog);
+    free(result);
+}
+
+// ready after every 90 ms waited, within poll_timeout each time
+static ULONG chain_read(PVOID ctx, ULONG addr)
+{
+    PFAKE_REGS regs = ctx;
+
+    (void)addr;
+
+    if (regs->waited >= regs->ready_after)
+    {
+        regs->ready_after += 90000;
+        return 1;
+    }
+
+    return 0;
+}
+
+// polls that each finish within poll_timeout stop once the program's time is up
+static void test_program_time(void)
+{
+    CX_REG_PROGRAM_OPS ops = { .read = chain_read, .write = fake_write, .wait = fake_wait };
+    FAKE_REGS regs = { .ready_after = 90000 };
+    size_t len;
+    PCX_REG_PROGRAM prog = make_program(CX_REG_PROGRAM_MAX_OPS, CX_REG_OP_POLL, 0, CX_REG_POLL_TIMEOUT_MAX, &len);
+    PCX_REG_PROGRAM_RESULT result = make_result(CX_REG_PROGRAM_MAX_OPS);
+
+    cx_reg_program_run(&ops, &regs, prog, result);
+
+    // 11 polls fit in CX_REG_PROGRAM_TIME_MAX, the 12th runs out of time
+    CHECK_EQ(result->done, CX_REG_PROGRAM_TIME_MAX / 90000);
+    CHECK_EQ(result->value_count, result->done + 1);
+    CHECK(regs.waited >= CX_REG_PROGRAM_TIME_MAX && regs.waited < CX_REG_PROGRAM_TIME_MAX + 3 * CX_REG_POLL_INTERVAL);
+
+    free(prog);
+    free(result);
+}
+
+int main(void)
+{
+    test_valid();
+    test_run();
+    test_poll();
+    test_program_time();
+
+    return cx_test_result("regprog");
+}
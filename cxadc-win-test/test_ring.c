@@ -0,0 +1,315 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#include "test.h"
+
+#include "ring.h"
+
+#define MB (1024 * 1024)
+
+static CX_RING cx_test_ring(ULONG size, ULONG irq_period)
+{
+    CX_RING ring;
+
+    CHECK(cx_ring_init(&ring, size, 2 * MB));
+    cx_ring_set_irq_period(&ring, irq_period);
+
+    return ring;
+}
+
+static void test_init(void)
+{
+    CX_RING ring;
+
+    CHECK(cx_ring_init(&ring, 64 * MB, 2 * MB));
+    CHECK_EQ(ring.size, 64 * MB);
+    CHECK_EQ(ring.chunk_size, 2 * MB);
+    CHECK_EQ(ring.chunk_count, 32);
+    CHECK_EQ(ring.gp_size, PAGE_SIZE);
+
+    // chunks are whole pages, a power of 2, and the ring is made of whole chunks
+    CHECK(!cx_ring_init(&ring, 64 * MB, PAGE_SIZE / 2));
+    CHECK_EQ(ring.size, 0);
+    CHECK(!cx_ring_init(&ring, 64 * MB, 3 * MB));
+    CHECK(!cx_ring_init(&ring, 65 * MB, 2 * MB));
+    CHECK(!cx_ring_init(&ring, 0, 2 * MB));
+}
+
+static void test_irq_period(void)
+{
+    CX_RING ring = cx_test_ring(64 * MB, 2 * MB);
+
+    CHECK_EQ(ring.irq_period, 2 * MB);
+    CHECK_EQ(cx_ring_set_irq_period(&ring, 128 * MB), 64 * MB);
+    CHECK_EQ(cx_ring_set_irq_period(&ring, 1024), PAGE_SIZE);
+}
+
+static void test_offset(void)
+{
+    CX_RING ring = cx_test_ring(64 * MB, 2 * MB);
+
+    CHECK_EQ(cx_ring_offset(&ring, 0, 0), 0);
+    CHECK_EQ(cx_ring_offset(&ring, 10, 0), 10 * PAGE_SIZE);
+    CHECK_EQ(cx_ring_offset(&ring, 10, 123), 10 * PAGE_SIZE + 123);
+
+    // wraps at the end of the ring, whatever the page the capture started on
+    CHECK_EQ(cx_ring_offset(&ring, 10, 64 * MB - 10 * PAGE_SIZE), 0);
+    CHECK_EQ(cx_ring_offset(&ring, 16383, PAGE_SIZE), 0);
+    CHECK_EQ(cx_ring_offset(&ring, 0, 5LL * 64 * MB + 7), 7);
+    CHECK_EQ(cx_ring_offset(&ring, 16383, 1000LL * 64 * MB + PAGE_SIZE + 1), 1);
+}
+
+static void test_span(void)
+{
+    CX_RING ring = cx_test_ring(64 * MB, 2 * MB);
+    ULONG chunk_idx;
+    ULONG chunk_off;
+
+    // stops at the end of the chunk
+    CHECK_EQ(cx_ring_span(&ring, 2 * MB - 100, 1000, &chunk_idx, &chunk_off), 100);
+    CHECK_EQ(chunk_idx, 0);
+    CHECK_EQ(chunk_off, 2 * MB - 100);
+
+    // or at len
+    CHECK_EQ(cx_ring_span(&ring, 2 * MB + 5, 10, &chunk_idx, &chunk_off), 10);
+    CHECK_EQ(chunk_idx, 1);
+    CHECK_EQ(chunk_off, 5);
+
+    CHECK_EQ(cx_ring_span(&ring, 0, 4LL * MB, &chunk_idx, &chunk_off), 2 * MB);
+    CHECK_EQ(cx_ring_span(&ring, 64 * MB - 1, 4LL * MB, &chunk_idx, &chunk_off), 1);
+    CHECK_EQ(chunk_idx, 31);
+}
+
+typedef struct _COPY_LOG
+{
+    ULONG count;
+    ULONG stop_at;
+    ULONG chunk_idx[8];
+    ULONG chunk_off[8];
+    ULONG span[8];
+    LONG64 done[8];
+} COPY_LOG;
+
+static BOOLEAN log_span(PVOID ctx, ULONG chunk_idx, ULONG chunk_off, ULONG span, LONG64 done)
+{
+    COPY_LOG* log = ctx;
+
+    if (log->count < 8)
+    {
+        log->chunk_idx[log->count] = chunk_idx;
+        log->chunk_off[log->count] = chunk_off;
+        log->span[log->count] = span;
+        log->done[log->count] = done;
+    }
+
+    return ++log->count != log->stop_at;
+}
+
+static void test_copy(void)
+{
+    CX_RING ring = cx_test_ring(8 * MB, 2 * MB);
+    COPY_LOG log = { 0 };
+
+    // from the last page of the ring, across the wrap and a chunk boundary
+    // the capture started at page 1, so stream position 0 is ring offset PAGE_SIZE
+    CHECK(cx_ring_copy(&ring, 1, 8 * MB - 2 * PAGE_SIZE, 2 * MB + 2 * PAGE_SIZE, log_span, &log));
+    CHECK_EQ(log.count, 3);
+    CHECK_EQ(log.chunk_idx[0], 3);
+    CHECK_EQ(log.chunk_off[0], 2 * MB - PAGE_SIZE);
+    CHECK_EQ(log.span[0], PAGE_SIZE);
+    CHECK_EQ(log.done[0], 0);
+    CHECK_EQ(log.chunk_idx[1], 0);
+    CHECK_EQ(log.chunk_off[1], 0);
+    CHECK_EQ(log.span[1], 2 * MB);
+    CHECK_EQ(log.done[1], PAGE_SIZE);
+    CHECK_EQ(log.chunk_idx[2], 1);
+    CHECK_EQ(log.span[2], PAGE_SIZE);
+    CHECK_EQ(log.done[2], 2 * MB + PAGE_SIZE);
+
+    // a span that fails stops the copy
+    log = (COPY_LOG){ .stop_at = 2 };
+    CHECK(!cx_ring_copy(&ring, 1, 8 * MB - 2 * PAGE_SIZE, 2 * MB + 2 * PAGE_SIZE, log_span, &log));
+    CHECK_EQ(log.count, 2);
+
+    // nothing to copy
+    log = (COPY_LOG){ 0 };
+    CHECK(cx_ring_copy(&ring, 0, 0, 0, log_span, &log));
+    CHECK_EQ(log.count, 0);
+}
+
+static void test_lost(void)
+{
+    const LONG64 size = 64 * MB;
+    const LONG64 irq = 2 * MB;
+    CX_RING ring = cx_test_ring(64 * MB, 2 * MB);
+
+    // nothing is overwritten until the capture comes round again
+    CHECK_EQ(cx_ring_oldest_pos(&ring, 0), 0);
+    CHECK_EQ(cx_ring_oldest_pos(&ring, size - irq), 0);
+    CHECK_EQ(cx_ring_oldest_pos(&ring, size), irq);
+    CHECK_EQ(cx_ring_oldest_pos(&ring, 10 * size + 123), 9 * size + irq + 123);
+
+    CHECK_EQ(cx_ring_lost(&ring, size - irq, 0), 0);
+    CHECK_EQ(cx_ring_lost(&ring, size, 0), irq);
+    CHECK_EQ(cx_ring_lost(&ring, size, irq), 0);
+
+    // lapped by exactly one ring, the period the engine is filling is lost too
+    CHECK_EQ(cx_ring_lost(&ring, 10 * size, 9 * size), irq);
+    CHECK_EQ(cx_ring_lost(&ring, 10 * size, 5 * size), 4 * size + irq);
+
+    // ahead of the capture
+    CHECK_EQ(cx_ring_lost(&ring, size, 2 * size), 0);
+}
+
+static void test_poll_margin(void)
+{
+    const LONG64 size = 64 * MB;
+    CX_RING ring = cx_test_ring(64 * MB, 2 * MB);
+
+    // with the risc interrupt the engine is at most one period ahead of what was published
+    CHECK_EQ(ring.margin, 2 * MB);
+    CHECK_EQ(cx_ring_set_poll_rate(&ring, 0), 2 * MB);
+
+    // a poll holds back a unit and the engine runs on for up to two ticks at the highest rate,
+    // rounded up to whole units
+    CHECK_EQ(cx_ring_set_poll_rate(&ring, 50), 978 * PAGE_SIZE);
+    CHECK(ring.margin >= PAGE_SIZE + 2LL * CX_RING_BYTE_RATE_MAX / 50);
+    CHECK_EQ(cx_ring_set_poll_rate(&ring, 10000), 6 * PAGE_SIZE);
+
+    // whatever irq_period is
+    CHECK_EQ(cx_ring_set_poll_rate(&ring, 1000), 50 * PAGE_SIZE);
+    CHECK_EQ(cx_ring_oldest_pos(&ring, 2 * size), size + 50 * PAGE_SIZE);
+    CHECK_EQ(cx_ring_lost(&ring, 2 * size, size + 2 * MB), 0);
+
+    // at the lowest rate most of the smallest ring is still readable
+    CHECK(cx_ring_init(&ring, 16 * MB, 2 * MB));
+    cx_ring_set_irq_period(&ring, 2 * MB);
+    CHECK(cx_ring_set_poll_rate(&ring, 50) <= ring.size / 2);
+
+    // units are larger in the largest rings
+    CHECK(cx_ring_init(&ring, 1024 * MB, 2 * MB));
+    cx_ring_set_irq_period(&ring, 2 * MB);
+    CHECK_EQ(cx_ring_set_poll_rate(&ring, 50), 246 * 4 * PAGE_SIZE);
+
+    // a new irq period goes back to the interrupt's margin until the rate is set again
+    CHECK_EQ(cx_ring_set_irq_period(&ring, 4 * MB), 4 * MB);
+    CHECK_EQ(ring.margin, 4 * MB);
+}
+
+static void test_available(void)
+{
+    const LONG64 size = 64 * MB;
+    const LONG64 irq = 2 * MB;
+    CX_RING ring = cx_test_ring(64 * MB, 2 * MB);
+
+    CHECK_EQ(cx_ring_available(&ring, 100, 50), 50);
+    CHECK_EQ(cx_ring_available(&ring, 100, 100), 0);
+    CHECK_EQ(cx_ring_available(&ring, 100, 200), 0);
+
+    // a lapped reader can only take what is left after the gap
+    CHECK_EQ(cx_ring_available(&ring, size, 0), size - irq);
+    CHECK_EQ(cx_ring_available(&ring, 10 * size, 0), size - irq);
+
+    // positions keep counting across wraps of the ring
+    CHECK_EQ(cx_ring_available(&ring, 10 * size + PAGE_SIZE, 10 * size + PAGE_SIZE - size / 2), size / 2);
+}
+
+static void test_join(void)
+{
+    const LONG64 size = 64 * MB;
+    const LONG64 irq = 2 * MB;
+    CX_RING ring = cx_test_ring(64 * MB, 2 * MB);
+    const LONG64 write_pos = 3 * size;
+
+    CHECK_EQ(cx_ring_join_pos(&ring, write_pos, CX_READ_ORIGIN_HEAD, 0), write_pos);
+    CHECK_EQ(cx_ring_join_pos(&ring, write_pos, CX_READ_ORIGIN_HEAD, 100), write_pos - 100);
+
+    // clamped to the oldest intact data
+    CHECK_EQ(cx_ring_join_pos(&ring, write_pos, CX_READ_ORIGIN_HEAD, 2 * size), 2 * size + irq);
+    CHECK_EQ(cx_ring_join_pos(&ring, write_pos, CX_READ_ORIGIN_START, 5), 2 * size + irq);
+    CHECK_EQ(cx_ring_join_pos(&ring, 100, CX_READ_ORIGIN_START, 5), 5);
+
+    // a position the capture has not reached yet is kept, the read waits for it
+    CHECK_EQ(cx_ring_join_pos(&ring, write_pos, CX_READ_ORIGIN_START, 4 * size), 4 * size);
+}
+
+static void test_gp_size(void)
+{
+    CX_RING ring;
+
+    // one gp_cnt unit per page while the 16-bit counter can count the pages
+    CHECK(cx_ring_init(&ring, 16 * MB, 2 * MB));
+    CHECK_EQ(ring.gp_size, PAGE_SIZE);
+    CHECK(cx_ring_init(&ring, 256 * MB, 2 * MB));
+    CHECK_EQ(ring.gp_size, PAGE_SIZE);
+
+    // above 256 MB a unit doubles until the ring fits in CX_GP_CNT_MAX of them
+    CHECK(cx_ring_init(&ring, 258 * MB, 2 * MB));
+    CHECK_EQ(ring.gp_size, 2 * PAGE_SIZE);
+    CHECK(cx_ring_init(&ring, 512 * MB, 2 * MB));
+    CHECK_EQ(ring.gp_size, 2 * PAGE_SIZE);
+    CHECK(cx_ring_init(&ring, 514 * MB, 2 * MB));
+    CHECK_EQ(ring.gp_size, 4 * PAGE_SIZE);
+    CHECK(cx_ring_init(&ring, 1024 * MB, 2 * MB));
+    CHECK_EQ(ring.gp_size, 4 * PAGE_SIZE);
+    CHECK_EQ(ring.size / ring.gp_size, CX_GP_CNT_MAX);
+
+    // an irq period is at least one unit
+    CHECK_EQ(cx_ring_set_irq_period(&ring, 4096), 4 * PAGE_SIZE);
+}
+
+static void test_gp_wrap(void)
+{
+    const LONG last = CX_GP_CNT_MAX - 1;
+    CX_RING ring = cx_test_ring(1024 * MB, 8 * MB);
+    const LONG64 unit = ring.gp_size;
+
+    // the counter runs 0 to 0xFFFF on the largest ring and is reset by the last WRITE
+    CHECK_EQ(cx_ring_gp_delta(&ring, last, 0), unit);
+    CHECK_EQ(cx_ring_gp_delta(&ring, last - 1, 1), 3 * unit);
+    CHECK_EQ(cx_ring_gp_delta(&ring, 65000, 100), (CX_GP_CNT_MAX - 65000 + 100) * unit);
+    CHECK_EQ(cx_ring_gp_delta(&ring, 100, 100), 0);
+    CHECK_EQ(cx_ring_gp_delta(&ring, 0, last), (LONG64)last * unit);
+
+    // IRQ1 every 8 MB is every 512 units
+    CHECK_EQ(cx_ring_gp_round(&ring, 1000), 512);
+    CHECK_EQ(cx_ring_gp_round(&ring, 511), 0);
+    CHECK_EQ(cx_ring_gp_round(&ring, last), CX_GP_CNT_MAX - 512);
+
+    // a poll steps back over the unit being written, across the wrap too
+    CHECK_EQ(cx_ring_gp_poll(&ring, -1, 0), 0);
+    CHECK_EQ(cx_ring_gp_poll(&ring, 0, 0), 0);
+    CHECK_EQ(cx_ring_gp_poll(&ring, last - 2, 0), last);
+    CHECK_EQ(cx_ring_gp_poll(&ring, last, 5), 4);
+
+    // positions keep counting as the counter wraps, a published unit maps back to its offset
+    CHECK_EQ(cx_ring_offset(&ring, last, unit), 0);
+    CHECK_EQ(cx_ring_offset(&ring, last, 3LL * 1024 * MB + unit * 2), unit);
+}
+
+int main(void)
+{
+    test_init();
+    test_irq_period();
+    test_offset();
+    test_span();
+    test_copy();
+    test_lost();
+    test_poll_margin();
+    test_available();
+    test_join();
+    test_gp_size();
+    test_gp_wrap();
+
+    return cx_test_result("ring");
+}
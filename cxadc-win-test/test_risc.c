@@ -0,0 +1,266 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#include "test.h"
+
+#include "risc.h"
+
+#define MB (1024 * 1024)
+#define GB4 0x100000000ULL
+
+static void test_sg_add(void)
+{
+    CX_SG_ENTRY sg[4];
+    ULONG sg_count = 0;
+
+    // contiguous elements are merged
+    CHECK(cx_risc_sg_add(sg, &sg_count, 0x10000, PAGE_SIZE));
+    CHECK(cx_risc_sg_add(sg, &sg_count, 0x11000, 2 * PAGE_SIZE));
+    CHECK_EQ(sg_count, 1);
+    CHECK_EQ(sg[0].addr, 0x10000);
+    CHECK_EQ(sg[0].len, 3 * PAGE_SIZE);
+
+    CHECK(cx_risc_sg_add(sg, &sg_count, 0x40000, PAGE_SIZE));
+    CHECK_EQ(sg_count, 2);
+    CHECK_EQ(sg[1].addr, 0x40000);
+
+    // the last page below 4 GB is reachable, anything above it is not
+    CHECK(cx_risc_sg_add(sg, &sg_count, GB4 - PAGE_SIZE, PAGE_SIZE));
+    CHECK(!cx_risc_sg_add(sg, &sg_count, GB4 - PAGE_SIZE, 2 * PAGE_SIZE));
+    CHECK(!cx_risc_sg_add(sg, &sg_count, GB4, PAGE_SIZE));
+
+    // nor is part of a page
+    CHECK(!cx_risc_sg_add(sg, &sg_count, 0x80800, PAGE_SIZE));
+    CHECK(!cx_risc_sg_add(sg, &sg_count, 0x80000, PAGE_SIZE / 2));
+    CHECK(!cx_risc_sg_add(sg, &sg_count, 0x80000, 0));
+    CHECK_EQ(sg_count, 3);
+}
+
+static void test_sg_bounced(void)
+{
+    CX_SG_ENTRY sg[] = { { 0x10000, 2 * PAGE_SIZE }, { 0x40000, PAGE_SIZE } };
+    ULONG64 pfns[3] = { 0x10, 0x11, 0x40 };
+
+    // logical addresses are the physical ones, all below 4 GB
+    CHECK(!cx_risc_sg_bounced(sg, 2, pfns, 3));
+
+    // one page is above 4 GB and was given a bounce buffer
+    pfns[2] = GB4 >> PAGE_SHIFT;
+    CHECK(cx_risc_sg_bounced(sg, 2, pfns, 3));
+
+    // the low pages are at other addresses too, the adapter remaps dma
+    pfns[0] = 0x99;
+    CHECK(!cx_risc_sg_bounced(sg, 2, pfns, 3));
+
+    // all above 4 GB with nothing to tell remapping from bouncing is refused
+    pfns[0] = (GB4 >> PAGE_SHIFT) + 1;
+    pfns[1] = (GB4 >> PAGE_SHIFT) + 2;
+    CHECK(cx_risc_sg_bounced(sg, 2, pfns, 3));
+}
+
+// program buffers at made-up bus addresses, apart so a JUMP can only land on the one it means
+static PCX_RISC_BUF alloc_bufs(ULONG count)
+{
+    PCX_RISC_BUF bufs = calloc(count, sizeof(CX_RISC_BUF));
+
+    for (ULONG i = 0; i < count; i++)
+    {
+        bufs[i].va = calloc(1, CX_RISC_BUF_SIZE);
+        bufs[i].addr = 0x40000000 + (count - i) * 0x100000;
+    }
+
+    return bufs;
+}
+
+static void free_bufs(PCX_RISC_BUF bufs, ULONG count)
+{
+    for (ULONG i = 0; i < count; i++)
+    {
+        free(bufs[i].va);
+    }
+
+    free(bufs);
+}
+
+// follow the program as the card does, from the SYNC until it jumps back to the first WRITE,
+// collecting the WRITEs in the order they run
+// returns how many there were, or 0 if the program strays out of its buffers
+static ULONG run_prog(PCX_RISC_BUF bufs, ULONG buf_count, PCX_RISC_INSTR_WRITE out, ULONG out_count)
+{
+    ULONG addr = bufs[0].addr;
+    ULONG count = 0;
+
+    CHECK_EQ(((PCX_RISC_INSTR_SYNC)bufs[0].va)->opcode, CX_RISC_INSTR_SYNC_OPCODE);
+    addr += sizeof(CX_RISC_INSTR_SYNC);
+
+    while (count <= out_count)
+    {
+        PUCHAR va = NULL;
+
+        for (ULONG i = 0; i < buf_count; i++)
+        {
+            if (addr >= bufs[i].addr && addr + sizeof(CX_RISC_INSTR_JUMP) <= bufs[i].addr + CX_RISC_BUF_SIZE)
+            {
+                va = bufs[i].va + (addr - bufs[i].addr);
+            }
+        }
+
+        if (!va)
+        {
+            return 0;
+        }
+
+        PCX_RISC_INSTR_WRITE instr = (PCX_RISC_INSTR_WRITE)va;
+
+        if (instr->opcode == CX_RISC_INSTR_JUMP_OPCODE)
+        {
+            addr = ((PCX_RISC_INSTR_JUMP)va)->jump_address;
+
+            if (addr == bufs[0].addr + sizeof(CX_RISC_INSTR_SYNC))
+            {
+                return count;
+            }
+
+            continue;
+        }
+
+        if (instr->opcode != CX_RISC_INSTR_WRITE_OPCODE || count == out_count)
+        {
+            return 0;
+        }
+
+        out[count++] = *instr;
+        addr += sizeof(CX_RISC_INSTR_WRITE);
+    }
+
+    return 0;
+}
+
+static void test_buf_count(void)
+{
+    // a buffer is 64 KB of 8 byte WRITEs, less the SYNC & JUMP
+    CHECK_EQ(CX_RISC_BUF_WRITES, 8190);
+    CHECK_EQ(cx_risc_buf_count(CX_RISC_BUF_WRITES * 2048, 2048), 1);
+    CHECK_EQ(cx_risc_buf_count(16 * MB, 2048), 2);
+
+    // a 1 GB ring of the smallest clusters takes 32 MB of program, as 513 buffers
+    CHECK_EQ(cx_risc_buf_count(1024 * MB, 256), 513);
+    CHECK_EQ(cx_risc_buf_count(1024 * MB, 2048), 65);
+}
+
+static void test_write_sg(void)
+{
+    CX_RING ring;
+    CX_RISC_PROG prog;
+    CX_SG_ENTRY sg[] = { { 0x100000, 12 * MB }, { 0x2000000, 4 * MB } };
+    ULONG write_len = 2048;
+    ULONG count = (16 * MB) / write_len;
+    ULONG buf_count = cx_risc_buf_count(16 * MB, write_len);
+    PCX_RISC_BUF bufs = alloc_bufs(buf_count);
+    PCX_RISC_INSTR_WRITE instr = calloc(count, sizeof(CX_RISC_INSTR_WRITE));
+
+    CHECK(cx_ring_init(&ring, 16 * MB, PAGE_SIZE));
+    cx_ring_set_irq_period(&ring, 2 * MB);
+
+    cx_risc_prog_begin(&prog, bufs, buf_count);
+    CHECK(cx_risc_write_sg(&prog, &ring, write_len, sg, 2));
+    cx_risc_prog_end(&prog);
+
+    // the card runs every WRITE once before it is back at the first
+    CHECK_EQ(run_prog(bufs, buf_count, instr, count), count);
+
+    // WRITEs follow the segments in ring order
+    CHECK_EQ(instr[0].pci_target_address, 0x100000);
+    CHECK_EQ(instr[1].pci_target_address, 0x100000 + write_len);
+    CHECK_EQ(instr[(12 * MB) / write_len - 1].pci_target_address, 0x100000 + 12 * MB - write_len);
+    CHECK_EQ(instr[(12 * MB) / write_len].pci_target_address, 0x2000000);
+
+    ULONG irqs = 0;
+    ULONG counts = 0;
+
+    for (ULONG i = 0; i < count; i++)
+    {
+        CHECK_EQ(instr[i].byte_count, write_len);
+        irqs += instr[i].irq1;
+        counts += instr[i].cnt_ctl != 0;
+    }
+
+    // one count per gp_size unit, one interrupt per irq_period, the counter reset at the end
+    CHECK_EQ(counts, (16 * MB) / ring.gp_size);
+    CHECK_EQ(irqs, 8);
+    CHECK_EQ(instr[count - 1].cnt_ctl, 3);
+    CHECK_EQ(instr[count - 1].irq1, 1);
+
+    // the first buffer is full, the second holds the rest
+    CHECK_EQ(((PCX_RISC_INSTR_JUMP)(bufs[0].va + CX_RISC_BUF_SIZE - 12))->jump_address, bufs[1].addr + 4);
+
+    free(instr);
+    free_bufs(bufs, buf_count);
+}
+
+static void test_write_split(void)
+{
+    CX_RING ring;
+    CX_RISC_PROG prog;
+    ULONG write_len = 256;
+    ULONG count = (64 * MB) / write_len;
+    ULONG buf_count = cx_risc_buf_count(64 * MB, write_len);
+    PCX_RISC_BUF bufs = alloc_bufs(buf_count);
+    PCX_RISC_INSTR_WRITE instr = calloc(count, sizeof(CX_RISC_INSTR_WRITE));
+
+    CHECK(cx_ring_init(&ring, 64 * MB, 2 * MB));
+    cx_ring_set_irq_period(&ring, 2 * MB);
+
+    // 2 MB chunks of 8192 WRITEs, so no chunk lines up with a buffer
+    cx_risc_prog_begin(&prog, bufs, buf_count);
+
+    for (ULONG i = 0; i < ring.chunk_count; i++)
+    {
+        CHECK(cx_risc_prog_write(&prog, &ring, write_len, 0x10000000 + i * 4 * MB, ring.chunk_size));
+    }
+
+    cx_risc_prog_end(&prog);
+
+    CHECK_EQ(buf_count, 33);
+    CHECK_EQ(prog.buf_idx, buf_count - 1);
+    CHECK_EQ(run_prog(bufs, buf_count, instr, count), count);
+
+    // no WRITE is lost or doubled where a chunk carries on in the next buffer
+    for (ULONG i = 0; i < count; i++)
+    {
+        ULONG chunk_idx = i / (2 * MB / write_len);
+        ULONG off = (i % (2 * MB / write_len)) * write_len;
+
+        CHECK_EQ(instr[i].pci_target_address, 0x10000000 + chunk_idx * 4 * MB + off);
+    }
+
+    CHECK_EQ(instr[count - 1].cnt_ctl, 3);
+
+    // one buffer short and the program does not fit
+    cx_risc_prog_begin(&prog, bufs, buf_count - 1);
+    CHECK(!cx_risc_prog_write(&prog, &ring, write_len, 0x10000000, 64 * MB));
+
+    free(instr);
+    free_bufs(bufs, buf_count);
+}
+
+int main(void)
+{
+    test_sg_add();
+    test_sg_bounced();
+    test_buf_count();
+    test_write_sg();
+    test_write_split();
+
+    return cx_test_result("risc");
+}
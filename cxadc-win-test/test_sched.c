@@ -0,0 +1,195 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#include "test.h"
+
+#include "sched.h"
+
+#define MB (1024 * 1024)
+#define SIZE (64LL * MB)
+#define IRQ (2LL * MB)
+
+typedef struct _READ_STEP_CASE
+{
+    LONG64 write_pos;
+    LONG64 read_pos;
+    LONG64 done;
+    LONG64 remaining;
+    ULONG overrun_policy;
+    BOOLEAN is_capturing;
+    CX_READ_ACTION action;
+    LONG64 len;
+} READ_STEP_CASE;
+
+static const READ_STEP_CASE read_step_cases[] =
+{
+    // full, or stopped with nothing left to copy
+    { 100, 0, 1000, 0, CX_OVERRUN_POLICY_SKIP, TRUE, CX_READ_COMPLETE, 0 },
+    { 100, 100, 0, 1000, CX_OVERRUN_POLICY_SKIP, FALSE, CX_READ_COMPLETE, 0 },
+
+    // copies up to the head or what is left of the read
+    { 100, 0, 0, 1000, CX_OVERRUN_POLICY_SKIP, TRUE, CX_READ_COPY, 100 },
+    { 5000, 0, 0, 1000, CX_OVERRUN_POLICY_SKIP, TRUE, CX_READ_COPY, 1000 },
+    { 5000, 0, 0, 1000, CX_OVERRUN_POLICY_SKIP, FALSE, CX_READ_COPY, 1000 },
+
+    // waits at the head, or ahead of it
+    { 100, 100, 0, 1000, CX_OVERRUN_POLICY_SKIP, TRUE, CX_READ_WAIT, 0 },
+    { 100, 5000, 0, 1000, CX_OVERRUN_POLICY_SKIP, TRUE, CX_READ_WAIT, 0 },
+    { 100, 5000, 0, 1000, CX_OVERRUN_POLICY_SKIP, FALSE, CX_READ_COMPLETE, 0 },
+
+    // the oldest intact byte is still copied
+    { 2 * SIZE, SIZE + IRQ, 0, 1000, CX_OVERRUN_POLICY_FAIL, TRUE, CX_READ_COPY, 1000 },
+    { 2 * SIZE, SIZE + IRQ, 0, 2 * SIZE, CX_OVERRUN_POLICY_FAIL, TRUE, CX_READ_COPY, SIZE - IRQ },
+
+    // lapped by exactly the ring size, the period being filled is lost
+    { 2 * SIZE, SIZE, 0, 1000, CX_OVERRUN_POLICY_FAIL, TRUE, CX_READ_FAIL, IRQ },
+    { 2 * SIZE, SIZE, 0, 1000, CX_OVERRUN_POLICY_SKIP, TRUE, CX_READ_SKIP, IRQ },
+    { 2 * SIZE, SIZE, 0, 1000, CX_OVERRUN_POLICY_SHORT, TRUE, CX_READ_SKIP, IRQ },
+    { 2 * SIZE, SIZE, 10, 1000, CX_OVERRUN_POLICY_SHORT, TRUE, CX_READ_SHORT, IRQ },
+    { 2 * SIZE, SIZE, 10, 1000, CX_OVERRUN_POLICY_SKIP, TRUE, CX_READ_SKIP, IRQ },
+
+    // lapped by more, and still reported once the capture has stopped
+    { 10 * SIZE, 0, 0, 1000, CX_OVERRUN_POLICY_FAIL, TRUE, CX_READ_FAIL, 9 * SIZE + IRQ },
+    { 10 * SIZE, 0, 0, 1000, CX_OVERRUN_POLICY_SKIP, FALSE, CX_READ_SKIP, 9 * SIZE + IRQ },
+    { 10 * SIZE, 0, 10, 1000, CX_OVERRUN_POLICY_SHORT, FALSE, CX_READ_SHORT, 9 * SIZE + IRQ },
+};
+
+static CX_RING cx_test_ring(void)
+{
+    CX_RING ring;
+
+    CHECK(cx_ring_init(&ring, (ULONG)SIZE, 2 * MB));
+    cx_ring_set_irq_period(&ring, (ULONG)IRQ);
+
+    return ring;
+}
+
+static void test_read_step(void)
+{
+    CX_RING ring = cx_test_ring();
+
+    for (size_t i = 0; i < sizeof(read_step_cases) / sizeof(read_step_cases[0]); i++)
+    {
+        const READ_STEP_CASE* c = &read_step_cases[i];
+        LONG64 len = -1;
+
+        CX_READ_ACTION action = cx_read_step(&ring, c->write_pos, c->read_pos, c->done, c->remaining,
+            c->overrun_policy, c->is_capturing, &len);
+
+        if (action != c->action || len != c->len)
+        {
+            fprintf(stderr, "case %zu: action %d len %lld, expected action %d len %lld\n",
+                i, action, (long long)len, c->action, (long long)c->len);
+            cx_test_failures++;
+        }
+    }
+}
+
+// apply steps as the read work item does, until the read waits or completes
+static CX_READ_ACTION run_read(PCX_RING ring, LONG64 write_pos, PLONG64 read_pos, LONG64 req_len, ULONG policy, PLONG64 done)
+{
+    for (;;)
+    {
+        LONG64 len;
+        CX_READ_ACTION action = cx_read_step(ring, write_pos, *read_pos, *done, req_len - *done, policy, TRUE, &len);
+
+        *read_pos += len;
+
+        switch (action)
+        {
+        case CX_READ_COPY:
+            *done += len;
+            break;
+
+        case CX_READ_SKIP:
+            break;
+
+        default:
+            return action;
+        }
+    }
+}
+
+static void test_read_sequence(void)
+{
+    CX_RING ring = cx_test_ring();
+    LONG64 read_pos = 0;
+    LONG64 done = 0;
+
+    // a lapped SKIP read carries on from the oldest data and fills up
+    CHECK_EQ(run_read(&ring, 10 * SIZE, &read_pos, 3 * MB, CX_OVERRUN_POLICY_SKIP, &done), CX_READ_COMPLETE);
+    CHECK_EQ(done, 3 * MB);
+    CHECK_EQ(read_pos, 9 * SIZE + IRQ + 3 * MB);
+
+    // a read larger than what is there waits at the head with what it has
+    read_pos = 10 * SIZE - 100;
+    done = 0;
+    CHECK_EQ(run_read(&ring, 10 * SIZE, &read_pos, 1000, CX_OVERRUN_POLICY_SHORT, &done), CX_READ_WAIT);
+    CHECK_EQ(done, 100);
+    CHECK_EQ(read_pos, 10 * SIZE);
+
+    // lapped after that, SHORT completes with what came before the gap
+    CHECK_EQ(run_read(&ring, 12 * SIZE, &read_pos, 1000, CX_OVERRUN_POLICY_SHORT, &done), CX_READ_SHORT);
+    CHECK_EQ(done, 100);
+    CHECK_EQ(read_pos, 11 * SIZE + IRQ);
+}
+
+static void test_wake_pos(void)
+{
+    CX_RING ring = cx_test_ring();
+
+    // all of a read at once
+    CHECK_EQ(cx_read_wake_pos(&ring, 0, 1000), 1000);
+    CHECK_EQ(cx_read_wake_pos(&ring, 5 * SIZE + 7, SIZE / 2), 5 * SIZE + 7 + SIZE / 2);
+
+    // or half the ring of a larger one
+    CHECK_EQ(cx_read_wake_pos(&ring, 0, SIZE / 2 + 1), SIZE / 2);
+    CHECK_EQ(cx_read_wake_pos(&ring, 3 * SIZE, 4 * SIZE), 3 * SIZE + SIZE / 2);
+}
+
+static void test_wake(void)
+{
+    LONG64 write_pos = 1000;
+    LONG64 wake_pos = 0;
+
+    // a capture starts with wake_pos 0, the first publish always runs the work item
+    CHECK(cx_wake_due(&write_pos, &wake_pos));
+
+    // nothing is due until write_pos reaches the lowest parked read
+    CHECK(!cx_wake_set(&write_pos, &wake_pos, 5000));
+    CHECK_EQ(wake_pos, 5000);
+    write_pos = 4999;
+    CHECK(!cx_wake_due(&write_pos, &wake_pos));
+    write_pos = 5000;
+    CHECK(cx_wake_due(&write_pos, &wake_pos));
+
+    // a publish during the pass compared against the old wake_pos, the pass is repeated
+    wake_pos = 8000;
+    write_pos = 6000;
+    CHECK(!cx_wake_due(&write_pos, &wake_pos));
+    CHECK(cx_wake_set(&write_pos, &wake_pos, 6000));
+
+    // no parked reads
+    CHECK(!cx_wake_set(&write_pos, &wake_pos, INT64_MAX));
+    CHECK(!cx_wake_due(&write_pos, &wake_pos));
+}
+
+int main(void)
+{
+    test_read_step();
+    test_read_sequence();
+    test_wake_pos();
+    test_wake();
+
+    return cx_test_result("sched");
+}
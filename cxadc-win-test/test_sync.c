@@ -0,0 +1,169 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#include "test.h"
+
+#include "sync.h"
+
+typedef struct _FAKE_DEV
+{
+    BOOLEAN busy;
+    BOOLEAN armed;
+    BOOLEAN running;
+    LONG64 timestamp;
+} FAKE_DEV, *PFAKE_DEV;
+
+typedef struct _FAKE_CTX
+{
+    BOOLEAN in_window;
+    LONG64 clock;
+} FAKE_CTX, *PFAKE_CTX;
+
+static BOOLEAN fake_arm(PVOID ctx, PVOID dev)
+{
+    PFAKE_DEV d = dev;
+
+    CHECK(!((PFAKE_CTX)ctx)->in_window);
+
+    if (d->busy)
+    {
+        return FALSE;
+    }
+
+    d->armed = TRUE;
+    return TRUE;
+}
+
+static VOID fake_disarm(PVOID ctx, PVOID dev)
+{
+    (void)ctx;
+    ((PFAKE_DEV)dev)->armed = FALSE;
+}
+
+static VOID fake_begin(PVOID ctx)
+{
+    ((PFAKE_CTX)ctx)->in_window = TRUE;
+}
+
+static VOID fake_run(PVOID ctx, PVOID dev, PLONG64 timestamp, PULONG gp_cnt)
+{
+    PFAKE_CTX c = ctx;
+    PFAKE_DEV d = dev;
+
+    CHECK(c->in_window);
+    CHECK(d->armed);
+
+    d->running = TRUE;
+    *timestamp = c->clock += 10;
+    *gp_cnt = 0;
+}
+
+static VOID fake_end(PVOID ctx)
+{
+    ((PFAKE_CTX)ctx)->in_window = FALSE;
+}
+
+static CX_SYNC_OPS fake_ops =
+{
+    .arm = fake_arm,
+    .disarm = fake_disarm,
+    .begin = fake_begin,
+    .run = fake_run,
+    .end = fake_end
+};
+
+static void test_valid_list(void)
+{
+    ULONG devs[CX_SYNC_START_MAX_DEVICES + 1] = { 0, 1, 2, 3, 4, 5, 6, 7, 8 };
+
+    CHECK(cx_sync_valid_list(devs, 1));
+    CHECK(cx_sync_valid_list(devs, CX_SYNC_START_MAX_DEVICES));
+    CHECK(!cx_sync_valid_list(devs, 0));
+    CHECK(!cx_sync_valid_list(devs, CX_SYNC_START_MAX_DEVICES + 1));
+
+    devs[3] = 1;
+    CHECK(!cx_sync_valid_list(devs, 4));
+}
+
+static void test_lock_order(void)
+{
+    ULONG devs[] = { 5, 2, 7, 0, 3 };
+    ULONG order[5];
+
+    cx_sync_lock_order(devs, 5, order);
+
+    CHECK_EQ(order[0], 3);
+    CHECK_EQ(order[1], 1);
+    CHECK_EQ(order[2], 4);
+    CHECK_EQ(order[3], 0);
+    CHECK_EQ(order[4], 2);
+
+    // the same set listed in any order is locked in the same order
+    ULONG other[] = { 7, 3, 0, 5, 2 };
+    ULONG other_order[5];
+
+    cx_sync_lock_order(other, 5, other_order);
+
+    for (ULONG i = 0; i < 5; i++)
+    {
+        CHECK_EQ(other[other_order[i]], devs[order[i]]);
+    }
+}
+
+static void test_start(void)
+{
+    FAKE_CTX ctx = { 0 };
+    FAKE_DEV fake[3] = { 0 };
+    PVOID devs[3] = { &fake[0], &fake[1], &fake[2] };
+    CX_SYNC_START_CARD cards[3];
+
+    CHECK(cx_sync_start(&fake_ops, &ctx, devs, 3, cards));
+    CHECK(!ctx.in_window);
+
+    for (ULONG i = 0; i < 3; i++)
+    {
+        CHECK(fake[i].running);
+        CHECK_EQ(cards[i].timestamp, 10 * (i + 1));
+    }
+
+    CHECK_EQ(cx_sync_skew(cards, 3), 20);
+}
+
+static void test_start_busy(void)
+{
+    FAKE_CTX ctx = { 0 };
+    FAKE_DEV fake[3] = { 0 };
+    PVOID devs[3] = { &fake[0], &fake[1], &fake[2] };
+    CX_SYNC_START_CARD cards[3];
+
+    // the last device is busy, the others are disarmed and none is started
+    fake[2].busy = TRUE;
+
+    CHECK(!cx_sync_start(&fake_ops, &ctx, devs, 3, cards));
+
+    for (ULONG i = 0; i < 3; i++)
+    {
+        CHECK(!fake[i].armed);
+        CHECK(!fake[i].running);
+    }
+}
+
+int main(void)
+{
+    test_valid_list();
+    test_lock_order();
+    test_start();
+    test_start_busy();
+
+    return cx_test_result("sync");
+}
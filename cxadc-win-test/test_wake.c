@@ -0,0 +1,290 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#include <threads.h>
+
+#include "test.h"
+
+#include "sched.h"
+
+// the wake protocol run by threads standing in for the dpc, the read work item & readers
+// a publisher adds to write_pos & queues the work item once a parked read can be filled,
+// readers park reads that wait for a write_pos, the work item fills what it can & stores
+// the lowest write_pos left as wake_pos
+// every round ends with all threads but the work item stopped, once it is idle no parked read
+// may be one write_pos already reached, or the work item was never queued for it
+
+#define READERS 4
+#define ROUNDS 2000
+#define PUBLISHES 200
+#define PUBLISH_MAX 4096
+#define READ_MAX (16 * PUBLISH_MAX)
+
+typedef struct _WAKE_TEST
+{
+    LONG64 write_pos;
+    LONG64 wake_pos;
+
+    // work item, queued again if it is enqueued while it runs
+    mtx_t lock;
+    cnd_t cond;
+    int queued;
+    int running;
+    int quit;
+
+    // reads submitted but not yet seen by the work item, then parked by it
+    mtx_t inbox_lock;
+    LONG64 inbox[READERS];
+    LONG64 parked[READERS];
+    LONG64 outstanding[READERS];
+
+    int round;
+    LONG64 round_done;
+    long long publishes;
+    long long enqueues;
+    long long completed;
+} WAKE_TEST;
+
+static WAKE_TEST wake_test;
+
+static ULONG lcg_next(ULONG* state)
+{
+    *state = *state * 1103515245 + 12345;
+    return *state >> 8;
+}
+
+static void enqueue(void)
+{
+    mtx_lock(&wake_test.lock);
+    wake_test.queued = 1;
+    cnd_broadcast(&wake_test.cond);
+    mtx_unlock(&wake_test.lock);
+}
+
+// cx_evt_read_work, parked reads visited under what stands in for read_lock
+static void read_work(void)
+{
+    LONG64 wake_pos;
+
+    do
+    {
+        mtx_lock(&wake_test.inbox_lock);
+
+        for (int i = 0; i < READERS; i++)
+        {
+            if (wake_test.inbox[i])
+            {
+                wake_test.parked[i] = wake_test.inbox[i];
+                wake_test.inbox[i] = 0;
+            }
+        }
+
+        mtx_unlock(&wake_test.inbox_lock);
+
+        wake_pos = INT64_MAX;
+
+        for (int i = 0; i < READERS; i++)
+        {
+            if (!wake_test.parked[i])
+            {
+                continue;
+            }
+
+            if (wake_test.parked[i] <= InterlockedCompareExchange64(&wake_test.write_pos, 0, 0))
+            {
+                wake_test.parked[i] = 0;
+                wake_test.completed++;
+                InterlockedExchange64(&wake_test.outstanding[i], 0);
+                continue;
+            }
+
+            wake_pos = min(wake_pos, wake_test.parked[i]);
+        }
+
+        // a pass of the driver takes a while copying & completing reads, publishers run meanwhile
+        thrd_yield();
+    } while (cx_wake_set(&wake_test.write_pos, &wake_test.wake_pos, wake_pos));
+}
+
+static int worker(void* arg)
+{
+    (void)arg;
+
+    mtx_lock(&wake_test.lock);
+
+    while (TRUE)
+    {
+        while (!wake_test.queued && !wake_test.quit)
+        {
+            cnd_wait(&wake_test.cond, &wake_test.lock);
+        }
+
+        if (!wake_test.queued)
+        {
+            break;
+        }
+
+        wake_test.queued = 0;
+        wake_test.running = 1;
+        mtx_unlock(&wake_test.lock);
+
+        read_work();
+
+        mtx_lock(&wake_test.lock);
+        wake_test.running = 0;
+        cnd_broadcast(&wake_test.cond);
+    }
+
+    mtx_unlock(&wake_test.lock);
+    return 0;
+}
+
+// the dpc or poll tick
+static int publisher(void* arg)
+{
+    ULONG seed = (ULONG)(uintptr_t)arg;
+
+    for (int i = 0; i < PUBLISHES; i++)
+    {
+        InterlockedAdd64(&wake_test.write_pos, 1 + lcg_next(&seed) % PUBLISH_MAX);
+        wake_test.publishes++;
+
+        if (cx_wake_due(&wake_test.write_pos, &wake_test.wake_pos))
+        {
+            wake_test.enqueues++;
+            enqueue();
+        }
+
+        if (!(i % 16))
+        {
+            thrd_yield();
+        }
+    }
+
+    InterlockedExchange64(&wake_test.round_done, 1);
+    return 0;
+}
+
+// a handle with one read outstanding, the next is issued as soon as it completes
+static int reader(void* arg)
+{
+    int idx = (int)(uintptr_t)arg;
+    ULONG seed = (ULONG)idx * 7919 + (ULONG)wake_test.round;
+
+    while (!InterlockedCompareExchange64(&wake_test.round_done, 0, 0))
+    {
+        if (InterlockedCompareExchange64(&wake_test.outstanding[idx], 0, 0))
+        {
+            thrd_yield();
+            continue;
+        }
+
+        InterlockedExchange64(&wake_test.outstanding[idx], 1);
+
+        mtx_lock(&wake_test.inbox_lock);
+        wake_test.inbox[idx] = InterlockedCompareExchange64(&wake_test.write_pos, 0, 0) + 1 + lcg_next(&seed) % READ_MAX;
+        mtx_unlock(&wake_test.inbox_lock);
+
+        // a new read always queues the work item itself
+        enqueue();
+    }
+
+    return 0;
+}
+
+static void wait_idle(void)
+{
+    mtx_lock(&wake_test.lock);
+
+    while (wake_test.queued || wake_test.running)
+    {
+        cnd_wait(&wake_test.cond, &wake_test.lock);
+    }
+
+    mtx_unlock(&wake_test.lock);
+}
+
+static void test_stress(void)
+{
+    thrd_t work_thread;
+    thrd_t pub_thread;
+    thrd_t reader_threads[READERS];
+    long long missed = 0;
+    long long wrong_wake_pos = 0;
+
+    mtx_init(&wake_test.lock, mtx_plain);
+    mtx_init(&wake_test.inbox_lock, mtx_plain);
+    cnd_init(&wake_test.cond);
+
+    CHECK(thrd_create(&work_thread, worker, NULL) == thrd_success);
+
+    for (int round = 0; round < ROUNDS; round++)
+    {
+        wake_test.round = round;
+        wake_test.round_done = 0;
+
+        for (int i = 0; i < READERS; i++)
+        {
+            CHECK(thrd_create(&reader_threads[i], reader, (void*)(uintptr_t)i) == thrd_success);
+        }
+
+        CHECK(thrd_create(&pub_thread, publisher, (void*)(uintptr_t)(round + 1)) == thrd_success);
+
+        thrd_join(pub_thread, NULL);
+
+        for (int i = 0; i < READERS; i++)
+        {
+            thrd_join(reader_threads[i], NULL);
+        }
+
+        wait_idle();
+
+        // every read that arrived was moved over by the work item it queued
+        LONG64 write_pos = wake_test.write_pos;
+        LONG64 lowest = INT64_MAX;
+
+        for (int i = 0; i < READERS; i++)
+        {
+            CHECK_EQ(wake_test.inbox[i], 0);
+
+            if (wake_test.parked[i])
+            {
+                missed += wake_test.parked[i] <= write_pos;
+                lowest = min(lowest, wake_test.parked[i]);
+            }
+        }
+
+        wrong_wake_pos += wake_test.wake_pos != lowest;
+    }
+
+    mtx_lock(&wake_test.lock);
+    wake_test.quit = 1;
+    cnd_broadcast(&wake_test.cond);
+    mtx_unlock(&wake_test.lock);
+
+    thrd_join(work_thread, NULL);
+
+    CHECK_EQ(missed, 0);
+    CHECK_EQ(wrong_wake_pos, 0);
+
+    // reads were filled, and publishes that could not fill one left the work item alone
+    CHECK(wake_test.completed > ROUNDS);
+    CHECK(wake_test.enqueues < wake_test.publishes);
+}
+
+int main(void)
+{
+    test_stress();
+
+    return cx_test_result("wake");
+}
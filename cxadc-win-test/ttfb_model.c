@@ -0,0 +1,304 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "portable.h"
+#include "risc.h"
+#include "sched.h"
+
+// time to first byte of a read on a fresh capture vs one kept alive, on a simulated device, not run by ctest
+// a fresh capture allocates the ring & builds its program (cold) or finds it kept by ring_release (warm),
+// starts, and its first interrupt or poll tick only sets the stream start, see cx_publish_gp_cnt, so the
+// read at position 0 is filled by the ones after
+// a capture kept alive has run all along, the reader arrives at a random time & cx_ring_join_pos puts the
+// read at the head, or read len behind it where the data is already there
+// interrupts come every irq_period & poll ticks every poll period, each late by an exponentially distributed
+// dpc latency, and gp_cnt is read then as cx_evt_dpc & cx_evt_poll_timer do, reads are filled with
+// cx_read_step as in read_model
+// the allocation is the simulated one of bench_alloc, a lower bound, the driver reports the real time in
+// ring_alloc_time, register writes to start the engine are left out
+//
+//   ttfb_model [MB/s, default 28.6] [irq_period kbytes, default 2048] [poll rate, default 0]
+//              [read kbytes, default 64] [mean dpc latency us, default 100] [trials, default 1000]
+
+#define MB (1024 * 1024)
+#define CHUNK_SIZE (2 * MB)
+#define CDT_LEN 2048
+#define WARM_UP 1.0
+
+typedef struct _SIM
+{
+    CX_RING ring;
+    double rate;
+    double dpc_mean;
+    double poll_period;
+    LONG64 read_len;
+    ULONG64 state;
+} SIM;
+
+static double now(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// xorshift64*, uniform in (0, 1)
+static double uniform(ULONG64* state)
+{
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return ((*state * 2685821657736338717ULL >> 11) + 0.5) / 9007199254740992.0;
+}
+
+static int compare(const void* a, const void* b)
+{
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// cx_ensure_ring on a released ring, best of a few runs, see bench_alloc
+static double setup_time(ULONG ring_size)
+{
+    double best = 0;
+
+    for (int pass = 0; pass < 5; pass++)
+    {
+        CX_RING ring;
+        CX_RISC_PROG prog;
+        ULONG next_addr = 0x10000000;
+
+        double start = now();
+
+        ULONG buf_count = cx_risc_buf_count(ring_size, CDT_LEN);
+        PCX_RISC_BUF bufs = calloc(buf_count, sizeof(CX_RISC_BUF));
+
+        for (ULONG i = 0; i < buf_count; i++)
+        {
+            bufs[i].addr = next_addr;
+            bufs[i].va = malloc(CX_RISC_BUF_SIZE);
+            next_addr += CX_RISC_BUF_SIZE;
+        }
+
+        cx_ring_init(&ring, ring_size, CHUNK_SIZE);
+        cx_ring_set_irq_period(&ring, CX_IOCTL_IRQ_PERIOD_DEFAULT);
+        cx_risc_prog_begin(&prog, bufs, buf_count);
+
+        for (ULONG i = 0; i < ring.chunk_count; i++)
+        {
+            cx_risc_prog_write(&prog, &ring, CDT_LEN, next_addr, CHUNK_SIZE);
+            next_addr += CHUNK_SIZE;
+        }
+
+        cx_risc_prog_end(&prog);
+
+        double time = now() - start;
+
+        if (!pass || time < best)
+        {
+            best = time;
+        }
+
+        for (ULONG i = 0; i < buf_count; i++)
+        {
+            free(bufs[i].va);
+        }
+
+        free(bufs);
+    }
+
+    return best;
+}
+
+// gp_cnt the engine has reached t seconds into the capture
+static LONG gp_cnt_at(SIM* sim, double t)
+{
+    return (LONG)((ULONG64)(t * sim->rate) / sim->ring.gp_size % (sim->ring.size / sim->ring.gp_size));
+}
+
+// cx_read_ready & cx_service_read for the one read, TRUE once it completes
+static BOOLEAN fill(SIM* sim, LONG64 write_pos, PLONG64 read_pos, PLONG64 done)
+{
+    CX_READ_ACTION action;
+    LONG64 len;
+
+    if (write_pos < cx_read_wake_pos(&sim->ring, *read_pos, sim->read_len - *done))
+    {
+        return FALSE;
+    }
+
+    do
+    {
+        action = cx_read_step(&sim->ring, write_pos, *read_pos, *done, sim->read_len - *done,
+            CX_OVERRUN_POLICY_SKIP, TRUE, &len);
+
+        if (action == CX_READ_COPY)
+        {
+            *done += len;
+        }
+
+        *read_pos += len;
+    } while (action == CX_READ_COPY || action == CX_READ_SKIP);
+
+    return action != CX_READ_WAIT;
+}
+
+// replay a capture started at time 0 until the read completes, returns when it did
+// a fresh capture is read from its start, otherwise the reader arrives at arrival & joins behind the head
+static double replay(SIM* sim, BOOLEAN fresh, double arrival, LONG64 behind)
+{
+    LONG64 write_pos = 0;
+    LONG64 read_pos = fresh ? 0 : -1;
+    LONG64 done = 0;
+    LONG initial_page = -1;
+    LONG last_gp_cnt = 0;
+    double t = 0;
+
+    for (ULONG64 k = 1; ; k++)
+    {
+        double latency = -log(uniform(&sim->state)) * sim->dpc_mean;
+
+        // dpcs run in order, a poll tick is re-armed for a period after the last one ran
+        t = sim->poll_period ?
+            t + sim->poll_period + latency :
+            max(t, (double)k * sim->ring.irq_period / sim->rate + latency);
+
+        if (read_pos < 0 && t > arrival)
+        {
+            read_pos = cx_ring_join_pos(&sim->ring, write_pos, CX_READ_ORIGIN_HEAD, behind);
+
+            if (fill(sim, write_pos, &read_pos, &done))
+            {
+                return arrival;
+            }
+        }
+
+        // cx_publish_gp_cnt
+        LONG gp_cnt = sim->poll_period ?
+            cx_ring_gp_poll(&sim->ring, initial_page < 0 ? -1 : last_gp_cnt, gp_cnt_at(sim, t)) :
+            cx_ring_gp_round(&sim->ring, gp_cnt_at(sim, t));
+
+        if (initial_page < 0)
+        {
+            initial_page = gp_cnt;
+            write_pos = 0;
+        }
+        else
+        {
+            write_pos += cx_ring_gp_delta(&sim->ring, last_gp_cnt, gp_cnt);
+        }
+
+        last_gp_cnt = gp_cnt;
+
+        if (read_pos >= 0 && fill(sim, write_pos, &read_pos, &done))
+        {
+            return t;
+        }
+    }
+}
+
+static void report(const char* name, double setup, double* ttfb, int trials)
+{
+    qsort(ttfb, trials, sizeof(double), compare);
+
+    printf("%-28s %9.3f %9.3f %9.3f %9.3f %9.3f\n", name, setup * 1e3,
+        ttfb[trials / 2] * 1e3, ttfb[trials * 9 / 10] * 1e3, ttfb[trials * 99 / 100] * 1e3, ttfb[trials - 1] * 1e3);
+}
+
+int main(int argc, char** argv)
+{
+    double rate = (argc > 1 ? atof(argv[1]) : 28.6) * 1e6;
+    ULONG irq_period = (argc > 2 ? strtoul(argv[2], NULL, 10) : 2048) * 1024;
+    ULONG poll_rate = argc > 3 ? strtoul(argv[3], NULL, 10) : 0;
+    LONG64 read_len = (argc > 4 ? strtoll(argv[4], NULL, 10) : 64) * 1024;
+    double dpc_mean = (argc > 5 ? atof(argv[5]) : 100) / 1e6;
+    int trials = argc > 6 ? atoi(argv[6]) : 1000;
+
+    if (rate <= 0 || !irq_period || (irq_period & (irq_period - 1)) ||
+        (poll_rate && (poll_rate < CX_IOCTL_POLL_RATE_MIN || poll_rate > CX_IOCTL_POLL_RATE_MAX)) ||
+        read_len <= 0 || read_len > CX_IOCTL_RING_SIZE_DEFAULT / 2 || dpc_mean < 0 || trials < 1)
+    {
+        fprintf(stderr, "usage: ttfb_model [MB/s] [irq_period kbytes, power of 2] [poll rate, 0 or 50-10000] "
+            "[read kbytes, up to half the ring] [mean dpc latency us] [trials]\n");
+        return EXIT_FAILURE;
+    }
+
+    SIM sim = {
+        .rate = rate,
+        .dpc_mean = dpc_mean,
+        .poll_period = poll_rate ? 1.0 / poll_rate : 0,
+        .read_len = read_len,
+        .state = 0x9E3779B97F4A7C15ULL
+    };
+
+    cx_ring_init(&sim.ring, CX_IOCTL_RING_SIZE_DEFAULT, CHUNK_SIZE);
+    cx_ring_set_irq_period(&sim.ring, irq_period);
+    cx_ring_set_poll_rate(&sim.ring, poll_rate);
+
+    double alloc_time = setup_time(CX_IOCTL_RING_SIZE_DEFAULT);
+    double* ttfb = malloc(trials * sizeof(double));
+
+    printf("%.1f MB/s, ", rate / 1e6);
+
+    if (poll_rate)
+    {
+        printf("polled %u/s, ", poll_rate);
+    }
+    else
+    {
+        printf("%u KB irq_period, ", sim.ring.irq_period / 1024);
+    }
+
+    printf("%lld KB read, %g us mean dpc latency, %u MB ring, %d trials\n\n",
+        (long long)(read_len / 1024), dpc_mean * 1e6, CX_IOCTL_RING_SIZE_DEFAULT / MB, trials);
+    printf("%-28s %9s %9s %9s %9s %9s\n", "", "setup ms", "p50 ms", "p90 ms", "p99 ms", "max ms");
+
+    for (int i = 0; i < trials; i++)
+    {
+        ttfb[i] = alloc_time + replay(&sim, TRUE, 0, 0);
+    }
+
+    report("fresh, ring allocated", alloc_time, ttfb, trials);
+
+    for (int i = 0; i < trials; i++)
+    {
+        ttfb[i] = replay(&sim, TRUE, 0, 0);
+    }
+
+    report("fresh, ring kept", 0, ttfb, trials);
+
+    for (int i = 0; i < trials; i++)
+    {
+        double arrival = WARM_UP + uniform(&sim.state);
+        ttfb[i] = replay(&sim, FALSE, arrival, 0) - arrival;
+    }
+
+    report("kept alive, at the head", 0, ttfb, trials);
+
+    for (int i = 0; i < trials; i++)
+    {
+        double arrival = WARM_UP + uniform(&sim.state);
+        ttfb[i] = replay(&sim, FALSE, arrival, read_len) - arrival;
+    }
+
+    report("kept alive, read behind head", 0, ttfb, trials);
+
+    free(ttfb);
+    return EXIT_SUCCESS;
+}
@@ -18,21 +18,98 @@ public class Cxadc : IDisposable
 {
     public const uint CX_IOCTL_GET_CAPTURE_STATE = 0x800;
     public const uint CX_IOCTL_GET_OUFLOW_COUNT = 0x810;
+    public const uint CX_IOCTL_GET_READER_STATS = 0x811;
+    public const uint CX_IOCTL_GET_OVERRUN_POLICY = 0x812;
+    public const uint CX_IOCTL_GET_READ_MODE = 0x813;
+    public const uint CX_IOCTL_GET_STATS = 0x814;
+    public const uint CX_IOCTL_GET_LATENCY = 0x815;
+    public const uint CX_IOCTL_GET_READ_FORMAT = 0x816;
+    public const uint CX_IOCTL_GET_EVENTS = 0x817;
+    public const uint CX_IOCTL_GET_WAIT_POLICY = 0x818;
+    public const uint CX_IOCTL_GET_AVAILABLE = 0x819;
     public const uint CX_IOCTL_GET_VMUX = 0x821;
     public const uint CX_IOCTL_GET_LEVEL = 0x822;
     public const uint CX_IOCTL_GET_TENBIT = 0x823;
     public const uint CX_IOCTL_GET_SIXDB = 0x824;
     public const uint CX_IOCTL_GET_CENTER_OFFSET = 0x825;
+    public const uint CX_IOCTL_GET_IRQ_PERIOD = 0x826;
+    public const uint CX_IOCTL_GET_CONFIG = 0x827;
+    public const uint CX_IOCTL_GET_POLL_RATE = 0x828;
+    public const uint CX_IOCTL_GET_KEEP_ALIVE = 0x829;
     public const uint CX_IOCTL_GET_BUS_NUMBER = 0x830;
     public const uint CX_IOCTL_GET_DEVICE_ADDRESS = 0x831;
+    public const uint CX_IOCTL_GET_RING_SIZE = 0x840;
+    public const uint CX_IOCTL_GET_FIFO_GEOMETRY = 0x841;
+    public const uint CX_IOCTL_GET_RING_RELEASE = 0x842;
     public const uint CX_IOCTL_GET_REGISTER = 0x82F;
     public const uint CX_IOCTL_RESET_OUFLOW_COUNT = 0x910;
+    public const uint CX_IOCTL_RESET_READER_STATS = 0x911;
+    public const uint CX_IOCTL_SET_OVERRUN_POLICY = 0x912;
+    public const uint CX_IOCTL_SET_READ_MODE = 0x913;
+    public const uint CX_IOCTL_RESET_STATS = 0x914;
+    public const uint CX_IOCTL_RESET_LATENCY = 0x915;
+    public const uint CX_IOCTL_SET_READ_FORMAT = 0x916;
+    public const uint CX_IOCTL_SET_READ_POSITION = 0x917;
+    public const uint CX_IOCTL_SET_WAIT_POLICY = 0x918;
     public const uint CX_IOCTL_SET_VMUX = 0x921;
     public const uint CX_IOCTL_SET_LEVEL = 0x922;
     public const uint CX_IOCTL_SET_TENBIT = 0x923;
     public const uint CX_IOCTL_SET_SIXDB = 0x924;
     public const uint CX_IOCTL_SET_CENTER_OFFSET = 0x925;
+    public const uint CX_IOCTL_SET_IRQ_PERIOD = 0x926;
+    public const uint CX_IOCTL_SET_CONFIG = 0x927;
+    public const uint CX_IOCTL_SET_POLL_RATE = 0x928;
+    public const uint CX_IOCTL_SET_KEEP_ALIVE = 0x929;
     public const uint CX_IOCTL_SET_REGISTER = 0x92F;
+    public const uint CX_IOCTL_SET_RING_SIZE = 0x940;
+    public const uint CX_IOCTL_SET_RING_RELEASE = 0x942;
+    public const uint CX_IOCTL_SYNC_START = 0xA10;
+    public const uint CX_IOCTL_REGISTER_PROGRAM = 0xA20;
+
+    public const uint CX_OVERRUN_POLICY_FAIL = 0;
+    public const uint CX_OVERRUN_POLICY_SKIP = 1;
+    public const uint CX_OVERRUN_POLICY_SHORT = 2;
+
+    public const uint CX_READER_STATS_SIZE = 48;
+    public const uint CX_STATS_SIZE = 96;
+    public const uint CX_CONFIG_SIZE = 68;
+    public const uint CX_FIFO_GEOMETRY_SIZE = 20;
+    public const uint CX_AVAILABLE_SIZE = 40;
+
+    public const int CX_EVENT_RING_SIZE = 256;
+    public const int CX_EVENT_SIZE = 32;
+    public const uint CX_EVENTS_SIZE = 24 + CX_EVENT_RING_SIZE * CX_EVENT_SIZE;
+    public const uint CX_EVENT_FIFO_OVERFLOW = 0x00000001;
+    public const uint CX_EVENT_SYNC_ERROR = 0x00000002;
+    public const uint CX_EVENT_OPCODE_ERROR = 0x00000004;
+
+    public const int CX_LATENCY_BUCKETS = 32;
+    public const int CX_LATENCY_STAGES = 4;
+    public const uint CX_LATENCY_SIZE = 16 + CX_LATENCY_STAGES * CX_LATENCY_BUCKETS * 8;
+
+    public const uint CX_READ_MODE_RAW = 0;
+    public const uint CX_READ_MODE_FRAMED = 1;
+    public const uint CX_READ_MODE_POSITIONAL = 2;
+
+    public const uint CX_READ_FORMAT_RAW = 0;
+    public const uint CX_READ_FORMAT_PACKED10 = 1;
+
+    public const uint CX_READ_ORIGIN_START = 0;
+    public const uint CX_READ_ORIGIN_HEAD = 1;
+    public const uint CX_READ_ORIGIN_TIME = 2;
+
+    public const uint CX_WAIT_POLICY_FULL = 0;
+    public const uint CX_WAIT_POLICY_NONE = 1;
+
+    public const int CX_SYNC_START_MAX_DEVICES = 8;
+    public const uint CX_SYNC_START_RESULT_SIZE = 24 + CX_SYNC_START_MAX_DEVICES * 16;
+
+    public const uint CX_REG_OP_READ = 0;
+    public const uint CX_REG_OP_WRITE = 1;
+    public const uint CX_REG_OP_MODIFY = 2;
+    public const uint CX_REG_OP_POLL = 3;
+    public const int CX_REG_OP_SIZE = 16;
+    public const int CX_REG_PROGRAM_MAX_OPS = 1024;
 
     const uint FILE_DEVICE_UNKNOWN = 0x00000022;
     const uint METHOD_BUFFERED = 0;
@@ -98,38 +175,7 @@ public class Cxadc : IDisposable
 
     public byte[] Get(uint code, uint len, byte[] data)
     {
-        uint bytesRead = 0;
-        byte[] ret;
-
-        unsafe
-        {
-            var outBuffer = Marshal.AllocHGlobal((int)len);
-            var inBuffer = Marshal.AllocHGlobal(data.Length);
-            Marshal.Copy(data, 0, inBuffer, data.Length);
-
-            PInvoke.DeviceIoControl(
-                this._handle,
-                GetCtlCode(code, FILE_READ_DATA),
-                inBuffer.ToPointer(),
-                (uint)data.Length,
-                outBuffer.ToPointer(),
-                len,
-                &bytesRead,
-                null);
-
-            var err = Marshal.GetLastWin32Error();
-            var errStr = new Win32Exception(err).Message;
-
-            if (err != 0)
-            {
-                throw new Exception($"Get failed: {errStr}");
-            }
-
-            ret = new byte[bytesRead];
-            Marshal.Copy(outBuffer, ret, 0, (int)bytesRead);
-        }
-
-        return ret;
+        return Ioctl(code, FILE_READ_DATA, len, data, "Get");
     }
 
     public void Set(uint code, uint value)
@@ -141,31 +187,77 @@ public class Cxadc : IDisposable
     }
 
     public void Set(uint code, byte[] data)
+    {
+        Ioctl(code, FILE_WRITE_DATA, 0, data, "Set");
+    }
+
+    // run ops in one CX_IOCTL_REGISTER_PROGRAM call, returns the READ/MODIFY/POLL values and the ops run
+    public (uint[] Values, uint Done) RunRegisterProgram(IReadOnlyList<CxRegOp> ops, uint pollTimeout = 0)
+    {
+        var data = new byte[8 + ops.Count * CX_REG_OP_SIZE];
+        BinaryPrimitives.WriteUInt32LittleEndian(data, (uint)ops.Count);
+        BinaryPrimitives.WriteUInt32LittleEndian(data.AsSpan()[4..], pollTimeout);
+
+        for (var i = 0; i < ops.Count; i++)
+        {
+            var op = data.AsSpan()[(8 + i * CX_REG_OP_SIZE)..];
+            BinaryPrimitives.WriteUInt32LittleEndian(op, ops[i].Op);
+            BinaryPrimitives.WriteUInt32LittleEndian(op[4..], ops[i].Address);
+            BinaryPrimitives.WriteUInt32LittleEndian(op[8..], ops[i].Mask);
+            BinaryPrimitives.WriteUInt32LittleEndian(op[12..], ops[i].Value);
+        }
+
+        var valueCount = ops.Count(op => op.Op != CX_REG_OP_WRITE);
+        var result = Ioctl(CX_IOCTL_REGISTER_PROGRAM, FILE_READ_DATA | FILE_WRITE_DATA, (uint)(8 + valueCount * 4), data, "Register program");
+        var values = new uint[BinaryPrimitives.ReadUInt32LittleEndian(result.AsSpan()[4..])];
+
+        for (var i = 0; i < values.Length; i++)
+        {
+            values[i] = BinaryPrimitives.ReadUInt32LittleEndian(result.AsSpan()[(8 + i * 4)..]);
+        }
+
+        return (values, BinaryPrimitives.ReadUInt32LittleEndian(result));
+    }
+
+    byte[] Ioctl(uint code, uint access, uint len, byte[] data, string name)
     {
         uint bytesRead = 0;
+        var outBuffer = Marshal.AllocHGlobal((int)len);
+        var inBuffer = Marshal.AllocHGlobal(data.Length);
 
-        unsafe
+        try
         {
-            var inBuffer = Marshal.AllocHGlobal(data.Length);
             Marshal.Copy(data, 0, inBuffer, data.Length);
 
-            PInvoke.DeviceIoControl(
-                this._handle,
-                GetCtlCode(code, FILE_WRITE_DATA),
-                inBuffer.ToPointer(),
-                (uint)data.Length,
-                null,
-                0,
-                &bytesRead,
-                null);
+            unsafe
+            {
+                PInvoke.DeviceIoControl(
+                    this._handle,
+                    GetCtlCode(code, access),
+                    data.Length > 0 ? inBuffer.ToPointer() : null,
+                    (uint)data.Length,
+                    len > 0 ? outBuffer.ToPointer() : null,
+                    len,
+                    &bytesRead,
+                    null);
+            }
 
             var err = Marshal.GetLastWin32Error();
             var errStr = new Win32Exception(err).Message;
 
             if (err != 0)
             {
-                throw new Exception($"Set failed: {errStr}");
+                throw new Exception($"{name} failed: {errStr}");
             }
+
+            var ret = new byte[bytesRead];
+            Marshal.Copy(outBuffer, ret, 0, (int)bytesRead);
+            return ret;
+        }
+        finally
+        {
+            Marshal.FreeHGlobal(outBuffer);
+            Marshal.FreeHGlobal(inBuffer);
         }
     }
 
@@ -200,3 +292,5 @@ public class Cxadc : IDisposable
         return FILE_DEVICE_UNKNOWN << 16 | method << 14 | function << 2 | METHOD_BUFFERED;
     }
 }
+
+public record struct CxRegOp(uint Op, uint Address, uint Mask = 0, uint Value = 0);
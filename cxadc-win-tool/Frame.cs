@@ -0,0 +1,146 @@
+﻿// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win-tool - Example tool for using the cxadc-win driver
+ *
+ * Copyright (C) 2024 Jitterbug
+ */
+
+using System.Buffers.Binary;
+
+namespace cxadc_win_tool;
+
+// CX_FRAME_HEADER, see public.h for the format
+public readonly record struct FrameHeader(
+    uint Magic,
+    ushort Version,
+    ushort HeaderSize,
+    uint DataSize,
+    uint Flags,
+    ulong Sequence,
+    long BlockPos,
+    long StreamPos,
+    uint BlockSize,
+    uint GpCnt,
+    long Timestamp,
+    long TimestampFreq,
+    int Vmux,
+    int Level,
+    int Tenbit,
+    int Sixdb,
+    int CenterOffset,
+    uint IrqPeriod)
+{
+    public const uint MAGIC = 0x52465843;
+    public const ushort VERSION = 1;
+    public const int SIZE = 88;
+
+    public const uint FLAG_OUFLOW = 0x1;
+    public const uint FLAG_GAP = 0x2;
+    public const uint FLAG_NO_INFO = 0x4;
+
+    public static FrameHeader Parse(ReadOnlySpan<byte> buf)
+    {
+        return new FrameHeader(
+            BinaryPrimitives.ReadUInt32LittleEndian(buf),
+            BinaryPrimitives.ReadUInt16LittleEndian(buf[4..]),
+            BinaryPrimitives.ReadUInt16LittleEndian(buf[6..]),
+            BinaryPrimitives.ReadUInt32LittleEndian(buf[8..]),
+            BinaryPrimitives.ReadUInt32LittleEndian(buf[12..]),
+            BinaryPrimitives.ReadUInt64LittleEndian(buf[16..]),
+            BinaryPrimitives.ReadInt64LittleEndian(buf[24..]),
+            BinaryPrimitives.ReadInt64LittleEndian(buf[32..]),
+            BinaryPrimitives.ReadUInt32LittleEndian(buf[40..]),
+            BinaryPrimitives.ReadUInt32LittleEndian(buf[44..]),
+            BinaryPrimitives.ReadInt64LittleEndian(buf[48..]),
+            BinaryPrimitives.ReadInt64LittleEndian(buf[56..]),
+            BinaryPrimitives.ReadInt32LittleEndian(buf[64..]),
+            BinaryPrimitives.ReadInt32LittleEndian(buf[68..]),
+            BinaryPrimitives.ReadInt32LittleEndian(buf[72..]),
+            BinaryPrimitives.ReadInt32LittleEndian(buf[76..]),
+            BinaryPrimitives.ReadInt32LittleEndian(buf[80..]),
+            BinaryPrimitives.ReadUInt32LittleEndian(buf[84..]));
+    }
+
+    public bool IsValid => Magic == MAGIC && Version == VERSION && HeaderSize >= SIZE;
+}
+
+// walks a framed capture and checks that the frames are well formed and contiguous
+public class FrameValidator
+{
+    public long Frames { get; private set; }
+    public long DataBytes { get; private set; }
+    public long Gaps { get; private set; }
+    public long BytesLost { get; private set; }
+    public long OuflowBlocks { get; private set; }
+    public long Errors { get; private set; }
+    public long FirstTimestamp { get; private set; }
+    public long LastTimestamp { get; private set; }
+    public long TimestampFreq { get; private set; }
+
+    private long _nextPos = -1;
+    private ulong _lastOuflowSeq = ulong.MaxValue;
+
+    // returns the bytes consumed, 0 if buf does not hold a whole frame
+    public int Feed(ReadOnlySpan<byte> buf, Action<string>? error = null)
+    {
+        if (buf.Length < FrameHeader.SIZE)
+        {
+            return 0;
+        }
+
+        var hdr = FrameHeader.Parse(buf);
+
+        if (!hdr.IsValid)
+        {
+            throw new InvalidDataException($"bad frame header at frame {Frames}");
+        }
+
+        if (buf.Length < hdr.HeaderSize + hdr.DataSize)
+        {
+            return 0;
+        }
+
+        if (_nextPos >= 0 && hdr.StreamPos != _nextPos)
+        {
+            if ((hdr.Flags & FrameHeader.FLAG_GAP) != 0 && hdr.StreamPos > _nextPos)
+            {
+                Gaps++;
+                BytesLost += hdr.StreamPos - _nextPos;
+            }
+            else
+            {
+                Errors++;
+                error?.Invoke($"frame {Frames}: stream_pos {hdr.StreamPos}, expected {_nextPos}");
+            }
+        }
+
+        if ((hdr.Flags & FrameHeader.FLAG_NO_INFO) == 0)
+        {
+            if (hdr.StreamPos < hdr.BlockPos || hdr.StreamPos + hdr.DataSize > hdr.BlockPos + hdr.BlockSize)
+            {
+                Errors++;
+                error?.Invoke($"frame {Frames}: data outside of block {hdr.Sequence}");
+            }
+
+            if ((hdr.Flags & FrameHeader.FLAG_OUFLOW) != 0 && hdr.Sequence != _lastOuflowSeq)
+            {
+                OuflowBlocks++;
+                _lastOuflowSeq = hdr.Sequence;
+            }
+
+            if (FirstTimestamp == 0)
+            {
+                FirstTimestamp = hdr.Timestamp;
+            }
+
+            LastTimestamp = hdr.Timestamp;
+            TimestampFreq = hdr.TimestampFreq;
+        }
+
+        _nextPos = hdr.StreamPos + hdr.DataSize;
+        Frames++;
+        DataBytes += hdr.DataSize;
+
+        return (int)(hdr.HeaderSize + hdr.DataSize);
+    }
+}
@@ -15,9 +15,15 @@ const uint MAX_CARDS = byte.MaxValue;
 
 Cxadc? cx = null;
 Clockgen? clockgen = null;
+var captureStats = false;
 
 Console.CancelKeyPress += (sender, e) =>
 {
+    if (cx != null && captureStats)
+    {
+        PrintReaderStats(cx);
+    }
+
     cx?.Dispose();
     clockgen?.Dispose();
 };
@@ -28,18 +34,61 @@ var inputDeviceArg = new Argument<string>(name: "device", description: "device p
 
 // capture command
 var captureOutputArg = new Argument<string>(name: "output", description: "output path (- for STDOUT)");
+var captureOverrunOption = new Option<string>(name: "--overrun", description: "what a read does when the capture laps it",
+    getDefaultValue: () => "skip").FromAmong("fail", "skip", "short");
+var captureStatsOption = new Option<bool>(name: "--stats", description: "print reader stats to STDERR on exit");
+var captureFramedOption = new Option<bool>(name: "--framed", description: "prefix each block with a frame header");
+var capturePackedOption = new Option<bool>(name: "--packed", description: "pack tenbit samples, 4 per 5 bytes (.lds)");
+var captureJoinOption = new Option<long?>(name: "--join", description: "join a running capture this many bytes before its live head (0 for the head)");
+var captureJoinMsOption = new Option<long?>(name: "--join-ms", description: "start this many milliseconds before now, reads back the last capture if stopped");
 var captureCommand = new Command("capture", description: "capture data")
 {
     inputDeviceArg,
-    captureOutputArg
+    captureOutputArg,
+    captureOverrunOption,
+    captureStatsOption,
+    captureFramedOption,
+    capturePackedOption,
+    captureJoinOption,
+    captureJoinMsOption
 };
 
 captureCommand.AddAlias("cap");
 
-captureCommand.SetHandler((device, output) =>
+captureCommand.SetHandler((device, output, overrun, stats, framed, packed, join, joinMs) =>
 {
+    if (framed && packed)
+    {
+        Console.Error.WriteLine("--framed and --packed cannot be combined");
+        return;
+    }
+
+    if (join is not null && joinMs is not null)
+    {
+        Console.Error.WriteLine("--join and --join-ms cannot be combined");
+        return;
+    }
+
     using (cx = new Cxadc(device))
     {
+        captureStats = stats;
+        cx.Set(Cxadc.CX_IOCTL_SET_READ_MODE, framed ? Cxadc.CX_READ_MODE_FRAMED : Cxadc.CX_READ_MODE_RAW);
+        cx.Set(Cxadc.CX_IOCTL_SET_READ_FORMAT, packed ? Cxadc.CX_READ_FORMAT_PACKED10 : Cxadc.CX_READ_FORMAT_RAW);
+        cx.Set(Cxadc.CX_IOCTL_SET_OVERRUN_POLICY, overrun switch
+        {
+            "fail" => Cxadc.CX_OVERRUN_POLICY_FAIL,
+            "short" => Cxadc.CX_OVERRUN_POLICY_SHORT,
+            _ => Cxadc.CX_OVERRUN_POLICY_SKIP
+        });
+
+        if ((join ?? joinMs) is long back)
+        {
+            var data = new byte[16];
+            BinaryPrimitives.WriteUInt32LittleEndian(data, join is not null ? Cxadc.CX_READ_ORIGIN_HEAD : Cxadc.CX_READ_ORIGIN_TIME);
+            BinaryPrimitives.WriteInt64LittleEndian(data.AsSpan()[8..], back);
+            cx.Set(Cxadc.CX_IOCTL_SET_READ_POSITION, data);
+        }
+
         using var stream = output == "-" ? Console.OpenStandardOutput() : File.Open(output, FileMode.Create);
         using var writer = new BinaryWriter(stream);
 
@@ -48,13 +97,284 @@ captureCommand.SetHandler((device, output) =>
             var buffer = new byte[READ_SIZE];
             var bufSpan = new Span<byte>(buffer);
 
-            if (cx.Read(bufSpan) is var bytesRead)
+            var bytesRead = cx.Read(bufSpan);
+
+            // capture stopped, or the history read back has been drained
+            if (bytesRead == 0)
+            {
+                break;
+            }
+
+            writer.Write(buffer, 0, bytesRead);
+        }
+    }
+}, inputDeviceArg, captureOutputArg, captureOverrunOption, captureStatsOption, captureFramedOption, capturePackedOption, captureJoinOption, captureJoinMsOption);
+
+
+// sync command
+var syncDevicesArg = new Argument<string[]>(name: "devices", description: "device paths")
+{
+    Arity = new ArgumentArity(1, Cxadc.CX_SYNC_START_MAX_DEVICES)
+};
+var syncOutputOption = new Option<string[]>(name: "--output", description: "output path for each device, in the same order")
+{
+    IsRequired = true,
+    AllowMultipleArgumentsPerToken = true
+};
+var syncCommand = new Command("sync", description: "start several devices together and capture from each")
+{
+    syncDevicesArg,
+    syncOutputOption
+};
+
+syncCommand.SetHandler((devices, outputs) =>
+{
+    if (devices.Length != outputs.Length)
+    {
+        Console.Error.WriteLine("one --output is needed per device");
+        return;
+    }
+
+    var cards = devices.Select(device => new Cxadc(device)).ToList();
+
+    try
+    {
+        // count, then the index of each device
+        var data = new byte[4 + Cxadc.CX_SYNC_START_MAX_DEVICES * 4];
+        BinaryPrimitives.WriteUInt32LittleEndian(data, (uint)devices.Length);
+
+        for (var i = 0; i < devices.Length; i++)
+        {
+            BinaryPrimitives.WriteUInt32LittleEndian(data.AsSpan()[(4 + i * 4)..], GetDeviceIndex(devices[i]));
+        }
+
+        var result = cards[0].Get(Cxadc.CX_IOCTL_SYNC_START, Cxadc.CX_SYNC_START_RESULT_SIZE, data);
+        var freq = BinaryPrimitives.ReadInt64LittleEndian(result.AsSpan()[8..]);
+        var skew = BinaryPrimitives.ReadInt64LittleEndian(result.AsSpan()[16..]);
+        var first = BinaryPrimitives.ReadInt64LittleEndian(result.AsSpan()[32..]);
+
+        Console.Error.WriteLine("{0,-15} {1,-10} {2,-20} {3,-10}", "device", "gp_cnt", "timestamp", "offset");
+
+        for (var i = 0; i < devices.Length; i++)
+        {
+            var card = result.AsSpan()[(24 + i * 16)..];
+            var timestamp = BinaryPrimitives.ReadInt64LittleEndian(card[8..]);
+
+            Console.Error.WriteLine("{0,-15} {1,-10} {2,-20} {3,-10}",
+                devices[i],
+                BinaryPrimitives.ReadUInt32LittleEndian(card[4..]),
+                timestamp,
+                $"{(timestamp - first) * 1e6 / freq:0.000}us");
+        }
+
+        Console.Error.WriteLine("{0,-15} {1,-10}", "skew", $"{skew * 1e6 / freq:0.000}us");
+
+        var tasks = cards.Select((card, i) => Task.Run(() =>
+        {
+            using var stream = File.Open(outputs[i], FileMode.Create);
+            var buffer = new byte[READ_SIZE];
+
+            while (card.Read(buffer) is var bytesRead && bytesRead > 0)
+            {
+                stream.Write(buffer, 0, bytesRead);
+            }
+        })).ToArray();
+
+        Task.WaitAll(tasks);
+    }
+    finally
+    {
+        cards.ForEach(card => card.Dispose());
+    }
+}, syncDevicesArg, syncOutputOption);
+
+
+// stress command
+var stressReadersOption = new Option<int>(name: "--readers", description: "number of handles reading at once", getDefaultValue: () => 4);
+var stressSecondsOption = new Option<int>(name: "--seconds", description: "how long to read for", getDefaultValue: () => 10);
+var stressCommand = new Command("stress", description: "read from one device on several handles at once")
+{
+    inputDeviceArg,
+    stressReadersOption,
+    stressSecondsOption
+};
+
+stressCommand.SetHandler((device, readers, seconds) =>
+{
+    if (readers < 1)
+    {
+        Console.Error.WriteLine("--readers must be at least 1");
+        return;
+    }
+
+    var cards = Enumerable.Range(0, readers).Select(_ => new Cxadc(device)).ToList();
+
+    try
+    {
+        var stop = DateTime.UtcNow.AddSeconds(seconds);
+
+        // each reader uses its own mix of read sizes, so parked reads wait for different positions
+        var results = cards.Select((card, i) => Task.Run(() =>
+        {
+            var random = new Random(i);
+            var buffer = new byte[READ_SIZE];
+            var watch = System.Diagnostics.Stopwatch.StartNew();
+            long bytes = 0;
+            long reads = 0;
+
+            while (DateTime.UtcNow < stop)
             {
-                writer.Write(buffer, 0, bytesRead);
+                var len = random.Next(1, (int)(READ_SIZE / 4096) + 1) * 4096;
+                var bytesRead = card.Read(buffer.AsSpan(0, len));
+
+                if (bytesRead == 0)
+                {
+                    break;
+                }
+
+                bytes += bytesRead;
+                reads++;
             }
+
+            return (Bytes: bytes, Reads: reads, Seconds: watch.Elapsed.TotalSeconds);
+        })).ToArray();
+
+        Task.WaitAll(results);
+
+        Console.WriteLine("{0,-8} {1,-14} {2,-10} {3,-10} {4,-14} {5,-10}", "reader", "bytes", "reads", "overruns", "bytes_lost", "rate");
+
+        for (var i = 0; i < readers; i++)
+        {
+            var (bytes, reads, elapsed) = results[i].Result;
+            var stats = cards[i].Get(Cxadc.CX_IOCTL_GET_READER_STATS, Cxadc.CX_READER_STATS_SIZE, []);
+
+            Console.WriteLine("{0,-8} {1,-14} {2,-10} {3,-10} {4,-14} {5,-10}",
+                i,
+                bytes,
+                reads,
+                BinaryPrimitives.ReadUInt32LittleEndian(stats.AsSpan()[24..]),
+                BinaryPrimitives.ReadInt64LittleEndian(stats),
+                $"{bytes / elapsed / 1e6:0.00}MB/s");
+        }
+
+        Console.WriteLine("{0,-8} {1,-14}", "total", results.Sum(r => r.Result.Bytes));
+    }
+    finally
+    {
+        cards.ForEach(card => card.Dispose());
+    }
+}, inputDeviceArg, stressReadersOption, stressSecondsOption);
+
+
+// ttfb command
+var ttfbCountOption = new Option<int>(name: "--count", description: "number of times to open the device", getDefaultValue: () => 20);
+var ttfbReadSizeOption = new Option<int>(name: "--read-size", description: "bytes in the first read", getDefaultValue: () => 4096);
+var ttfbGapOption = new Option<int>(name: "--gap", description: "milliseconds between a close and the next open", getDefaultValue: () => 100);
+var ttfbCommand = new Command("ttfb", description: "time from opening a device to its first data, e.g. with and without keep_alive")
+{
+    inputDeviceArg,
+    ttfbCountOption,
+    ttfbReadSizeOption,
+    ttfbGapOption
+};
+
+ttfbCommand.SetHandler((device, count, readSize, gap) =>
+{
+    if (count < 1 || readSize < 1)
+    {
+        Console.Error.WriteLine("--count and --read-size must be at least 1");
+        return;
+    }
+
+    var buffer = new byte[readSize];
+    var times = new List<double>();
+
+    for (var i = 0; i < count; i++)
+    {
+        var watch = System.Diagnostics.Stopwatch.StartNew();
+
+        using (var card = new Cxadc(device))
+        {
+            if (card.Read(buffer) == 0)
+            {
+                Console.Error.WriteLine("no data");
+                return;
+            }
+
+            times.Add(watch.Elapsed.TotalMilliseconds);
         }
+
+        Thread.Sleep(gap);
     }
-}, inputDeviceArg, captureOutputArg);
+
+    // the first open may have started the capture even with keep_alive set
+    var first = times[0];
+    times.Sort();
+
+    using (cx = new Cxadc(device))
+    {
+        Console.WriteLine("{0,-15} {1,-8}", "keep_alive", cx.Get(Cxadc.CX_IOCTL_GET_KEEP_ALIVE));
+    }
+
+    Console.WriteLine("{0,-15} {1,-8}", "first", $"{first:0.000}ms");
+    Console.WriteLine("{0,-15} {1,-8}", "min", $"{times[0]:0.000}ms");
+    Console.WriteLine("{0,-15} {1,-8}", "median", $"{times[times.Count / 2]:0.000}ms");
+    Console.WriteLine("{0,-15} {1,-8}", "max", $"{times[^1]:0.000}ms");
+}, inputDeviceArg, ttfbCountOption, ttfbReadSizeOption, ttfbGapOption);
+
+
+// verify command
+var verifyInputArg = new Argument<string>(name: "input", description: "framed capture path");
+var verifyCommand = new Command("verify", description: "check a capture made with --framed for gaps & errors")
+{
+    verifyInputArg
+};
+
+verifyCommand.SetHandler((input) =>
+{
+    using var stream = File.OpenRead(input);
+    var validator = new FrameValidator();
+    var buffer = new byte[READ_SIZE * 2];
+    var len = 0;
+
+    while (true)
+    {
+        var read = stream.Read(buffer, len, buffer.Length - len);
+        len += read;
+
+        var off = 0;
+
+        while (validator.Feed(buffer.AsSpan(off, len - off), Console.Error.WriteLine) is var used && used > 0)
+        {
+            off += used;
+        }
+
+        buffer.AsSpan(off, len - off).CopyTo(buffer);
+        len -= off;
+
+        if (read == 0)
+        {
+            break;
+        }
+
+        // a frame can be larger than the buffer if it was read with a larger buffer
+        if (len == buffer.Length)
+        {
+            Array.Resize(ref buffer, buffer.Length * 2);
+        }
+    }
+
+    var seconds = validator.TimestampFreq > 0 ? (double)(validator.LastTimestamp - validator.FirstTimestamp) / validator.TimestampFreq : 0;
+
+    Console.WriteLine("{0,-15} {1,-8}", "frames", validator.Frames);
+    Console.WriteLine("{0,-15} {1,-8}", "data_bytes", validator.DataBytes);
+    Console.WriteLine("{0,-15} {1,-8}", "gaps", validator.Gaps);
+    Console.WriteLine("{0,-15} {1,-8}", "bytes_lost", validator.BytesLost);
+    Console.WriteLine("{0,-15} {1,-8}", "ouflow_blocks", validator.OuflowBlocks);
+    Console.WriteLine("{0,-15} {1,-8}", "errors", validator.Errors);
+    Console.WriteLine("{0,-15} {1,-8}", "trailing", len);
+    Console.WriteLine("{0,-15} {1,-8}", "duration", $"{seconds:0.000}s");
+}, verifyInputArg);
 
 
 // get command
@@ -68,8 +388,41 @@ getCommand.SetHandler((device) =>
     PrintCxConfig(device);
 }, inputDeviceArg);
 
+// stats command
+var statsCommand = new Command("stats", description: "show device statistics")
+{
+    inputDeviceArg,
+};
+
+statsCommand.SetHandler((device) =>
+{
+    PrintCxStats(device);
+}, inputDeviceArg);
+
+// events command
+var eventsCommand = new Command("events", description: "show error interrupts held by the driver")
+{
+    inputDeviceArg,
+};
+
+eventsCommand.SetHandler((device) =>
+{
+    PrintCxEvents(device);
+}, inputDeviceArg);
+
+// latency command
+var latencyCommand = new Command("latency", description: "show latency histograms")
+{
+    inputDeviceArg,
+};
+
+latencyCommand.SetHandler((device) =>
+{
+    PrintCxLatency(device);
+}, inputDeviceArg);
+
 // set command
-var setNameArg = new Argument<string>("name").FromAmong("vmux", "level", "tenbit", "sixdb", "center_offset");
+var setNameArg = new Argument<string>("name").FromAmong("vmux", "level", "tenbit", "sixdb", "center_offset", "irq_period", "poll_rate", "keep_alive", "ring_size", "ring_release");
 var setValueArg = new Argument<uint>("value");
 var setCommand = new Command("set", description: "set device options")
 {
@@ -88,6 +441,11 @@ setCommand.SetHandler((device, name, value) =>
         "tenbit" => Cxadc.CX_IOCTL_SET_TENBIT,
         "sixdb" => Cxadc.CX_IOCTL_SET_SIXDB,
         "center_offset" => Cxadc.CX_IOCTL_SET_CENTER_OFFSET,
+        "irq_period" => Cxadc.CX_IOCTL_SET_IRQ_PERIOD,
+        "poll_rate" => Cxadc.CX_IOCTL_SET_POLL_RATE,
+        "keep_alive" => Cxadc.CX_IOCTL_SET_KEEP_ALIVE,
+        "ring_size" => Cxadc.CX_IOCTL_SET_RING_SIZE,
+        "ring_release" => Cxadc.CX_IOCTL_SET_RING_RELEASE,
         _ => 0
     };
 
@@ -141,15 +499,42 @@ registerGetCommand.SetHandler((device, address) =>
 
 }, inputDeviceArg, registerAddressArg);
 
+var registerCountArg = new Argument<uint>("count", description: "number of registers");
+
+var registerDumpCommand = new Command("dump", description: "read consecutive registers in one call")
+{
+    inputDeviceArg,
+    registerAddressArg,
+    registerCountArg
+};
+
+registerDumpCommand.SetHandler((device, address, count) =>
+{
+    var start = Convert.ToUInt32(address, 16);
+    var ops = Enumerable.Range(0, (int)Math.Min(count, Cxadc.CX_REG_PROGRAM_MAX_OPS))
+        .Select(i => new CxRegOp(Cxadc.CX_REG_OP_READ, start + (uint)i * 4))
+        .ToList();
+
+    using var cx = new Cxadc(device);
+    var (values, _) = cx.RunRegisterProgram(ops);
+
+    for (var i = 0; i < values.Length; i++)
+    {
+        Console.WriteLine($"0x{ops[i].Address:X8} 0x{values[i]:X8}");
+    }
+
+}, inputDeviceArg, registerAddressArg, registerCountArg);
+
 var registerCommand = new Command("register", description: "get/set registers")
 {
     registerGetCommand,
-    registerSetCommand
+    registerSetCommand,
+    registerDumpCommand
 };
 registerCommand.AddAlias("reg");
 
 // reset command
-var resetNameArg = new Argument<string>("name").FromAmong("ouflow_count");
+var resetNameArg = new Argument<string>("name").FromAmong("ouflow_count", "stats", "latency");
 var resetCommand = new Command("reset", description: "reset device state")
 {
     inputDeviceArg,
@@ -162,6 +547,8 @@ resetCommand.SetHandler((device, name) =>
     uint code = name switch
     {
         "ouflow_count" => Cxadc.CX_IOCTL_RESET_OUFLOW_COUNT,
+        "stats" => Cxadc.CX_IOCTL_RESET_STATS,
+        "latency" => Cxadc.CX_IOCTL_RESET_LATENCY,
         _ => 0
     };
 
@@ -398,7 +785,14 @@ var rootCommand = new RootCommand("cxadc-win-tool - https://github.com/JuniorIsA
     statusCommand,
     scanCommand,
     captureCommand,
+    syncCommand,
+    stressCommand,
+    ttfbCommand,
+    verifyCommand,
     getCommand,
+    statsCommand,
+    eventsCommand,
+    latencyCommand,
     setCommand,
     resetCommand,
     registerCommand,
@@ -430,24 +824,153 @@ List<string> GetDevices()
     return devices;
 }
 
+// \\.\cxadcN is device index N
+uint GetDeviceIndex(string device)
+{
+    return uint.Parse(device[(device.LastIndexOf("cxadc") + "cxadc".Length)..]);
+}
+
 void PrintCxConfig(string device)
 {
     using (cx = new Cxadc(device))
     {
-        var capturing = cx.Get(Cxadc.CX_IOCTL_GET_CAPTURE_STATE) == 1 ? true : false;
-        var busNum = cx.Get(Cxadc.CX_IOCTL_GET_BUS_NUMBER);
-        var devAddr = cx.Get(Cxadc.CX_IOCTL_GET_DEVICE_ADDRESS);
+        var config = cx.Get(Cxadc.CX_IOCTL_GET_CONFIG, Cxadc.CX_CONFIG_SIZE, []);
+        var capturing = BinaryPrimitives.ReadInt32LittleEndian(config.AsSpan()[40..]) != 0;
+        var busNum = BinaryPrimitives.ReadUInt32LittleEndian(config.AsSpan()[48..]);
+        var devAddr = BinaryPrimitives.ReadUInt32LittleEndian(config.AsSpan()[52..]);
         var devNum = (devAddr >> 16) & 0x0000FFFF;
         var funcNum = devAddr & 0x0000FFFF;
 
         Console.WriteLine("{0,-15} {1,-8} {2,15}", "device", device, capturing ? "**capturing**" : "");
         Console.WriteLine("{0,-15} {1,-8}", "location", $"{busNum:00}:{devNum:00}.{funcNum:0}");
-        Console.WriteLine("{0,-15} {1,-8}", "vmux", cx.Get(Cxadc.CX_IOCTL_GET_VMUX));
-        Console.WriteLine("{0,-15} {1,-8}", "level", cx.Get(Cxadc.CX_IOCTL_GET_LEVEL));
-        Console.WriteLine("{0,-15} {1,-8}", "tenbit", cx.Get(Cxadc.CX_IOCTL_GET_TENBIT));
-        Console.WriteLine("{0,-15} {1,-8}", "sixdb", cx.Get(Cxadc.CX_IOCTL_GET_SIXDB));
-        Console.WriteLine("{0,-15} {1,-8}", "center_offset", cx.Get(Cxadc.CX_IOCTL_GET_CENTER_OFFSET));
-        Console.WriteLine("{0,-15} {1,-8}", "ouflow_count", cx.Get(Cxadc.CX_IOCTL_GET_OUFLOW_COUNT));
+        Console.WriteLine("{0,-15} {1,-8}", "vmux", BinaryPrimitives.ReadInt32LittleEndian(config.AsSpan()[8..]));
+        Console.WriteLine("{0,-15} {1,-8}", "level", BinaryPrimitives.ReadInt32LittleEndian(config.AsSpan()[12..]));
+        Console.WriteLine("{0,-15} {1,-8}", "tenbit", BinaryPrimitives.ReadInt32LittleEndian(config.AsSpan()[16..]));
+        Console.WriteLine("{0,-15} {1,-8}", "sixdb", BinaryPrimitives.ReadInt32LittleEndian(config.AsSpan()[20..]));
+        Console.WriteLine("{0,-15} {1,-8}", "center_offset", BinaryPrimitives.ReadInt32LittleEndian(config.AsSpan()[24..]));
+        Console.WriteLine("{0,-15} {1,-8}", "irq_period", BinaryPrimitives.ReadUInt32LittleEndian(config.AsSpan()[28..]));
+        Console.WriteLine("{0,-15} {1,-8}", "poll_rate", BinaryPrimitives.ReadUInt32LittleEndian(config.AsSpan()[56..]));
+        Console.WriteLine("{0,-15} {1,-8}", "keep_alive", BinaryPrimitives.ReadUInt32LittleEndian(config.AsSpan()[60..]));
+        Console.WriteLine("{0,-15} {1,-8}", "ring_size", BinaryPrimitives.ReadUInt32LittleEndian(config.AsSpan()[36..]));
+        Console.WriteLine("{0,-15} {1,-8}", "ring_release", BinaryPrimitives.ReadUInt32LittleEndian(config.AsSpan()[64..]));
+        Console.WriteLine("{0,-15} {1,-8}", "ouflow_count", BinaryPrimitives.ReadUInt32LittleEndian(config.AsSpan()[44..]));
+
+        var fifo = cx.Get(Cxadc.CX_IOCTL_GET_FIFO_GEOMETRY, Cxadc.CX_FIFO_GEOMETRY_SIZE, []);
+        var cdtLen = BinaryPrimitives.ReadUInt32LittleEndian(fifo);
+        var cdtCount = BinaryPrimitives.ReadUInt32LittleEndian(fifo.AsSpan()[4..]);
+
+        Console.WriteLine("{0,-15} {1,-8}", "fifo", $"{cdtCount} x {cdtLen}");
+    }
+}
+
+void PrintReaderStats(Cxadc cx)
+{
+    var stats = cx.Get(Cxadc.CX_IOCTL_GET_READER_STATS, Cxadc.CX_READER_STATS_SIZE, []);
+
+    Console.Error.WriteLine("{0,-15} {1,-8}", "bytes_lost", BinaryPrimitives.ReadInt64LittleEndian(stats));
+    Console.Error.WriteLine("{0,-15} {1,-8}", "lag", BinaryPrimitives.ReadInt64LittleEndian(stats.AsSpan()[8..]));
+    Console.Error.WriteLine("{0,-15} {1,-8}", "peak_lag", BinaryPrimitives.ReadInt64LittleEndian(stats.AsSpan()[16..]));
+    Console.Error.WriteLine("{0,-15} {1,-8}", "overrun_count", BinaryPrimitives.ReadUInt32LittleEndian(stats.AsSpan()[24..]));
+    Console.Error.WriteLine("{0,-15} {1,-8}", "bytes_copied", BinaryPrimitives.ReadInt64LittleEndian(stats.AsSpan()[32..]));
+    Console.Error.WriteLine("{0,-15} {1,-8}", "reads", BinaryPrimitives.ReadInt64LittleEndian(stats.AsSpan()[40..]));
+}
+
+void PrintCxStats(string device)
+{
+    using (cx = new Cxadc(device))
+    {
+        var stats = cx.Get(Cxadc.CX_IOCTL_GET_STATS, Cxadc.CX_STATS_SIZE, []);
+        var freq = BinaryPrimitives.ReadInt64LittleEndian(stats.AsSpan()[72..]);
+        var reads = BinaryPrimitives.ReadInt64LittleEndian(stats.AsSpan()[48..]);
+        var waitTime = BinaryPrimitives.ReadInt64LittleEndian(stats.AsSpan()[56..]);
+        var avgWait = reads > 0 && freq > 0 ? waitTime * 1e3 / freq / reads : 0;
+        var allocTime = BinaryPrimitives.ReadInt64LittleEndian(stats.AsSpan()[88..]);
+        var allocMs = freq > 0 ? allocTime * 1e3 / freq : 0;
+
+        Console.WriteLine("{0,-19} {1,-8}", "device", device);
+        Console.WriteLine("{0,-19} {1,-8}", "version", BinaryPrimitives.ReadUInt32LittleEndian(stats));
+        Console.WriteLine("{0,-19} {1,-8}", "bytes_produced", BinaryPrimitives.ReadInt64LittleEndian(stats.AsSpan()[8..]));
+        Console.WriteLine("{0,-19} {1,-8}", "interrupts", BinaryPrimitives.ReadInt64LittleEndian(stats.AsSpan()[16..]));
+        Console.WriteLine("{0,-19} {1,-8}", "unknown_interrupts", BinaryPrimitives.ReadInt64LittleEndian(stats.AsSpan()[24..]));
+        Console.WriteLine("{0,-19} {1,-8}", "dpc_count", BinaryPrimitives.ReadInt64LittleEndian(stats.AsSpan()[32..]));
+        Console.WriteLine("{0,-19} {1,-8}", "bytes_copied", BinaryPrimitives.ReadInt64LittleEndian(stats.AsSpan()[40..]));
+        Console.WriteLine("{0,-19} {1,-8}", "reads_completed", reads);
+        Console.WriteLine("{0,-19} {1,-8}", "read_wait_avg", $"{avgWait:0.000}ms");
+        Console.WriteLine("{0,-19} {1,-8}", "max_reader_lag", BinaryPrimitives.ReadInt64LittleEndian(stats.AsSpan()[64..]));
+        Console.WriteLine("{0,-19} {1,-8}", "ring_allocs", BinaryPrimitives.ReadInt64LittleEndian(stats.AsSpan()[80..]));
+        Console.WriteLine("{0,-19} {1,-8}", "ring_alloc_last", $"{allocMs:0.000}ms");
+        Console.WriteLine("{0,-19} {1,-8}", "ouflow_count", cx.Get(Cxadc.CX_IOCTL_GET_OUFLOW_COUNT));
+    }
+}
+
+void PrintCxEvents(string device)
+{
+    using (cx = new Cxadc(device))
+    {
+        var events = cx.Get(Cxadc.CX_IOCTL_GET_EVENTS, Cxadc.CX_EVENTS_SIZE, new byte[8]);
+        var count = BinaryPrimitives.ReadUInt32LittleEndian(events.AsSpan()[8..]);
+        var freq = BinaryPrimitives.ReadInt64LittleEndian(events.AsSpan()[16..]);
+
+        Console.WriteLine("{0,-10} {1,-24} {2,-10} {3,-16} {4,-16}", "sequence", "cause", "gp_cnt", "stream_pos", "time");
+
+        for (var i = 0; i < count; i++)
+        {
+            var ev = events.AsSpan()[(24 + i * Cxadc.CX_EVENT_SIZE)..];
+            var cause = BinaryPrimitives.ReadUInt32LittleEndian(ev[8..]);
+            var causes = new List<string>();
+
+            if ((cause & Cxadc.CX_EVENT_FIFO_OVERFLOW) != 0) causes.Add("fifo_overflow");
+            if ((cause & Cxadc.CX_EVENT_SYNC_ERROR) != 0) causes.Add("sync");
+            if ((cause & Cxadc.CX_EVENT_OPCODE_ERROR) != 0) causes.Add("opcode");
+
+            Console.WriteLine("{0,-10} {1,-24} {2,-10} {3,-16} {4,-16}",
+                BinaryPrimitives.ReadUInt64LittleEndian(ev),
+                string.Join(",", causes),
+                BinaryPrimitives.ReadUInt32LittleEndian(ev[12..]),
+                BinaryPrimitives.ReadInt64LittleEndian(ev[16..]),
+                $"{BinaryPrimitives.ReadInt64LittleEndian(ev[24..]) * 1.0 / freq:0.000000}s");
+        }
+
+        Console.WriteLine("{0,-10} {1,-8}", "lost", BinaryPrimitives.ReadUInt32LittleEndian(events.AsSpan()[12..]));
+    }
+}
+
+void PrintCxLatency(string device)
+{
+    string[] stages = ["isr_to_dpc", "dpc_to_work", "read", "service"];
+
+    using (cx = new Cxadc(device))
+    {
+        var latency = cx.Get(Cxadc.CX_IOCTL_GET_LATENCY, Cxadc.CX_LATENCY_SIZE, []);
+        var stageCount = Math.Min((int)BinaryPrimitives.ReadUInt32LittleEndian(latency.AsSpan()[4..]), stages.Length);
+        var freq = BinaryPrimitives.ReadInt64LittleEndian(latency.AsSpan()[8..]);
+
+        Console.WriteLine("{0,-19} {1,-8}", "device", device);
+        Console.WriteLine("{0,-19} {1,-8}", "version", BinaryPrimitives.ReadUInt32LittleEndian(latency));
+
+        for (var i = 0; i < stageCount; i++)
+        {
+            var hist = latency.AsSpan()[(16 + i * Cxadc.CX_LATENCY_BUCKETS * 8)..];
+
+            Console.WriteLine();
+            Console.WriteLine(stages[i]);
+
+            // bucket 0 is 0 ticks, bucket n is [2^(n-1), 2^n) ticks, the last bucket is open-ended
+            for (var j = 0; j < Cxadc.CX_LATENCY_BUCKETS; j++)
+            {
+                var count = BinaryPrimitives.ReadInt64LittleEndian(hist[(j * 8)..]);
+
+                if (count == 0)
+                {
+                    continue;
+                }
+
+                var lo = j == 0 ? 0 : 1L << (j - 1);
+                var range = j == Cxadc.CX_LATENCY_BUCKETS - 1 ? $">= {lo * 1e6 / freq:0.0}us" : $"< {(1L << j) * 1e6 / freq:0.0}us";
+
+                Console.WriteLine("  {0,-17} {1,-8}", range, count);
+            }
+        }
     }
 }
 
@@ -0,0 +1,162 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#include "capture.h"
+
+// claim the device for a new capture, FALSE if one is already running
+// is_capturing is also read without capture_lock, by the dpc & poll tick
+BOOLEAN cx_capture_arm(
+    _Inout_ PCX_CAPTURE capture
+)
+{
+    return !InterlockedCompareExchange(&capture->is_capturing, TRUE, FALSE);
+}
+
+// release a device armed by cx_capture_arm that was never run
+VOID cx_capture_disarm(
+    _Inout_ PCX_CAPTURE capture
+)
+{
+    InterlockedExchange(&capture->is_capturing, FALSE);
+}
+
+VOID cx_capture_stop(
+    _Inout_ PCX_CAPTURE capture
+)
+{
+    InterlockedExchange(&capture->is_capturing, FALSE);
+    capture->idle_time = 0;
+}
+
+// a read arrives on a handle that reads the running capture, before it is counted as a reader
+// starts a capture if none is running, or takes back one that is only kept alive
+CX_CAPTURE_ACTION cx_capture_join(
+    _Inout_ PCX_CAPTURE capture
+)
+{
+    if (!capture->is_capturing)
+    {
+        return CX_CAPTURE_START;
+    }
+
+    if (capture->idle_time)
+    {
+        capture->idle_time = 0;
+        return CX_CAPTURE_RESUME;
+    }
+
+    return CX_CAPTURE_NONE;
+}
+
+// count a handle as a reader, once
+VOID cx_capture_add_reader(
+    _Inout_ PCX_CAPTURE capture,
+    _Inout_ PBOOLEAN is_reader
+)
+{
+    if (!*is_reader)
+    {
+        *is_reader = TRUE;
+        InterlockedIncrement(&capture->reader_count);
+    }
+}
+
+// a handle closes, the capture idles once its last reader has gone
+// a capture into a client ring runs until the ring is detached
+CX_CAPTURE_ACTION cx_capture_leave(
+    _Inout_ PCX_CAPTURE capture,
+    _Inout_ PBOOLEAN is_reader,
+    _In_ BOOLEAN user_ring,
+    _In_ ULONG keep_alive,
+    _In_ LONG64 now
+)
+{
+    if (!*is_reader)
+    {
+        return CX_CAPTURE_NONE;
+    }
+
+    *is_reader = FALSE;
+
+    if (InterlockedDecrement(&capture->reader_count) || user_ring)
+    {
+        return CX_CAPTURE_NONE;
+    }
+
+    return cx_capture_idle(capture, keep_alive, now);
+}
+
+// the capture has no reader left, keep it alive for keep_alive from now or stop it
+CX_CAPTURE_ACTION cx_capture_idle(
+    _Inout_ PCX_CAPTURE capture,
+    _In_ ULONG keep_alive,
+    _In_ LONG64 now
+)
+{
+    if (keep_alive && capture->is_capturing)
+    {
+        capture->idle_time = now;
+        return CX_CAPTURE_KEEP_ALIVE;
+    }
+
+    return CX_CAPTURE_STOP;
+}
+
+// the idle timer ran, stop the capture if it has been without readers for keep_alive
+// nothing to do if a reader came back or the capture stopped since the timer was armed,
+// a timer that was already running when a reader came & went again is early for the new wait
+CX_CAPTURE_ACTION cx_capture_idle_timer(
+    _Inout_ PCX_CAPTURE capture,
+    _In_ ULONG keep_alive,
+    _In_ LONG64 now,
+    _Out_ PLONG64 left
+)
+{
+    *left = 0;
+
+    if (!capture->idle_time)
+    {
+        return CX_CAPTURE_NONE;
+    }
+
+    LONG64 due = capture->idle_time + (LONG64)keep_alive * CX_CAPTURE_TICKS_PER_MS;
+
+    if (due > now)
+    {
+        *left = due - now;
+        return CX_CAPTURE_WAIT;
+    }
+
+    return CX_CAPTURE_STOP;
+}
+
+// keep_alive changed, a capture being kept alive waits the new time from now, or stops
+CX_CAPTURE_ACTION cx_capture_set_keep_alive(
+    _Inout_ PCX_CAPTURE capture,
+    _In_ ULONG keep_alive,
+    _In_ LONG64 now
+)
+{
+    if (!capture->idle_time)
+    {
+        return CX_CAPTURE_NONE;
+    }
+
+    if (keep_alive)
+    {
+        capture->idle_time = now;
+        return CX_CAPTURE_KEEP_ALIVE;
+    }
+
+    return CX_CAPTURE_STOP;
+}
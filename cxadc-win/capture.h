@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#pragma once
+
+#include "portable.h"
+
+// capture lifecycle, what to do as readers join & leave a capture and it is kept alive
+// each decision is made with the others excluded, the driver holds capture_lock,
+// and the caller carries out the action returned
+
+// idle times count 100 ns units, as KeQueryInterruptTime
+#define CX_CAPTURE_TICKS_PER_MS     10000
+
+typedef struct _CX_CAPTURE
+{
+    LONG reader_count;          // handles that read the running capture & are still open
+    LONG is_capturing;
+    LONG64 idle_time;           // time the last reader left a capture kept alive, 0 if not kept alive
+} CX_CAPTURE, *PCX_CAPTURE;
+
+typedef enum _CX_CAPTURE_ACTION
+{
+    CX_CAPTURE_NONE,
+    CX_CAPTURE_START,           // nothing is running, start a capture
+    CX_CAPTURE_RESUME,          // a capture kept alive has a reader again, stop the idle timer
+    CX_CAPTURE_KEEP_ALIVE,      // arm the idle timer for keep_alive
+    CX_CAPTURE_WAIT,            // the idle timer ran early, arm it for the time left
+    CX_CAPTURE_STOP             // stop the capture
+} CX_CAPTURE_ACTION;
+
+BOOLEAN cx_capture_arm(_Inout_ PCX_CAPTURE capture);
+VOID cx_capture_disarm(_Inout_ PCX_CAPTURE capture);
+VOID cx_capture_stop(_Inout_ PCX_CAPTURE capture);
+CX_CAPTURE_ACTION cx_capture_join(_Inout_ PCX_CAPTURE capture);
+VOID cx_capture_add_reader(_Inout_ PCX_CAPTURE capture, _Inout_ PBOOLEAN is_reader);
+CX_CAPTURE_ACTION cx_capture_leave(
+    _Inout_ PCX_CAPTURE capture,
+    _Inout_ PBOOLEAN is_reader,
+    _In_ BOOLEAN user_ring,
+    _In_ ULONG keep_alive,
+    _In_ LONG64 now
+);
+CX_CAPTURE_ACTION cx_capture_idle(_Inout_ PCX_CAPTURE capture, _In_ ULONG keep_alive, _In_ LONG64 now);
+CX_CAPTURE_ACTION cx_capture_idle_timer(
+    _Inout_ PCX_CAPTURE capture,
+    _In_ ULONG keep_alive,
+    _In_ LONG64 now,
+    _Out_ PLONG64 left
+);
+CX_CAPTURE_ACTION cx_capture_set_keep_alive(_Inout_ PCX_CAPTURE capture, _In_ ULONG keep_alive, _In_ LONG64 now);
@@ -20,12 +20,15 @@
 #include <evntrace.h>
 #include <Ntstrsafe.h>
 
-#define CX_CDT_BUF_LEN          2048
-#define CX_CDT_BUF_COUNT        8
-#define CX_VBI_BUF_SIZE         (1024 * 1024 * 64)
-#define CX_VBI_BUF_COUNT        (CX_VBI_BUF_SIZE / PAGE_SIZE)
-#define CX_RISC_INSTR_BUF_SIZE  (CX_VBI_BUF_SIZE / CX_CDT_BUF_LEN) * 8 + PAGE_SIZE
+#include "ring.h"
+#include "frame.h"
+#include "risc.h"
+#include "capture.h"
+
+#define CX_DMA_CHUNK_SIZE_MIN   (1024 * 64)
+#define CX_DMA_CHUNK_SIZE_MAX   (1024 * 1024 * 2)
 #define READ_TIMEOUT            5000
+#define CX_POOL_TAG             'daxc'
 
 typedef struct _DMA_DATA
 {
@@ -35,6 +38,14 @@ typedef struct _DMA_DATA
     PHYSICAL_ADDRESS la;
 } DMA_DATA, *PDMA_DATA;
 
+// the risc program, in cx_risc_buf_count common buffers of CX_RISC_BUF_SIZE
+typedef struct _RISC_PROG_DATA
+{
+    ULONG count;
+    PDMA_DATA dma;
+    PCX_RISC_BUF bufs;      // va & bus address of each, for cx_risc_prog_begin
+} RISC_PROG_DATA, *PRISC_PROG_DATA;
+
 typedef struct _DEVICE_ATTRS
 {
     LONG vmux;
@@ -43,17 +54,34 @@ typedef struct _DEVICE_ATTRS
     LONG sixdb;
     LONG crystal;
     LONG center_offset;
+    ULONG irq_period;
+    ULONG poll_rate;
+    ULONG keep_alive;
+    ULONG ring_release;
 } DEVICE_ATTRS, *PDEVICE_ATTRS;
 
 typedef struct _DEVICE_STATE
 {
     LONG last_gp_cnt;
     LONG initial_page;
-    
+    LONG64 write_pos;
+    LONG64 block_seq;
+    LONG64 timestamp_freq;
+    LONG64 start_timestamp;
+    ULONG start_gp_cnt;
+    LONG64 isr_timestamp;       // first unhandled interrupt, 0 once the dpc has run
+    LONG64 dpc_timestamp;       // first dpc since the read work item last ran, 0 once it has
+    LONG64 wake_pos;            // write_pos the first parked read is waiting for, set by the read work item
+    ULONG read_pass;            // pass of the read work item over the pending reads, under read_lock
+    LONG poll_period;           // us between gp counter samples, 0 when the risc interrupts publish data
+
     ULONG ouflow_count;
+    LONG pending_flags;         // CX_FRAME_FLAG_* raised by the isr for the next block
+    LONG64 event_seq;
 
-    LONG reader_count;
-    BOOLEAN is_capturing;
+    CX_CAPTURE capture;         // readers & keep alive, under capture_lock
+    LONG capture_id;            // changes whenever the ring stops holding the last capture
+    LONG64 release_time;        // interrupt time the ring was last in use, 0 if it is not to be released
 } DEVICE_STATE, *PDEVICE_STATE;
 
 typedef struct _DEVICE_CONTEXT
@@ -67,19 +95,51 @@ typedef struct _DEVICE_CONTEXT
     WDFINTERRUPT intr;
     WDFQUEUE control_queue;
     WDFQUEUE read_queue;
-    KEVENT isr_event;
+    WDFQUEUE pending_queue;
+    WDFWORKITEM read_work_item;
+    WDFTIMER poll_timer;
+    WDFTIMER idle_timer;            // stops a capture kept alive once keep_alive passes without readers
+    WDFTIMER release_timer;         // frees the ring once ring_release passes without a capture
+    WDFWAITLOCK read_lock;
+    WDFWAITLOCK capture_lock;       // reads starting a capture & joining as readers vs the last reader leaving
 
     DEVICE_ATTRS attrs;
     DEVICE_STATE state;
+    CX_FIFO_GEOMETRY fifo;
+    CX_STATS stats;
+    CX_LATENCY_HIST latency[CX_LATENCY_STAGES];
+    CX_EVENT events[CX_EVENT_RING_SIZE];
 
     WDFDMAENABLER dma_enabler;
+    WDFDMAENABLER user_dma_enabler;     // scatter/gather, maps the pages of a client ring
 
     PULONG mmio;
     ULONG mmio_len;
     PMDL user_mdl;
 
-    DMA_DATA dma_risc_instr;
-    DMA_DATA dma_risc_page[CX_VBI_BUF_COUNT + 1];
+    PCX_RING_HEADER ring_hdr;
+    PMDL ring_hdr_mdl;
+    PMDL ring_mdl;
+
+    LONG ring_map_count;
+
+    CX_RING ring;
+    ULONG ring_alloc_size;          // size the ring is allocated at when next needed, see cx_ensure_ring
+    ULONG dma_chunk_size;
+    RISC_PROG_DATA risc_prog;
+    PDMA_DATA dma_risc_chunk;
+
+    PCX_BLOCK_INFO blocks;
+    ULONG block_count;
+
+    // client ring of CX_IOCTL_ATTACH_USER_RING, while attached ring & risc_prog describe it
+    // and the kernel ring is set aside in kernel_ring & kernel_risc_prog
+    WDFQUEUE user_ring_queue;
+    PCX_SG_ENTRY user_sg;
+    ULONG user_sg_count;
+    PSCATTER_GATHER_LIST user_sg_list;  // held from the adapter while attached
+    CX_RING kernel_ring;
+    RISC_PROG_DATA kernel_risc_prog;
 } DEVICE_CONTEXT, *PDEVICE_CONTEXT;
 
 WDF_DECLARE_CONTEXT_TYPE_WITH_NAME(DEVICE_CONTEXT, cx_device_get_ctx)
@@ -91,8 +151,32 @@ typedef struct _MMAP_DATA
 
 typedef struct _FILE_CONTEXT
 {
+    BOOLEAN is_reader;
     LONG64 read_offset;
+    ULONG overrun_policy;
+    ULONG wait_policy;
+    CX_READER_STATS stats;
+    ULONG read_mode;
+    ULONG read_format;
+    LONG64 frame_seq;
+    BOOLEAN frame_gap;
+    LONG history_id;            // capture_id of a stopped capture being read back, 0 if none
+    ULONG parked_pass;          // read_pass that left a stream read of this handle parked
+    BOOLEAN is_positioned;      // read position set by the client, not the default
     MMAP_DATA mmap_data;
+    CX_RING_MMAP_DATA ring_mmap_data;
+    ULONG sync_count;           // devices sync started by this handle, see cx_sync_release
+    ULONG sync_dev_idx[CX_SYNC_START_MAX_DEVICES];
+    LONG sync_capture_id[CX_SYNC_START_MAX_DEVICES];
 } FILE_CONTEXT, *PFILE_CONTEXT;
 
 WDF_DECLARE_CONTEXT_TYPE_WITH_NAME(FILE_CONTEXT, cx_file_get_ctx)
+
+typedef struct _REQUEST_CONTEXT
+{
+    LONG64 done;
+    LONG64 arrival_time;
+    LONG64 pos;                 // next stream position of a positional read, -1 for the handle's read_offset
+} REQUEST_CONTEXT, *PREQUEST_CONTEXT;
+
+WDF_DECLARE_CONTEXT_TYPE_WITH_NAME(REQUEST_CONTEXT, cx_request_get_ctx)
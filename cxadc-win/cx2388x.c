@@ -15,6 +15,11 @@
 #include "cx2388x.tmh"
 
 #include "cx2388x.h"
+#include "event.h"
+#include "hist.h"
+#include "ring.h"
+#include "risc.h"
+#include "sched.h"
 
 __inline
 ULONG cx_read(
@@ -56,8 +61,13 @@ NTSTATUS cx_init(
     // I don't fully understand what each value is doing, nor if/why they are required
 
     cx_init_cdt(dev_ctx);
-    cx_init_risc(dev_ctx);
-    cx_init_cmds(dev_ctx);
+
+    // the program is built with the ring, see cx_ensure_ring
+    if (dev_ctx->ring.size)
+    {
+        cx_init_risc(dev_ctx);
+        cx_init_cmds(dev_ctx);
+    }
 
     // clear interrupt
     cx_write(dev_ctx, CX_DMAC_VIDEO_INTERRUPT_STATUS_ADDR, cx_read(dev_ctx, CX_DMAC_VIDEO_INTERRUPT_STATUS_ADDR));
@@ -81,7 +91,7 @@ NTSTATUS cx_init(
     cx_write(dev_ctx, CX_VIDEO_VBI_PACKET_SIZE_DELAY_ADDR,
         (CX_VIDEO_VBI_PACKET_SIZE_DELAY) {
             .vbi_v_del = 2,
-            .frm_size = CX_CDT_BUF_LEN
+            .frm_size = dev_ctx->fifo.cdt_len
         }.dword);
 
     // raw mode & byte swap << 8 (3 << 8 = swap)
@@ -191,14 +201,15 @@ NTSTATUS cx_init_cdt(
 )
 {
     NTSTATUS status = STATUS_SUCCESS;
-    ULONG cdt_ptr = CX_SRAM_CDT_BASE;
-    ULONG buf_ptr = CX_SRAM_CDT_BUF_BASE;
+    PCX_FIFO_GEOMETRY fifo = &dev_ctx->fifo;
+    ULONG cdt_ptr = fifo->cdt_base;
+    ULONG buf_ptr = fifo->buf_base;
 
-    TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "init cdt table (%d * %d)",
-        CX_CDT_BUF_COUNT, CX_CDT_BUF_LEN);
+    TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "init cdt table (%u * %u) at %06X",
+        fifo->cdt_count, fifo->cdt_len, fifo->buf_base);
 
     // set cluster buffer location
-    for (ULONG i = 0; i < CX_CDT_BUF_COUNT; i++)
+    for (ULONG i = 0; i < fifo->cdt_count; i++)
     {
         cx_write_buf8(dev_ctx, cdt_ptr,
             (CX_CDT_DESCRIPTOR) {
@@ -207,25 +218,25 @@ NTSTATUS cx_init_cdt(
             sizeof(CX_CDT_DESCRIPTOR));
 
         cdt_ptr += sizeof(CX_CDT_DESCRIPTOR);
-        buf_ptr += CX_CDT_BUF_LEN;
+        buf_ptr += fifo->cdt_len;
     }
 
     // size of one buffer - 1
     cx_write(dev_ctx, CX_DMAC_VBI_CNT1_ADDR,
         (CX_DMAC_DMA_CNT1) {
-            .dma_cnt1 = CX_CDT_BUF_LEN / 8 - 1
+            .dma_cnt1 = fifo->cdt_len / 8 - 1
         }.dword);
 
     // ptr to cdt
     cx_write(dev_ctx, CX_DMAC_VBI_PTR2_ADDR,
         (CX_DMAC_DMA_PTR2) {
-            .dma_ptr2 = CX_SRAM_CDT_BASE >> 2
+            .dma_ptr2 = fifo->cdt_base >> 2
         }.dword);
 
     // size of cdt
     cx_write(dev_ctx, CX_DMAC_VBI_CNT2_ADDR,
         (CX_DMAC_DMA_CNT2) {
-            .dma_cnt2 = CX_CDT_BUF_COUNT * 2
+            .dma_cnt2 = fifo->cdt_count * 2
         }.dword);
 
     return status;
@@ -236,73 +247,54 @@ NTSTATUS cx_init_risc(
 )
 {
     NTSTATUS status = STATUS_SUCCESS;
-    PCX_RISC_INSTRUCTIONS dma_instr_ptr = (PCX_RISC_INSTRUCTIONS)dev_ctx->dma_risc_instr.va;
+    CX_RISC_PROG prog;
 
-    TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "dma phys addr %08X", dev_ctx->dma_risc_instr.la.LowPart);
+    TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "dma phys addr %08X", dev_ctx->risc_prog.bufs[0].addr);
+
+    TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "irq period %u kbytes",
+        cx_ring_set_irq_period(&dev_ctx->ring, dev_ctx->attrs.irq_period) / 1024);
 
     // the following comments are from the Linux driver, as they explain the logic sufficiently
 
-    // The RISC program is just a long sequence of WRITEs that fill each DMA page in
+    // The RISC program is just a long sequence of WRITEs that fill each DMA chunk in
     // sequence. It begins with a SYNC and ends with a JUMP back to the first WRITE.
 
-    dma_instr_ptr->sync_instr = (CX_RISC_INSTR_SYNC)
-    {
-        .opcode = CX_RISC_INSTR_SYNC_OPCODE,
-        .cnt_ctl = 3,
-    };
+    // here the sequence is split over the program buffers, each ending in a JUMP to the next
+    cx_risc_prog_begin(&prog, dev_ctx->risc_prog.bufs, dev_ctx->risc_prog.count);
 
-    for (ULONG page_idx = 0; page_idx < CX_VBI_BUF_COUNT; page_idx++)
+    if (dev_ctx->user_sg)
     {
-        ULONG dma_page_addr = dev_ctx->dma_risc_page[page_idx].la.LowPart;
-
-        // Each WRITE is CX_CDT_BUF_LEN bytes so each DMA page requires
-        //  n = (PAGE_SIZE / CX_CDT_BUF_LEN) WRITEs to fill it.
-
-        // Generate n WRITEs.
-        for (ULONG write_idx = 0; write_idx < (PAGE_SIZE / CX_CDT_BUF_LEN); write_idx++)
+        // a client ring is attached, the WRITEs target its pages directly
+        if (!cx_risc_write_sg(&prog, &dev_ctx->ring, dev_ctx->fifo.cdt_len, dev_ctx->user_sg, dev_ctx->user_sg_count))
         {
-            PCX_RISC_INSTR_WRITE write_instr = &dma_instr_ptr->write_instr[(page_idx * 2) + write_idx];
-
-            *write_instr = (CX_RISC_INSTR_WRITE)
-            {
-                .opcode = CX_RISC_INSTR_WRITE_OPCODE,
-                .sol = 1,
-                .eol = 1,
-                .byte_count = CX_CDT_BUF_LEN,
-                .pci_target_address = dma_page_addr
-            };
-
-            dma_page_addr += CX_CDT_BUF_LEN;
-
-            if (write_idx == (PAGE_SIZE / CX_CDT_BUF_LEN) - 1)
-            {
-                // always increment final write 
-                write_instr->cnt_ctl = 1;
-
-                //  reset counter on last page
-                if (page_idx == (CX_VBI_BUF_COUNT - 1))
-                {
-                    write_instr->cnt_ctl = 3;
+            status = STATUS_BUFFER_TOO_SMALL;
+        }
     }
-
-                // trigger IRQ1
-                if (((page_idx + 1) % CX_IRQ_PERIOD_IN_PAGES) == 0)
-                {
-                    write_instr->irq1 = 1;
-                }
+    else
+    {
+        for (ULONG chunk_idx = 0; chunk_idx < dev_ctx->ring.chunk_count && NT_SUCCESS(status); chunk_idx++)
+        {
+            if (!cx_risc_prog_write(&prog, &dev_ctx->ring, dev_ctx->fifo.cdt_len,
+                dev_ctx->dma_risc_chunk[chunk_idx].la.LowPart,
+                dev_ctx->ring.chunk_size))
+            {
+                status = STATUS_BUFFER_TOO_SMALL;
             }
         }
     }
 
-    // Jump back to first WRITE (+4 skips the SYNC command.)
-    dma_instr_ptr->jump_instr = (CX_RISC_INSTR_JUMP)
+    // cannot happen, the buffers are counted from the same ring size & cdt_len
+    if (!NT_SUCCESS(status))
     {
-        .opcode = CX_RISC_INSTR_JUMP_OPCODE,
-        .jump_address = dev_ctx->dma_risc_instr.la.LowPart + 4
-    };
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "%u risc buffers too few for %u kbyte ring",
+            dev_ctx->risc_prog.count, dev_ctx->ring.size / 1024);
+    }
 
-    TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "filled risc instr dma, total size %lu kbyte",
-        sizeof(CX_RISC_INSTRUCTIONS) / 1024);
+    // Jump back to first WRITE (+4 skips the SYNC command.)
+    cx_risc_prog_end(&prog);
+
+    TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "filled risc instr dma, %u of %u buffers",
+        prog.buf_idx + 1, prog.buf_count);
 
     return status;
 }
@@ -316,9 +308,9 @@ NTSTATUS cx_init_cmds(
     // init sram
     cx_write_buf8(dev_ctx, CX_SRAM_CMDS_VBI_BASE,
         (CX_CMDS) {
-            .initial_risc_addr = dev_ctx->dma_risc_instr.la.LowPart,
-            .cdt_base = CX_SRAM_CDT_BASE,
-            .cdt_size = CX_CDT_BUF_COUNT * 2,
+            .initial_risc_addr = dev_ctx->risc_prog.bufs[0].addr,
+            .cdt_base = dev_ctx->fifo.cdt_base,
+            .cdt_size = dev_ctx->fifo.cdt_count * 2,
             .risc_base = CX_SRAM_RISC_QUEUE_BASE,
             .risc_size = 0x40
         }.data,
@@ -439,23 +431,44 @@ BOOLEAN cx_evt_isr(
         .dword = cx_read(dev_ctx, CX_DMAC_VIDEO_INTERRUPT_MSTATUS_ADDR)
     };
 
-    if (!mstat.vbi_risci1 && mstat.dword)
+    if (mstat.dword)
+    {
+        InterlockedIncrement64(&dev_ctx->stats.interrupts);
+    }
+
+    ULONG cause =
+        (mstat.vbif_of ? CX_EVENT_FIFO_OVERFLOW : 0) |
+        (mstat.vbi_sync ? CX_EVENT_SYNC_ERROR : 0) |
+        (mstat.opc_err ? CX_EVENT_OPCODE_ERROR : 0);
+
+    if (!mstat.vbi_risci1 && !cause && mstat.dword)
     {
+        InterlockedIncrement64(&dev_ctx->stats.unknown_interrupts);
+
         // unexpected interrupts?
         TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "intr stat 0x%0X masked 0x%0X",
             cx_read(dev_ctx, CX_DMAC_VIDEO_INTERRUPT_STATUS_ADDR),
             mstat.dword);
     }
 
+    if (cause)
+    {
+        is_recognized = TRUE;
+        cx_record_event(dev_ctx, cause);
+    }
+
     if (mstat.vbi_risci1)
     {
         is_recognized = TRUE;
+
+        // keep the oldest interrupt a dpc has not handled yet
+        InterlockedCompareExchange64(&dev_ctx->state.isr_timestamp, KeQueryPerformanceCounter(NULL).QuadPart, 0);
     }
 
     // clear interrupts
     cx_write(dev_ctx, CX_DMAC_VIDEO_INTERRUPT_STATUS_ADDR, mstat.dword);
 
-    if (is_recognized)
+    if (mstat.vbi_risci1)
     {
         WdfInterruptQueueDpcForIsr(intr);
     }
@@ -463,6 +476,35 @@ BOOLEAN cx_evt_isr(
     return is_recognized;
 }
 
+// log an error interrupt with where the engine had got to, called from the isr
+VOID cx_record_event(
+    _Inout_ PDEVICE_CONTEXT dev_ctx,
+    _In_ ULONG cause
+)
+{
+    ULONG raw_gp_cnt = cx_read(dev_ctx, CX_VIDEO_VBI_GP_COUNTER_ADDR);
+    LONG64 stream_pos = -1;
+
+    if (dev_ctx->state.capture.is_capturing && dev_ctx->state.initial_page >= 0)
+    {
+        stream_pos = dev_ctx->state.write_pos +
+            cx_ring_gp_delta(&dev_ctx->ring, dev_ctx->state.last_gp_cnt, (LONG)raw_gp_cnt);
+    }
+
+    if (cause & CX_EVENT_FIFO_OVERFLOW)
+    {
+        dev_ctx->state.ouflow_count += 1;
+        InterlockedOr(&dev_ctx->state.pending_flags, CX_FRAME_FLAG_OUFLOW);
+    }
+
+    cx_event_record(dev_ctx->events,
+        &dev_ctx->state.event_seq,
+        cause,
+        raw_gp_cnt,
+        stream_pos,
+        KeQueryPerformanceCounter(NULL).QuadPart);
+}
+
 VOID cx_evt_dpc(
     _In_ WDFINTERRUPT intr,
     _In_ WDFOBJECT dev
@@ -478,10 +520,113 @@ VOID cx_evt_dpc(
     // to main memory. on the other hand, if an interrupt has occurred, we are guaranteed to have the page
     // in main memory. so we only retrieve CX_VBI_GP_CNT after an interrupt has occurred and then round
     // it down to the last page that we know should have triggered an interrupt.
-    InterlockedExchange(&dev_ctx->state.last_gp_cnt,
-        cx_read(dev_ctx, CX_VIDEO_VBI_GP_COUNTER_ADDR) & ~(CX_IRQ_PERIOD_IN_PAGES - 1));
+    // gp_cnt counts units of ring.gp_size bytes rather than pages here
+    LARGE_INTEGER timestamp = KeQueryPerformanceCounter(NULL);
+    InterlockedIncrement64(&dev_ctx->stats.dpc_count);
+
+    LONG64 isr_timestamp = InterlockedExchange64(&dev_ctx->state.isr_timestamp, 0);
+
+    if (isr_timestamp)
+    {
+        cx_hist_add(&dev_ctx->latency[CX_LATENCY_ISR_TO_DPC], timestamp.QuadPart - isr_timestamp);
+    }
+
+    ULONG raw_gp_cnt = cx_read(dev_ctx, CX_VIDEO_VBI_GP_COUNTER_ADDR);
+    cx_publish_gp_cnt(dev_ctx, timestamp.QuadPart, raw_gp_cnt, cx_ring_gp_round(&dev_ctx->ring, raw_gp_cnt));
+}
+
+// polling mode, samples the gp counter in place of the risc interrupt & dpc and re-arms itself
+VOID cx_evt_poll_timer(
+    _In_ WDFTIMER timer
+)
+{
+    PDEVICE_CONTEXT dev_ctx = cx_device_get_ctx(WdfTimerGetParentObject(timer));
+    LONG poll_period = dev_ctx->state.poll_period;
+
+    if (!dev_ctx->state.capture.is_capturing || !poll_period)
+    {
+        return;
+    }
+
+    LONG64 timestamp = KeQueryPerformanceCounter(NULL).QuadPart;
+    InterlockedIncrement64(&dev_ctx->stats.dpc_count);
+
+    ULONG raw_gp_cnt = cx_read(dev_ctx, CX_VIDEO_VBI_GP_COUNTER_ADDR);
+    LONG last_gp_cnt = dev_ctx->state.initial_page < 0 ? -1 : dev_ctx->state.last_gp_cnt;
+
+    cx_publish_gp_cnt(dev_ctx, timestamp, raw_gp_cnt, cx_ring_gp_poll(&dev_ctx->ring, last_gp_cnt, raw_gp_cnt));
+
+    WdfTimerStart(timer, WDF_REL_TIMEOUT_IN_US(poll_period));
+}
+
+// advance write_pos to gp_cnt, a gp_cnt known to be in memory, and wake the reads
+// called from the dpc or the poll timer, never both for one capture
+VOID cx_publish_gp_cnt(
+    _Inout_ PDEVICE_CONTEXT dev_ctx,
+    _In_ LONG64 timestamp,
+    _In_ ULONG raw_gp_cnt,
+    _In_ LONG gp_cnt
+)
+{
+    LONG prev_gp_cnt = InterlockedExchange(&dev_ctx->state.last_gp_cnt, gp_cnt);
+
+    // over/underflows seen by the isr since the last dpc
+    ULONG flags = (ULONG)InterlockedExchange(&dev_ctx->state.pending_flags, 0);
+
+    // first interrupt of this capture, readers start here
+    if (dev_ctx->state.initial_page < 0)
+    {
+        InterlockedExchange(&dev_ctx->state.initial_page, gp_cnt);
+        InterlockedExchange64(&dev_ctx->state.write_pos, 0);
+    }
+    // nothing new since the last dpc or poll tick, over/underflows wait for the next block
+    else if (gp_cnt == prev_gp_cnt)
+    {
+        InterlockedOr(&dev_ctx->state.pending_flags, flags);
+        return;
+    }
+    else
+    {
+        LONG64 delta = cx_ring_gp_delta(&dev_ctx->ring, prev_gp_cnt, gp_cnt);
+        LONG64 write_pos = dev_ctx->state.write_pos;
+
+        // record the block before publishing it
+        if (delta)
+        {
+            PCX_BLOCK_INFO block = &dev_ctx->blocks[dev_ctx->state.block_seq % dev_ctx->block_count];
+
+            InterlockedExchange64(&block->sequence, -1);
+
+            block->start_pos = write_pos;
+            block->end_pos = write_pos + delta;
+            block->timestamp = timestamp;
+            block->gp_cnt = raw_gp_cnt;
+            block->flags = flags;
+            block->attrs = (CX_FRAME_ATTRS) {
+                .vmux = dev_ctx->attrs.vmux,
+                .level = dev_ctx->attrs.level,
+                .tenbit = dev_ctx->attrs.tenbit,
+                .sixdb = dev_ctx->attrs.sixdb,
+                .center_offset = dev_ctx->attrs.center_offset,
+                .irq_period = dev_ctx->ring.irq_period
+            };
 
-    KeSetEvent(&dev_ctx->isr_event, IO_NO_INCREMENT, FALSE);
+            InterlockedExchange64(&block->sequence, dev_ctx->state.block_seq);
+            InterlockedIncrement64(&dev_ctx->state.block_seq);
+        }
+
+        InterlockedAdd64(&dev_ctx->state.write_pos, delta);
+        InterlockedAdd64(&dev_ctx->stats.bytes_produced, delta);
+    }
+
+    cx_update_ring_hdr(dev_ctx);
+
+    // fill & complete pending reads once one of them can take all it is waiting for
+    if (cx_wake_due(&dev_ctx->state.write_pos, &dev_ctx->state.wake_pos))
+    {
+        InterlockedCompareExchange64(&dev_ctx->state.dpc_timestamp, timestamp, 0);
+        WdfWorkItemEnqueue(dev_ctx->read_work_item);
+    }
 }
 
 NTSTATUS cx_evt_intr_enable(
@@ -524,14 +669,84 @@ VOID cx_start_capture(
     _Inout_ PDEVICE_CONTEXT dev_ctx
 )
 {
-    if (dev_ctx->state.is_capturing)
+    if (!cx_arm_capture(dev_ctx))
     {
-        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "already capturing");
         return;
     }
 
     TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "starting capture");
 
+    cx_run_capture(dev_ctx);
+    cx_start_poll(dev_ctx);
+    cx_update_ring_hdr(dev_ctx);
+}
+
+// claim the device for a capture and reset the stream state, nothing is started yet
+// readers see is_capturing from here on and wait for data
+BOOLEAN cx_arm_capture(
+    _Inout_ PDEVICE_CONTEXT dev_ctx
+)
+{
+    if (!cx_capture_arm(&dev_ctx->state.capture))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "already capturing");
+        return FALSE;
+    }
+
+    // irq period is fixed for the duration of a capture, rebuild the program if it changed
+    if (dev_ctx->ring.irq_period != dev_ctx->attrs.irq_period)
+    {
+        cx_init_risc(dev_ctx);
+    }
+
+    // so is the publishing mode, a tick left over from the last capture must not run into this one
+    WdfTimerStop(dev_ctx->poll_timer, TRUE);
+    dev_ctx->state.poll_period = dev_ctx->attrs.poll_rate ? 1000000 / dev_ctx->attrs.poll_rate : 0;
+
+    // and how far behind the head data counts as overwritten, which depends on it
+    TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "overwrite margin %u kbytes",
+        cx_ring_set_poll_rate(&dev_ctx->ring, dev_ctx->attrs.poll_rate) / 1024);
+
+    // readers of the previous capture's history lose it from here on
+    InterlockedIncrement(&dev_ctx->state.capture_id);
+
+    // set by the first interrupt
+    InterlockedExchange(&dev_ctx->state.initial_page, -1);
+    InterlockedExchange64(&dev_ctx->state.write_pos, 0);
+    InterlockedExchange64(&dev_ctx->state.wake_pos, 0);
+
+    // latency stages start with the first interrupt
+    InterlockedExchange64(&dev_ctx->state.isr_timestamp, 0);
+    InterlockedExchange64(&dev_ctx->state.dpc_timestamp, 0);
+
+    // block info for framed reads
+    LARGE_INTEGER freq;
+    KeQueryPerformanceCounter(&freq);
+    dev_ctx->state.timestamp_freq = freq.QuadPart;
+    dev_ctx->state.block_seq = 0;
+
+    for (ULONG i = 0; i < dev_ctx->block_count; i++)
+    {
+        dev_ctx->blocks[i].sequence = -1;
+    }
+
+    return TRUE;
+}
+
+// release a device armed by cx_arm_capture that was never run
+VOID cx_disarm_capture(
+    _Inout_ PDEVICE_CONTEXT dev_ctx
+)
+{
+    cx_capture_disarm(&dev_ctx->state.capture);
+    cx_update_ring_hdr(dev_ctx);
+}
+
+// start an armed device, only register writes & reads so it can run at any irql
+VOID cx_run_capture(
+    _Inout_ PDEVICE_CONTEXT dev_ctx
+)
+{
     // enable fifo and risc
     cx_write(dev_ctx, CX_DMAC_DEVICE_CONTROL_2_ADDR,
         (CX_DMAC_DEVICE_CONTROL_2) {
@@ -544,17 +759,31 @@ VOID cx_start_capture(
             .vbi_risc_en = 1
         }.dword);
 
-    // turn on interrupt
+    // turn on interrupt, only the errors when polling
+    BOOLEAN use_risci = !dev_ctx->state.poll_period;
+
     cx_write(dev_ctx, CX_DMAC_VIDEO_INTERRUPT_MASK_ADDR,
         (CX_DMAC_VIDEO_INTERRUPT) {
-            .vbi_risci1 = 1,
-            .vbi_risci2 = 1,
+            .vbi_risci1 = use_risci,
+            .vbi_risci2 = use_risci,
             .vbif_of = 1,
             .vbi_sync = 1,
             .opc_err = 1
         }.dword);
 
-    InterlockedExchange((PLONG)&dev_ctx->state.is_capturing, TRUE);
+    dev_ctx->state.start_timestamp = KeQueryPerformanceCounter(NULL).QuadPart;
+    dev_ctx->state.start_gp_cnt = cx_read(dev_ctx, CX_VIDEO_VBI_GP_COUNTER_ADDR);
+}
+
+// first tick of a polling capture started by cx_run_capture, which may run above dispatch
+VOID cx_start_poll(
+    _Inout_ PDEVICE_CONTEXT dev_ctx
+)
+{
+    if (dev_ctx->state.poll_period)
+    {
+        WdfTimerStart(dev_ctx->poll_timer, WDF_REL_TIMEOUT_IN_US(dev_ctx->state.poll_period));
+    }
 }
 
 VOID cx_stop_capture(
@@ -563,7 +792,7 @@ VOID cx_stop_capture(
 {
     TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "stopping capture");
 
-    InterlockedExchange((PLONG)&dev_ctx->state.is_capturing, FALSE);
+    cx_capture_stop(&dev_ctx->state.capture);
 
     // turn off interrupt
     cx_write(dev_ctx, CX_DMAC_VIDEO_INTERRUPT_MASK_ADDR, 0);
@@ -574,6 +803,40 @@ VOID cx_stop_capture(
 
     // disable risc
     cx_write(dev_ctx, CX_DMAC_DEVICE_CONTROL_2_ADDR, 0);
+
+    // a tick already running sees is_capturing clear and does not re-arm
+    WdfTimerStop(dev_ctx->poll_timer, FALSE);
+
+    // the kernel ring may go once it has been unused for ring_release
+    if (dev_ctx->attrs.ring_release && !dev_ctx->user_sg)
+    {
+        dev_ctx->state.release_time = (LONG64)KeQueryInterruptTime();
+        WdfTimerStart(dev_ctx->release_timer, WDF_REL_TIMEOUT_IN_MS(dev_ctx->attrs.ring_release));
+    }
+
+    cx_update_ring_hdr(dev_ctx);
+
+    // complete pending reads with whatever they have
+    WdfWorkItemEnqueue(dev_ctx->read_work_item);
+}
+
+VOID cx_update_ring_hdr(
+    _Inout_ PDEVICE_CONTEXT dev_ctx
+)
+{
+    PCX_RING_HEADER hdr = dev_ctx->ring_hdr;
+
+    if (!hdr)
+    {
+        return;
+    }
+
+    InterlockedExchange(&hdr->is_capturing, dev_ctx->state.capture.is_capturing);
+    InterlockedExchange(&hdr->initial_page, dev_ctx->state.initial_page);
+    InterlockedExchange(&hdr->last_gp_cnt, dev_ctx->state.last_gp_cnt);
+
+    // published last, consumers may read up to write_pos once it changes
+    InterlockedExchange64(&hdr->write_pos, dev_ctx->state.write_pos);
 }
 
 VOID cx_set_vmux(
@@ -629,29 +892,3 @@ VOID cx_set_center_offset(
             .low_stip_th = 0x1E48
         }.dword);
 }
-
-BOOLEAN cx_get_ouflow_state(
-    _Inout_ PDEVICE_CONTEXT dev_ctx
-)
-{
-    CX_VIDEO_DEVICE_STATUS status =
-    {
-        .dword = cx_read(dev_ctx, CX_VIDEO_DEVICE_STATUS_ADDR)
-    };
-
-    return status.lof ? TRUE : FALSE;
-}
-
-VOID cx_reset_ouflow_state(
-    _Inout_ PDEVICE_CONTEXT dev_ctx
-)
-{
-    CX_VIDEO_DEVICE_STATUS status =
-    {
-        .dword = cx_read(dev_ctx, CX_VIDEO_DEVICE_STATUS_ADDR)
-    };
-
-    status.lof = 0;
-
-    cx_write(dev_ctx, CX_VIDEO_DEVICE_STATUS_ADDR, status.dword);
-}
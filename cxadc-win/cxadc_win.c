@@ -16,6 +16,7 @@
 #include "cxadc_win.tmh"
 
 #include "cx2388x.h"
+#include "fifo.h"
 #include "ioctl.h"
 
 #ifdef ALLOC_PRAGMA
@@ -32,13 +33,26 @@
 #pragma alloc_text (PAGE, cx_init_interrupt)
 #pragma alloc_text (PAGE, cx_init_device_ctx)
 #pragma alloc_text (PAGE, cx_init_dma)
+#pragma alloc_text (PAGE, cx_alloc_ring)
+#pragma alloc_text (PAGE, cx_free_ring)
+#pragma alloc_text (PAGE, cx_init_dma_chunks)
+#pragma alloc_text (PAGE, cx_free_dma_chunks)
+#pragma alloc_text (PAGE, cx_alloc_risc_prog)
+#pragma alloc_text (PAGE, cx_free_risc_prog)
+#pragma alloc_text (PAGE, cx_init_ring_hdr)
+#pragma alloc_text (PAGE, cx_init_ring_mdl)
 #pragma alloc_text (PAGE, cx_init_queue)
 #pragma alloc_text (PAGE, cx_check_dev_info)
 #pragma alloc_text (PAGE, cx_read_device_prop)
+#pragma alloc_text (PAGE, cx_read_reg_param)
 #endif
 
 UCHAR dev_count = 0;
 
+// devices by dev_idx, for requests that span devices
+PDEVICE_CONTEXT dev_list[MAXUCHAR + 1];
+KSPIN_LOCK dev_list_lock;
+
 NTSTATUS DriverEntry(
     _In_    PDRIVER_OBJECT  driver_obj,
     _In_    PUNICODE_STRING reg_path
@@ -51,6 +65,8 @@ NTSTATUS DriverEntry(
     WPP_INIT_TRACING(driver_obj, reg_path);
     TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "cxadc-win entry");
 
+    KeInitializeSpinLock(&dev_list_lock);
+
     WDF_OBJECT_ATTRIBUTES_INIT(&attrs);
     attrs.EvtCleanupCallback = cx_evt_driver_ctx_cleanup;
 
@@ -98,6 +114,14 @@ NTSTATUS cx_evt_device_add(
     WDF_OBJECT_ATTRIBUTES_INIT_CONTEXT_TYPE(&file_attrs, FILE_CONTEXT);
     WdfDeviceInitSetFileObjectConfig(dev_init, &file_obj_cfg, &file_attrs);
 
+    // mapping ioctls, see cx_evt_io_in_caller_context
+    WdfDeviceInitSetIoInCallerContextCallback(dev_init, cx_evt_io_in_caller_context);
+
+    // request context, tracks progress of parked reads
+    WDF_OBJECT_ATTRIBUTES req_attrs;
+    WDF_OBJECT_ATTRIBUTES_INIT_CONTEXT_TYPE(&req_attrs, REQUEST_CONTEXT);
+    WdfDeviceInitSetRequestAttributes(dev_init, &req_attrs);
+
     WDF_OBJECT_ATTRIBUTES_INIT_CONTEXT_TYPE(&dev_attrs, DEVICE_CONTEXT);
     dev_attrs.EvtCleanupCallback = cx_evt_device_cleanup;
 
@@ -165,9 +189,42 @@ VOID cx_evt_device_cleanup(
     _In_ WDFOBJECT driver_obj
 )
 {
-    UNREFERENCED_PARAMETER(driver_obj);
     PAGED_CODE();
-    // nothing to do ??
+
+    PDEVICE_CONTEXT dev_ctx = cx_device_get_ctx(driver_obj);
+
+    cx_unregister_device(dev_ctx);
+
+    // the common buffers are children of the dma enabler and are deleted with it
+    if (dev_ctx->ring_mdl)
+    {
+        IoFreeMdl(dev_ctx->ring_mdl);
+        dev_ctx->ring_mdl = NULL;
+    }
+
+    if (dev_ctx->dma_risc_chunk)
+    {
+        ExFreePoolWithTag(dev_ctx->dma_risc_chunk, CX_POOL_TAG);
+        dev_ctx->dma_risc_chunk = NULL;
+    }
+
+    if (dev_ctx->blocks)
+    {
+        ExFreePoolWithTag(dev_ctx->blocks, CX_POOL_TAG);
+        dev_ctx->blocks = NULL;
+    }
+
+    if (dev_ctx->ring_hdr_mdl)
+    {
+        IoFreeMdl(dev_ctx->ring_hdr_mdl);
+        dev_ctx->ring_hdr_mdl = NULL;
+    }
+
+    if (dev_ctx->ring_hdr)
+    {
+        ExFreePoolWithTag(dev_ctx->ring_hdr, CX_POOL_TAG);
+        dev_ctx->ring_hdr = NULL;
+    }
 }
 
 VOID cx_evt_driver_ctx_cleanup(
@@ -424,12 +481,71 @@ NTSTATUS cx_init_device_ctx(
     // init state
     cx_init_state(dev_ctx);
 
-    // init interrupt event
-    KeInitializeEvent(&dev_ctx->isr_event, NotificationEvent, FALSE);
+    cx_register_device(dev_ctx);
 
     return status;
 }
 
+VOID cx_register_device(
+    _In_ PDEVICE_CONTEXT dev_ctx
+)
+{
+    KIRQL irql;
+
+    KeAcquireSpinLock(&dev_list_lock, &irql);
+    dev_list[dev_ctx->dev_idx] = dev_ctx;
+    KeReleaseSpinLock(&dev_list_lock, irql);
+}
+
+VOID cx_unregister_device(
+    _In_ PDEVICE_CONTEXT dev_ctx
+)
+{
+    KIRQL irql;
+
+    KeAcquireSpinLock(&dev_list_lock, &irql);
+
+    if (dev_list[dev_ctx->dev_idx] == dev_ctx)
+    {
+        dev_list[dev_ctx->dev_idx] = NULL;
+    }
+
+    KeReleaseSpinLock(&dev_list_lock, irql);
+}
+
+// look up a device by dev_idx, a returned device is referenced until cx_put_device
+PDEVICE_CONTEXT cx_get_device(
+    _In_ ULONG dev_idx
+)
+{
+    PDEVICE_CONTEXT dev_ctx = NULL;
+    KIRQL irql;
+
+    if (dev_idx > MAXUCHAR)
+    {
+        return NULL;
+    }
+
+    KeAcquireSpinLock(&dev_list_lock, &irql);
+    dev_ctx = dev_list[dev_idx];
+
+    if (dev_ctx)
+    {
+        WdfObjectReference(dev_ctx->dev);
+    }
+
+    KeReleaseSpinLock(&dev_list_lock, irql);
+
+    return dev_ctx;
+}
+
+VOID cx_put_device(
+    _In_ PDEVICE_CONTEXT dev_ctx
+)
+{
+    WdfObjectDereference(dev_ctx->dev);
+}
+
 NTSTATUS cx_init_dma(
     _In_ PDEVICE_CONTEXT dev_ctx
 )
@@ -439,7 +555,7 @@ NTSTATUS cx_init_dma(
 
     WDF_DMA_ENABLER_CONFIG dma_cfg;
 
-    WDF_DMA_ENABLER_CONFIG_INIT(&dma_cfg, WdfDmaProfilePacket, CX_VBI_BUF_SIZE);
+    WDF_DMA_ENABLER_CONFIG_INIT(&dma_cfg, WdfDmaProfilePacket, CX_IOCTL_RING_SIZE_DEFAULT);
     dma_cfg.WdmDmaVersionOverride = 3;
 
     status = WdfDmaEnablerCreate(dev_ctx->dev, &dma_cfg, WDF_NO_OBJECT_ATTRIBUTES, &dev_ctx->dma_enabler);
@@ -450,50 +566,396 @@ NTSTATUS cx_init_dma(
         return status;
     }
 
+    // a client ring is mapped through the adapter, which knows about dma remapping & the 32-bit limit
+    WDF_DMA_ENABLER_CONFIG_INIT(&dma_cfg, WdfDmaProfileScatterGather, CX_IOCTL_RING_SIZE_MAX);
+    dma_cfg.WdmDmaVersionOverride = 3;
+
+    status = WdfDmaEnablerCreate(dev_ctx->dev, &dma_cfg, WDF_NO_OBJECT_ATTRIBUTES, &dev_ctx->user_dma_enabler);
+
+    if (!NT_SUCCESS(status))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "WdfDmaEnablerCreate (scatter/gather) failed with status %!STATUS!", status);
+        return status;
+    }
+
+    // shared header, lives as long as the device so the ring can be resized underneath it
+    status = cx_init_ring_hdr(dev_ctx);
+
+    if (!NT_SUCCESS(status))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "cx_init_ring_hdr failed with status %!STATUS!", status);
+        return status;
+    }
+
+    ULONG ring_size = cx_read_reg_param(dev_ctx, L"RingSize", CX_IOCTL_RING_SIZE_DEFAULT);
+
+    if (!cx_valid_ring_size(ring_size))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid RingSize %u, using %u", ring_size, CX_IOCTL_RING_SIZE_DEFAULT);
+        ring_size = CX_IOCTL_RING_SIZE_DEFAULT;
+    }
+
+    dev_ctx->dma_chunk_size = cx_read_reg_param(dev_ctx, L"DmaChunkSize", CX_DMA_CHUNK_SIZE_MAX);
+
+    if (dev_ctx->dma_chunk_size < CX_DMA_CHUNK_SIZE_MIN ||
+        dev_ctx->dma_chunk_size > CX_DMA_CHUNK_SIZE_MAX ||
+        (dev_ctx->dma_chunk_size & (dev_ctx->dma_chunk_size - 1)))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid DmaChunkSize %u, using %u", dev_ctx->dma_chunk_size, CX_DMA_CHUNK_SIZE_MAX);
+        dev_ctx->dma_chunk_size = CX_DMA_CHUNK_SIZE_MAX;
+    }
+
+    // fifo clusters set the size of every RISC WRITE, so they are fixed before the program is built
+    ULONG cdt_len = cx_read_reg_param(dev_ctx, L"CdtBufLen", 0);
+    ULONG cdt_count = cx_read_reg_param(dev_ctx, L"CdtBufCount", 0);
+    ULONG fifo_preset = cx_read_reg_param(dev_ctx, L"FifoPreset", CX_FIFO_PRESET_DEFAULT);
+
+    if (cdt_len || cdt_count)
+    {
+        if (!cx_fifo_plan(&dev_ctx->fifo, cdt_len, cdt_count))
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid CdtBufLen %u / CdtBufCount %u, using preset %u",
+                cdt_len, cdt_count, fifo_preset);
+        }
+    }
+
+    if (!dev_ctx->fifo.size && !cx_fifo_preset(&dev_ctx->fifo, fifo_preset))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid FifoPreset %u, using %u", fifo_preset, CX_FIFO_PRESET_DEFAULT);
+        cx_fifo_preset(&dev_ctx->fifo, CX_FIFO_PRESET_DEFAULT);
+    }
+
+    // allocated by the first capture, a card that is never used holds no ring
+    dev_ctx->ring_alloc_size = ring_size;
+
+    return status;
+}
+
+BOOLEAN cx_valid_ring_size(
+    _In_ ULONG ring_size
+)
+{
+    return ring_size >= CX_IOCTL_RING_SIZE_MIN &&
+        ring_size <= CX_IOCTL_RING_SIZE_MAX &&
+        (ring_size % CX_IOCTL_RING_SIZE_ALIGN) == 0;
+}
+
+NTSTATUS cx_alloc_ring(
+    _In_ PDEVICE_CONTEXT dev_ctx,
+    _In_ ULONG ring_size
+)
+{
+    NTSTATUS status = STATUS_SUCCESS;
+    PAGED_CODE();
+
     // risc instructions
-    dev_ctx->dma_risc_instr.len = CX_RISC_INSTR_BUF_SIZE;
-    status = WdfCommonBufferCreate(dev_ctx->dma_enabler, dev_ctx->dma_risc_instr.len, WDF_NO_OBJECT_ATTRIBUTES, &dev_ctx->dma_risc_instr.buf);
+    status = cx_alloc_risc_prog(dev_ctx, ring_size, &dev_ctx->risc_prog);
 
     if (!NT_SUCCESS(status))
     {
-        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "WdfCommonBufferCreate failed with status %!STATUS!", status);
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "cx_alloc_risc_prog failed with status %!STATUS!", status);
         return status;
     }
 
-    dev_ctx->dma_risc_instr.va = WdfCommonBufferGetAlignedVirtualAddress(dev_ctx->dma_risc_instr.buf);
-    dev_ctx->dma_risc_instr.la = WdfCommonBufferGetAlignedLogicalAddress(dev_ctx->dma_risc_instr.buf);
+    // data chunks, fall back to smaller chunks if memory is too fragmented
+    ULONG chunk_size = dev_ctx->dma_chunk_size;
 
-    RtlZeroMemory(dev_ctx->dma_risc_instr.va, dev_ctx->dma_risc_instr.len);
+    while (TRUE)
+    {
+        status = cx_init_dma_chunks(dev_ctx, ring_size, chunk_size);
 
-    TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "created risc instr dma 0x%p, (%I64X) (%u kbytes)",
-        dev_ctx->dma_risc_instr.va,
-        dev_ctx->dma_risc_instr.la.QuadPart,
-        (ULONG)(WdfCommonBufferGetLength(dev_ctx->dma_risc_instr.buf) / 1024));
+        if (NT_SUCCESS(status) || chunk_size <= PAGE_SIZE)
+        {
+            break;
+        }
+
+        cx_free_dma_chunks(dev_ctx);
+        chunk_size /= 2;
+
+        TraceEvents(TRACE_LEVEL_WARNING, DBG_GENERAL, "retrying with %u kbyte chunks", chunk_size / 1024);
+    }
 
-    // data pages
-    for (ULONG i = 0; i < CX_VBI_BUF_COUNT; i++)
+    if (!NT_SUCCESS(status))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "cx_init_dma_chunks failed with status %!STATUS!", status);
+        cx_free_ring(dev_ctx);
+        return status;
+    }
+
+    TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "created %u data chunks (%u kbytes), %u kbyte ring",
+        dev_ctx->ring.chunk_count,
+        dev_ctx->ring.chunk_size / 1024,
+        dev_ctx->ring.size / 1024);
+
+    // user mapping of the data pages
+    status = cx_init_ring_mdl(dev_ctx);
+
+    if (!NT_SUCCESS(status))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "cx_init_ring_mdl failed with status %!STATUS!", status);
+        cx_free_ring(dev_ctx);
+        return status;
+    }
+
+    // per-block info for framed reads, enough for a full ring at the smallest irq period
+    // plus the short block at the end of the ring
+    dev_ctx->block_count = dev_ctx->ring.size / CX_IOCTL_IRQ_PERIOD_MIN + 2;
+    dev_ctx->blocks = (PCX_BLOCK_INFO)ExAllocatePoolZero(NonPagedPoolNx,
+        dev_ctx->block_count * sizeof(CX_BLOCK_INFO), CX_POOL_TAG);
+
+    if (!dev_ctx->blocks)
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "ExAllocatePoolZero failed");
+        cx_free_ring(dev_ctx);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    dev_ctx->ring_hdr->ring_size = dev_ctx->ring.size;
+    dev_ctx->ring_hdr->gp_size = dev_ctx->ring.gp_size;
+
+    return status;
+}
+
+VOID cx_free_ring(
+    _In_ PDEVICE_CONTEXT dev_ctx
+)
+{
+    PAGED_CODE();
+
+    if (dev_ctx->ring_mdl)
+    {
+        IoFreeMdl(dev_ctx->ring_mdl);
+        dev_ctx->ring_mdl = NULL;
+    }
+
+    cx_free_dma_chunks(dev_ctx);
+
+    if (dev_ctx->blocks)
+    {
+        ExFreePoolWithTag(dev_ctx->blocks, CX_POOL_TAG);
+        dev_ctx->blocks = NULL;
+        dev_ctx->block_count = 0;
+    }
+
+    cx_free_risc_prog(&dev_ctx->risc_prog);
+
+    if (dev_ctx->ring_hdr)
+    {
+        dev_ctx->ring_hdr->ring_size = 0;
+        dev_ctx->ring_hdr->gp_size = 0;
+    }
+}
+
+NTSTATUS cx_init_dma_chunks(
+    _In_ PDEVICE_CONTEXT dev_ctx,
+    _In_ ULONG ring_size,
+    _In_ ULONG chunk_size
+)
+{
+    NTSTATUS status = STATUS_SUCCESS;
+    PAGED_CODE();
+
+    if (!cx_ring_init(&dev_ctx->ring, ring_size, chunk_size))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid ring geometry %u / %u", ring_size, chunk_size);
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    dev_ctx->dma_risc_chunk = (PDMA_DATA)ExAllocatePoolZero(NonPagedPoolNx,
+        dev_ctx->ring.chunk_count * sizeof(DMA_DATA), CX_POOL_TAG);
+
+    if (!dev_ctx->dma_risc_chunk)
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "ExAllocatePoolZero failed");
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    for (ULONG i = 0; i < dev_ctx->ring.chunk_count; i++)
     {
         DMA_DATA dma_data;
-        dma_data.len = PAGE_SIZE;
+        dma_data.len = chunk_size;
         status = WdfCommonBufferCreate(dev_ctx->dma_enabler, dma_data.len, WDF_NO_OBJECT_ATTRIBUTES, &dma_data.buf);
 
         if (!NT_SUCCESS(status))
         {
-            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "WdfCommonBufferCreate failed with status %!STATUS!", status);
+            TraceEvents(TRACE_LEVEL_WARNING, DBG_GENERAL, "WdfCommonBufferCreate (%u kbytes) failed with status %!STATUS!",
+                chunk_size / 1024, status);
             return status;
         }
 
         dma_data.va = WdfCommonBufferGetAlignedVirtualAddress(dma_data.buf);
         dma_data.la = WdfCommonBufferGetAlignedLogicalAddress(dma_data.buf);
 
+        // reads never return data the card has not written, but CX_IOCTL_MMAP_RING maps every page
         RtlZeroMemory(dma_data.va, dma_data.len);
-        dev_ctx->dma_risc_page[i] = dma_data;
+        dev_ctx->dma_risc_chunk[i] = dma_data;
     }
 
-    TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "created %d data pages", CX_VBI_BUF_COUNT);
     return status;
 }
 
+VOID cx_free_dma_chunks(
+    _In_ PDEVICE_CONTEXT dev_ctx
+)
+{
+    PAGED_CODE();
+
+    if (dev_ctx->dma_risc_chunk)
+    {
+        for (ULONG i = 0; i < dev_ctx->ring.chunk_count; i++)
+        {
+            if (dev_ctx->dma_risc_chunk[i].buf)
+            {
+                WdfObjectDelete(dev_ctx->dma_risc_chunk[i].buf);
+            }
+        }
+
+        ExFreePoolWithTag(dev_ctx->dma_risc_chunk, CX_POOL_TAG);
+        dev_ctx->dma_risc_chunk = NULL;
+    }
+
+    dev_ctx->ring = (CX_RING) { 0 };
+}
+
+// the risc program of a ring_size ring, as many small common buffers rather than one of up to 32 MB
+NTSTATUS cx_alloc_risc_prog(
+    _In_ PDEVICE_CONTEXT dev_ctx,
+    _In_ ULONG ring_size,
+    _Out_ PRISC_PROG_DATA prog
+)
+{
+    NTSTATUS status = STATUS_SUCCESS;
+    PAGED_CODE();
+
+    *prog = (RISC_PROG_DATA) { 0 };
+
+    ULONG count = cx_risc_buf_count(ring_size, dev_ctx->fifo.cdt_len);
+
+    prog->dma = (PDMA_DATA)ExAllocatePoolZero(NonPagedPoolNx, count * sizeof(DMA_DATA), CX_POOL_TAG);
+    prog->bufs = (PCX_RISC_BUF)ExAllocatePoolZero(NonPagedPoolNx, count * sizeof(CX_RISC_BUF), CX_POOL_TAG);
+
+    if (!prog->dma || !prog->bufs)
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "ExAllocatePoolZero failed");
+        cx_free_risc_prog(prog);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    for (ULONG i = 0; i < count; i++)
+    {
+        DMA_DATA dma_data;
+        dma_data.len = CX_RISC_BUF_SIZE;
+        status = WdfCommonBufferCreate(dev_ctx->dma_enabler, dma_data.len, WDF_NO_OBJECT_ATTRIBUTES, &dma_data.buf);
+
+        if (!NT_SUCCESS(status))
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "WdfCommonBufferCreate failed with status %!STATUS!", status);
+            cx_free_risc_prog(prog);
+            return status;
+        }
+
+        // not zeroed, cx_init_risc writes the whole program and the card never runs past its jumps
+        dma_data.va = WdfCommonBufferGetAlignedVirtualAddress(dma_data.buf);
+        dma_data.la = WdfCommonBufferGetAlignedLogicalAddress(dma_data.buf);
+
+        prog->dma[i] = dma_data;
+        prog->bufs[i] = (CX_RISC_BUF) { .va = dma_data.va, .addr = dma_data.la.LowPart };
+        prog->count++;
+    }
+
+    TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "created risc instr dma, %u buffers (%u kbytes)",
+        prog->count,
+        prog->count * (CX_RISC_BUF_SIZE / 1024));
+
+    return status;
+}
+
+VOID cx_free_risc_prog(
+    _Inout_ PRISC_PROG_DATA prog
+)
+{
+    PAGED_CODE();
+
+    if (prog->dma)
+    {
+        for (ULONG i = 0; i < prog->count; i++)
+        {
+            WdfObjectDelete(prog->dma[i].buf);
+        }
+
+        ExFreePoolWithTag(prog->dma, CX_POOL_TAG);
+    }
+
+    if (prog->bufs)
+    {
+        ExFreePoolWithTag(prog->bufs, CX_POOL_TAG);
+    }
+
+    *prog = (RISC_PROG_DATA) { 0 };
+}
+
+NTSTATUS cx_init_ring_hdr(
+    _In_ PDEVICE_CONTEXT dev_ctx
+)
+{
+    PAGED_CODE();
+
+    // header page, a full page so nothing else is exposed when mapped
+    dev_ctx->ring_hdr = (PCX_RING_HEADER)ExAllocatePoolZero(NonPagedPoolNx, PAGE_SIZE, CX_POOL_TAG);
+
+    if (!dev_ctx->ring_hdr)
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "ExAllocatePoolZero failed");
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    dev_ctx->ring_hdr->version = CX_RING_HEADER_VERSION;
+    dev_ctx->ring_hdr->initial_page = -1;
+
+    dev_ctx->ring_hdr_mdl = IoAllocateMdl(dev_ctx->ring_hdr, PAGE_SIZE, FALSE, FALSE, NULL);
+
+    if (!dev_ctx->ring_hdr_mdl)
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "IoAllocateMdl failed");
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    MmBuildMdlForNonPagedPool(dev_ctx->ring_hdr_mdl);
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS cx_init_ring_mdl(
+    _In_ PDEVICE_CONTEXT dev_ctx
+)
+{
+    PAGED_CODE();
+
+    // the data chunks are separate allocations, so describe them with one mdl
+    // and fill in the pfn of each page in ring order
+    dev_ctx->ring_mdl = IoAllocateMdl(dev_ctx->dma_risc_chunk[0].va, dev_ctx->ring.size, FALSE, FALSE, NULL);
+
+    if (!dev_ctx->ring_mdl)
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "IoAllocateMdl failed");
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    PPFN_NUMBER pfn = MmGetMdlPfnArray(dev_ctx->ring_mdl);
+
+    for (ULONG i = 0; i < dev_ctx->ring.chunk_count; i++)
+    {
+        for (ULONG off = 0; off < dev_ctx->ring.chunk_size; off += PAGE_SIZE)
+        {
+            *pfn++ = (PFN_NUMBER)(MmGetPhysicalAddress(&dev_ctx->dma_risc_chunk[i].va[off]).QuadPart >> PAGE_SHIFT);
+        }
+    }
+
+    dev_ctx->ring_mdl->MdlFlags |= MDL_PAGES_LOCKED;
+
+    TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "created ring mdl (%u kbytes)", dev_ctx->ring.size / 1024);
+    return STATUS_SUCCESS;
+}
+
 NTSTATUS cx_init_queue(
     _In_ PDEVICE_CONTEXT dev_ctx
 )
@@ -523,10 +985,15 @@ NTSTATUS cx_init_queue(
         return status;
     }
 
-    // read queue
-    WDF_IO_QUEUE_CONFIG_INIT(&queue_cfg, WdfIoQueueDispatchSequential);
+    // read queue, reads only start the capture & park themselves so they are dispatched in parallel
+    // the callback takes capture_lock, so it runs at passive
+    WDF_OBJECT_ATTRIBUTES queue_attrs;
+    WDF_OBJECT_ATTRIBUTES_INIT(&queue_attrs);
+    queue_attrs.ExecutionLevel = WdfExecutionLevelPassive;
+
+    WDF_IO_QUEUE_CONFIG_INIT(&queue_cfg, WdfIoQueueDispatchParallel);
     queue_cfg.EvtIoRead = cx_evt_io_read;
-    status = WdfIoQueueCreate(dev_ctx->dev, &queue_cfg, WDF_NO_OBJECT_ATTRIBUTES, &dev_ctx->read_queue);
+    status = WdfIoQueueCreate(dev_ctx->dev, &queue_cfg, &queue_attrs, &dev_ctx->read_queue);
 
     if (!NT_SUCCESS(status))
     {
@@ -543,6 +1010,101 @@ NTSTATUS cx_init_queue(
         return status;
     }
 
+    // pending reads, parked until there is data to fill them
+    WDF_IO_QUEUE_CONFIG_INIT(&queue_cfg, WdfIoQueueDispatchManual);
+    status = WdfIoQueueCreate(dev_ctx->dev, &queue_cfg, WDF_NO_OBJECT_ATTRIBUTES, &dev_ctx->pending_queue);
+
+    if (!NT_SUCCESS(status))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "WdfIoQueueCreate (pending) failed with status %!STATUS!", status);
+        return status;
+    }
+
+    // attached client rings, held until detached or canceled
+    // the cancel callback stops the capture and frees the program, so it runs at passive
+    WDF_OBJECT_ATTRIBUTES_INIT(&queue_attrs);
+    queue_attrs.ExecutionLevel = WdfExecutionLevelPassive;
+
+    WDF_IO_QUEUE_CONFIG_INIT(&queue_cfg, WdfIoQueueDispatchManual);
+    queue_cfg.PowerManaged = WdfFalse;
+    queue_cfg.EvtIoCanceledOnQueue = cx_evt_user_ring_canceled;
+    status = WdfIoQueueCreate(dev_ctx->dev, &queue_cfg, &queue_attrs, &dev_ctx->user_ring_queue);
+
+    if (!NT_SUCCESS(status))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "WdfIoQueueCreate (user ring) failed with status %!STATUS!", status);
+        return status;
+    }
+
+    // pending reads are serviced by a work item queued from the dpc
+    WDF_OBJECT_ATTRIBUTES attrs;
+    WDF_OBJECT_ATTRIBUTES_INIT(&attrs);
+    attrs.ParentObject = dev_ctx->dev;
+
+    status = WdfWaitLockCreate(&attrs, &dev_ctx->read_lock);
+
+    if (!NT_SUCCESS(status))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "WdfWaitLockCreate failed with status %!STATUS!", status);
+        return status;
+    }
+
+    status = WdfWaitLockCreate(&attrs, &dev_ctx->capture_lock);
+
+    if (!NT_SUCCESS(status))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "WdfWaitLockCreate (capture) failed with status %!STATUS!", status);
+        return status;
+    }
+
+    WDF_WORKITEM_CONFIG work_cfg;
+    WDF_WORKITEM_CONFIG_INIT(&work_cfg, cx_evt_read_work);
+
+    status = WdfWorkItemCreate(&work_cfg, &attrs, &dev_ctx->read_work_item);
+
+    if (!NT_SUCCESS(status))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "WdfWorkItemCreate failed with status %!STATUS!", status);
+        return status;
+    }
+
+    // polling captures sample the gp counter from a one-shot timer that re-arms itself
+    WDF_TIMER_CONFIG timer_cfg;
+    WDF_TIMER_CONFIG_INIT(&timer_cfg, cx_evt_poll_timer);
+    timer_cfg.UseHighResolutionTimer = WdfTrue;
+
+    status = WdfTimerCreate(&timer_cfg, &attrs, &dev_ctx->poll_timer);
+
+    if (!NT_SUCCESS(status))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "WdfTimerCreate failed with status %!STATUS!", status);
+        return status;
+    }
+
+    // captures kept alive without readers are stopped from a one-shot timer
+    // the callback takes capture_lock, so it runs at passive
+    WDF_TIMER_CONFIG_INIT(&timer_cfg, cx_evt_idle_timer);
+    attrs.ExecutionLevel = WdfExecutionLevelPassive;
+
+    status = WdfTimerCreate(&timer_cfg, &attrs, &dev_ctx->idle_timer);
+
+    if (!NT_SUCCESS(status))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "WdfTimerCreate (idle) failed with status %!STATUS!", status);
+        return status;
+    }
+
+    // so is a ring left unused after its capture, it frees common buffers
+    WDF_TIMER_CONFIG_INIT(&timer_cfg, cx_evt_release_timer);
+
+    status = WdfTimerCreate(&timer_cfg, &attrs, &dev_ctx->release_timer);
+
+    if (!NT_SUCCESS(status))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "WdfTimerCreate (release) failed with status %!STATUS!", status);
+        return status;
+    }
+
     return status;
 }
 
@@ -556,7 +1118,11 @@ VOID cx_init_attrs(
         .level = CX_IOCTL_LEVEL_DEFAULT,
         .tenbit = CX_IOCTL_TENBIT_DEFAULT,
         .sixdb = CX_IOCTL_SIXDB_DEFAULT,
-        .center_offset = CX_IOCTL_CENTER_OFFSET_DEFAULT
+        .center_offset = CX_IOCTL_CENTER_OFFSET_DEFAULT,
+        .irq_period = CX_IOCTL_IRQ_PERIOD_DEFAULT,
+        .poll_rate = CX_IOCTL_POLL_RATE_DEFAULT,
+        .keep_alive = CX_IOCTL_KEEP_ALIVE_DEFAULT,
+        .ring_release = CX_IOCTL_RING_RELEASE_DEFAULT
     };
 }
 
@@ -638,3 +1204,38 @@ NTSTATUS cx_read_device_prop(
 
     return status;
 }
+
+ULONG cx_read_reg_param(
+    _In_ PDEVICE_CONTEXT dev_ctx,
+    _In_ PCWSTR name,
+    _In_ ULONG default_value
+)
+{
+    NTSTATUS status;
+    PAGED_CODE();
+
+    WDFKEY key;
+    UNICODE_STRING value_name;
+    ULONG value = default_value;
+
+    status = WdfDeviceOpenRegistryKey(dev_ctx->dev, PLUGPLAY_REGKEY_DEVICE, KEY_READ, WDF_NO_OBJECT_ATTRIBUTES, &key);
+
+    if (!NT_SUCCESS(status))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "WdfDeviceOpenRegistryKey failed with status %!STATUS!", status);
+        return default_value;
+    }
+
+    RtlInitUnicodeString(&value_name, name);
+    status = WdfRegistryQueryULong(key, &value_name, &value);
+
+    if (!NT_SUCCESS(status))
+    {
+        value = default_value;
+    }
+
+    WdfRegistryClose(key);
+
+    TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "%ws = %u", name, value);
+    return value;
+}
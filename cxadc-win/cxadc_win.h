@@ -39,9 +39,22 @@ NTSTATUS cx_init_interrupt(
 NTSTATUS cx_create_device(_Inout_ PWDFDEVICE_INIT);
 NTSTATUS cx_init_device_ctx(_Inout_ PDEVICE_CONTEXT dev_ctx);
 NTSTATUS cx_init_dma(_In_ PDEVICE_CONTEXT dev_ctx);
+BOOLEAN cx_valid_ring_size(_In_ ULONG ring_size);
+NTSTATUS cx_alloc_ring(_In_ PDEVICE_CONTEXT dev_ctx, _In_ ULONG ring_size);
+VOID cx_free_ring(_In_ PDEVICE_CONTEXT dev_ctx);
+NTSTATUS cx_init_dma_chunks(_In_ PDEVICE_CONTEXT dev_ctx, _In_ ULONG ring_size, _In_ ULONG chunk_size);
+VOID cx_free_dma_chunks(_In_ PDEVICE_CONTEXT dev_ctx);
+NTSTATUS cx_alloc_risc_prog(_In_ PDEVICE_CONTEXT dev_ctx, _In_ ULONG ring_size, _Out_ PRISC_PROG_DATA prog);
+VOID cx_free_risc_prog(_Inout_ PRISC_PROG_DATA prog);
+NTSTATUS cx_init_ring_hdr(_In_ PDEVICE_CONTEXT dev_ctx);
+NTSTATUS cx_init_ring_mdl(_In_ PDEVICE_CONTEXT dev_ctx);
 NTSTATUS cx_init_queue(_In_ PDEVICE_CONTEXT dev_ctx);
 VOID cx_init_attrs(_Inout_ PDEVICE_CONTEXT dev_ctx);
 VOID cx_init_state(_Inout_ PDEVICE_CONTEXT dev_ctx);
+VOID cx_register_device(_In_ PDEVICE_CONTEXT dev_ctx);
+VOID cx_unregister_device(_In_ PDEVICE_CONTEXT dev_ctx);
+PDEVICE_CONTEXT cx_get_device(_In_ ULONG dev_idx);
+VOID cx_put_device(_In_ PDEVICE_CONTEXT dev_ctx);
 
 NTSTATUS cx_check_dev_info(_In_ PDEVICE_CONTEXT dev_ctx);
 NTSTATUS cx_read_device_prop(
@@ -49,3 +62,4 @@ NTSTATUS cx_read_device_prop(
     _In_ DEVICE_REGISTRY_PROPERTY prop,
     _Inout_ PULONG value
 );
+ULONG cx_read_reg_param(_In_ PDEVICE_CONTEXT dev_ctx, _In_ PCWSTR name, _In_ ULONG default_value);
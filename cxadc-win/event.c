@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#include "event.h"
+
+// sequence is -1 while an entry is being written
+VOID cx_event_record(
+    _Inout_updates_(CX_EVENT_RING_SIZE) PCX_EVENT events,
+    _Inout_ PLONG64 next_seq,
+    _In_ ULONG cause,
+    _In_ ULONG gp_cnt,
+    _In_ LONG64 stream_pos,
+    _In_ LONG64 timestamp
+)
+{
+    LONG64 seq = *next_seq;
+    PCX_EVENT event = &events[seq % CX_EVENT_RING_SIZE];
+
+    InterlockedExchange64((PLONG64)&event->sequence, -1);
+
+    event->cause = cause;
+    event->gp_cnt = gp_cnt;
+    event->stream_pos = stream_pos;
+    event->timestamp = timestamp;
+
+    InterlockedExchange64((PLONG64)&event->sequence, seq);
+    InterlockedIncrement64(next_seq);
+}
+
+// copy events from *seq up to max_count, next_seq is the sequence the isr will write next
+// events from *seq that were overwritten are counted in lost, *seq is moved past the last event copied
+ULONG cx_event_collect(
+    _In_reads_(CX_EVENT_RING_SIZE) PCX_EVENT events,
+    _In_ LONG64 next_seq,
+    _Inout_ PULONG64 seq,
+    _Out_writes_(max_count) PCX_EVENT out,
+    _In_ ULONG max_count,
+    _Out_ PULONG lost
+)
+{
+    LONG64 oldest = max(next_seq - CX_EVENT_RING_SIZE, 0);
+    ULONG count = 0;
+
+    *lost = 0;
+
+    if ((LONG64)*seq > next_seq)
+    {
+        *seq = (ULONG64)next_seq;
+    }
+
+    if ((LONG64)*seq < oldest)
+    {
+        *lost = (ULONG)(oldest - (LONG64)*seq);
+        *seq = (ULONG64)oldest;
+    }
+
+    while ((LONG64)*seq < next_seq && count < max_count)
+    {
+        PCX_EVENT event = &events[*seq % CX_EVENT_RING_SIZE];
+
+        out[count] = *event;
+
+        // overwritten while copying, or being written
+        if (InterlockedCompareExchange64((PLONG64)&event->sequence, 0, 0) != (LONG64)*seq ||
+            out[count].sequence != *seq)
+        {
+            *lost += 1;
+            *seq += 1;
+            continue;
+        }
+
+        count += 1;
+        *seq += 1;
+    }
+
+    return count;
+}
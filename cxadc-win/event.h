@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#pragma once
+
+#include "portable.h"
+
+// error interrupt event ring, written by the isr only
+
+VOID cx_event_record(
+    _Inout_updates_(CX_EVENT_RING_SIZE) PCX_EVENT events,
+    _Inout_ PLONG64 next_seq,
+    _In_ ULONG cause,
+    _In_ ULONG gp_cnt,
+    _In_ LONG64 stream_pos,
+    _In_ LONG64 timestamp
+);
+ULONG cx_event_collect(
+    _In_reads_(CX_EVENT_RING_SIZE) PCX_EVENT events,
+    _In_ LONG64 next_seq,
+    _Inout_ PULONG64 seq,
+    _Out_writes_(max_count) PCX_EVENT out,
+    _In_ ULONG max_count,
+    _Out_ PULONG lost
+);
@@ -0,0 +1,112 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#include "fifo.h"
+
+// place cdt_count clusters of cdt_len bytes at the end of sram, with their cdt below them
+// a cluster is moved by one RISC WRITE, so it must be a power of 2 that divides a page
+BOOLEAN cx_fifo_plan(
+    _Out_ PCX_FIFO_GEOMETRY fifo,
+    _In_ ULONG cdt_len,
+    _In_ ULONG cdt_count
+)
+{
+    *fifo = (CX_FIFO_GEOMETRY) { 0 };
+
+    if (cdt_len < CX_CDT_LEN_MIN || cdt_len > CX_CDT_LEN_MAX || (cdt_len & (cdt_len - 1)) ||
+        cdt_count < CX_CDT_COUNT_MIN)
+    {
+        return FALSE;
+    }
+
+    // clusters fill sram from the end down, the cdt must end below the first one
+    ULONG64 cdt_end = CX_SRAM_CDT_BASE + (ULONG64)cdt_count * sizeof(CX_CDT_DESCRIPTOR);
+    ULONG64 size = (ULONG64)cdt_len * cdt_count;
+
+    if (cdt_end + size > CX_MEM_SRAM_END)
+    {
+        return FALSE;
+    }
+
+    fifo->cdt_len = cdt_len;
+    fifo->cdt_count = cdt_count;
+    fifo->cdt_base = CX_SRAM_CDT_BASE;
+    fifo->buf_base = CX_MEM_SRAM_END - (ULONG)size;
+    fifo->size = (ULONG)size;
+
+    return TRUE;
+}
+
+// geometry of a CX_FIFO_PRESET_*
+BOOLEAN cx_fifo_preset(
+    _Out_ PCX_FIFO_GEOMETRY fifo,
+    _In_ ULONG preset
+)
+{
+    switch (preset)
+    {
+    case CX_FIFO_PRESET_DEFAULT:
+        return cx_fifo_plan(fifo, 2048, 8);
+
+    case CX_FIFO_PRESET_40MHZ:
+        return cx_fifo_plan(fifo, 2048, 12);
+
+    case CX_FIFO_PRESET_50MHZ:
+        return cx_fifo_plan(fifo, 2048, 13);
+
+    default:
+        *fifo = (CX_FIFO_GEOMETRY) { 0 };
+        return FALSE;
+    }
+}
+
+// longest a WRITE may take on an otherwise idle fifo before the adc runs into the cluster it is draining,
+// the time to fill every other cluster
+LONG64 cx_fifo_stall_tolerance(
+    _In_ PCX_FIFO_GEOMETRY fifo,
+    _In_ ULONG byte_rate
+)
+{
+    return (LONG64)(fifo->size - fifo->cdt_len) * 1000000000 / byte_rate;
+}
+
+// run clusters cluster fills through the fifo, returns how many of them overflowed
+// cluster k is full at (k + 1) * fill, its WRITE starts then or when the one before it is done, whichever is later,
+// and it overflows if the WRITE is not done by the time the adc wraps around to it at (k + cdt_count) * fill
+// a WRITE that is late holds up the ones behind it, as the risc engine runs them in order
+ULONG64 cx_fifo_simulate(
+    _In_ PCX_FIFO_GEOMETRY fifo,
+    _In_ ULONG byte_rate,
+    _In_ CX_FIFO_LATENCY latency,
+    _In_ PVOID ctx,
+    _In_ ULONG64 clusters
+)
+{
+    LONG64 fill = (LONG64)fifo->cdt_len * 1000000000 / byte_rate;
+    LONG64 done = 0;
+    ULONG64 overflows = 0;
+
+    for (ULONG64 k = 0; k < clusters; k++)
+    {
+        LONG64 full = (LONG64)(k + 1) * fill;
+
+        done = max(done, full) + latency(ctx);
+
+        if (done > (LONG64)(k + fifo->cdt_count) * fill)
+        {
+            overflows += 1;
+        }
+    }
+
+    return overflows;
+}
@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#pragma once
+
+#include "cx2388x_regs.h"
+
+// on-chip fifo layout in sram, see CX_FIFO_GEOMETRY
+
+BOOLEAN cx_fifo_plan(_Out_ PCX_FIFO_GEOMETRY fifo, _In_ ULONG cdt_len, _In_ ULONG cdt_count);
+BOOLEAN cx_fifo_preset(_Out_ PCX_FIFO_GEOMETRY fifo, _In_ ULONG preset);
+
+// overflow model, times are nanoseconds and byte_rate the bytes per second the adc fills the fifo at
+
+// nanoseconds from a cluster being full to its WRITE completing, bus grant & transfer
+typedef LONG64 (*CX_FIFO_LATENCY)(_In_ PVOID ctx);
+
+LONG64 cx_fifo_stall_tolerance(_In_ PCX_FIFO_GEOMETRY fifo, _In_ ULONG byte_rate);
+ULONG64 cx_fifo_simulate(
+    _In_ PCX_FIFO_GEOMETRY fifo,
+    _In_ ULONG byte_rate,
+    _In_ CX_FIFO_LATENCY latency,
+    _In_ PVOID ctx,
+    _In_ ULONG64 clusters
+);
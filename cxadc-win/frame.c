@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#include "frame.h"
+
+// find the block holding stream position pos, searching forward from *seq
+// next_seq is the sequence the dpc will write next, blocks[seq % block_count] holds seq
+// returns FALSE if pos is not in any block that is still recorded
+BOOLEAN cx_frame_find_block(
+    _In_ PCX_BLOCK_INFO blocks,
+    _In_ ULONG block_count,
+    _In_ LONG64 next_seq,
+    _In_ LONG64 pos,
+    _Inout_ PLONG64 seq,
+    _Out_ PCX_BLOCK_INFO info
+)
+{
+    // older entries have been reused
+    if (*seq < next_seq - (LONG64)block_count)
+    {
+        *seq = next_seq - block_count;
+    }
+
+    if (*seq < 0)
+    {
+        *seq = 0;
+    }
+
+    for (; *seq < next_seq; (*seq)++)
+    {
+        PCX_BLOCK_INFO block = &blocks[*seq % block_count];
+
+        *info = *block;
+
+        // overwritten while copying, or being written
+        if (InterlockedCompareExchange64(&block->sequence, 0, 0) != *seq ||
+            info->sequence != *seq)
+        {
+            continue;
+        }
+
+        if (pos < info->start_pos)
+        {
+            return FALSE;
+        }
+
+        if (pos < info->end_pos)
+        {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+// stream position captured at timestamp, searching back from the newest block
+// a block ends at its timestamp, positions inside it are interpolated from the block before it
+// clamped to the newest block's end and the oldest recorded block's start, write_pos if there are none
+LONG64 cx_frame_time_pos(
+    _In_ PCX_BLOCK_INFO blocks,
+    _In_ ULONG block_count,
+    _In_ LONG64 next_seq,
+    _In_ LONG64 timestamp,
+    _In_ LONG64 write_pos
+)
+{
+    LONG64 first_seq = max(next_seq - (LONG64)block_count, 0);
+    CX_BLOCK_INFO later = { .sequence = -1 };
+
+    for (LONG64 seq = next_seq - 1; seq >= first_seq; seq--)
+    {
+        PCX_BLOCK_INFO block = &blocks[seq % block_count];
+        CX_BLOCK_INFO info = *block;
+
+        // being rewritten by the dpc, or was while copying, everything older is gone
+        if (InterlockedCompareExchange64(&block->sequence, 0, 0) != seq ||
+            info.sequence != seq)
+        {
+            break;
+        }
+
+        if (timestamp >= info.timestamp)
+        {
+            if (later.sequence < 0)
+            {
+                return info.end_pos;
+            }
+
+            LONG64 span = later.timestamp - info.timestamp;
+            LONG64 len = later.end_pos - later.start_pos;
+
+            return span > 0 ? later.start_pos + len * (timestamp - info.timestamp) / span : later.start_pos;
+        }
+
+        later = info;
+    }
+
+    return later.sequence < 0 ? write_pos : later.start_pos;
+}
+
+VOID cx_frame_fill_header(
+    _Out_ PCX_FRAME_HEADER hdr,
+    _In_opt_ PCX_BLOCK_INFO info,
+    _In_ LONG64 stream_pos,
+    _In_ ULONG data_size,
+    _In_ ULONG flags,
+    _In_ LONG64 timestamp_freq
+)
+{
+    *hdr = (CX_FRAME_HEADER) {
+        .magic = CX_FRAME_MAGIC,
+        .version = CX_FRAME_VERSION,
+        .header_size = sizeof(CX_FRAME_HEADER),
+        .data_size = data_size,
+        .flags = flags,
+        .stream_pos = stream_pos,
+        .timestamp_freq = timestamp_freq
+    };
+
+    if (!info)
+    {
+        hdr->flags |= CX_FRAME_FLAG_NO_INFO;
+        hdr->sequence = (ULONG64)-1;
+        hdr->block_pos = stream_pos;
+        hdr->block_size = data_size;
+        return;
+    }
+
+    hdr->flags |= info->flags;
+    hdr->sequence = (ULONG64)info->sequence;
+    hdr->block_pos = info->start_pos;
+    hdr->block_size = (ULONG)(info->end_pos - info->start_pos);
+    hdr->gp_cnt = info->gp_cnt;
+    hdr->timestamp = info->timestamp;
+    hdr->attrs = info->attrs;
+}
@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#pragma once
+
+#include "portable.h"
+
+// framed read support, per-block info recorded by the dpc & frame header construction
+
+typedef struct _CX_BLOCK_INFO
+{
+    LONG64 sequence;        // -1 when unused
+    LONG64 start_pos;
+    LONG64 end_pos;
+    LONG64 timestamp;
+    ULONG gp_cnt;
+    ULONG flags;
+    CX_FRAME_ATTRS attrs;
+} CX_BLOCK_INFO, *PCX_BLOCK_INFO;
+
+BOOLEAN cx_frame_find_block(
+    _In_ PCX_BLOCK_INFO blocks,
+    _In_ ULONG block_count,
+    _In_ LONG64 next_seq,
+    _In_ LONG64 pos,
+    _Inout_ PLONG64 seq,
+    _Out_ PCX_BLOCK_INFO info
+);
+
+LONG64 cx_frame_time_pos(
+    _In_ PCX_BLOCK_INFO blocks,
+    _In_ ULONG block_count,
+    _In_ LONG64 next_seq,
+    _In_ LONG64 timestamp,
+    _In_ LONG64 write_pos
+);
+
+VOID cx_frame_fill_header(
+    _Out_ PCX_FRAME_HEADER hdr,
+    _In_opt_ PCX_BLOCK_INFO info,
+    _In_ LONG64 stream_pos,
+    _In_ ULONG data_size,
+    _In_ ULONG flags,
+    _In_ LONG64 timestamp_freq
+);
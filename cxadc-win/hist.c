@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#include "hist.h"
+
+// bucket for value, 0 for value <= 0, otherwise 1 + floor(log2(value)) up to the last bucket
+ULONG cx_hist_bucket(
+    _In_ LONG64 value
+)
+{
+    if (value <= 0)
+    {
+        return 0;
+    }
+
+    ULONG64 v = (ULONG64)value;
+    ULONG log2 = 0;
+
+    for (ULONG shift = 32; shift; shift /= 2)
+    {
+        if (v >> shift)
+        {
+            v >>= shift;
+            log2 += shift;
+        }
+    }
+
+    return min(log2 + 1, CX_LATENCY_BUCKETS - 1);
+}
+
+VOID cx_hist_add(
+    _Inout_ PCX_LATENCY_HIST hist,
+    _In_ LONG64 value
+)
+{
+    InterlockedIncrement64(&hist->count[cx_hist_bucket(value)]);
+}
@@ -16,6 +16,15 @@
 
 #include "ioctl.h"
 #include "cx2388x.h"
+#include "cxadc_win.h"
+#include "event.h"
+#include "hist.h"
+#include "pack.h"
+#include "regprog.h"
+#include "risc.h"
+#include "ring.h"
+#include "sched.h"
+#include "sync.h"
 
 #ifdef ALLOC_PRAGMA
 #pragma alloc_text (PAGE, cx_evt_file_create)
@@ -29,14 +38,34 @@ cx_evt_file_create(
     _In_ WDFREQUEST req,
     _In_ WDFFILEOBJECT file_obj)
 {
-    UNREFERENCED_PARAMETER(dev);
-
     NTSTATUS status = STATUS_SUCCESS;
     PAGED_CODE();
 
     PFILE_CONTEXT file_ctx = cx_file_get_ctx(file_obj);
+    file_ctx->is_reader = FALSE;
     file_ctx->read_offset = 0;
+    file_ctx->overrun_policy = CX_IOCTL_OVERRUN_POLICY_DEFAULT;
+    file_ctx->wait_policy = CX_IOCTL_WAIT_POLICY_DEFAULT;
+    file_ctx->stats = (CX_READER_STATS){ 0 };
+    file_ctx->read_mode = CX_IOCTL_READ_MODE_DEFAULT;
+    file_ctx->read_format = CX_IOCTL_READ_FORMAT_DEFAULT;
+    file_ctx->frame_seq = 0;
+    file_ctx->frame_gap = FALSE;
+    file_ctx->history_id = 0;
+    file_ctx->is_positioned = FALSE;
     file_ctx->mmap_data = (MMAP_DATA){ 0 };
+    file_ctx->ring_mmap_data = (CX_RING_MMAP_DATA){ 0 };
+    file_ctx->sync_count = 0;
+
+    // \\.\cxadcN\head joins a running capture at its live head instead of its start
+    DECLARE_CONST_UNICODE_STRING(head_name, L"\\head");
+    PCUNICODE_STRING file_name = WdfFileObjectGetFileName(file_obj);
+
+    if (file_name && RtlEqualUnicodeString(file_name, &head_name, TRUE))
+    {
+        CX_READ_POSITION_RESULT result;
+        cx_set_read_position(cx_device_get_ctx(dev), file_ctx, CX_READ_ORIGIN_HEAD, 0, &result);
+    }
 
     WdfRequestComplete(req, status);
 }
@@ -51,16 +80,80 @@ cx_evt_file_close(
     PDEVICE_CONTEXT dev_ctx = cx_device_get_ctx(WdfFileObjectGetDevice(file_obj));
     PFILE_CONTEXT file_ctx = cx_file_get_ctx(file_obj);
 
-    if (file_ctx->read_offset)
+    if (file_ctx->is_reader)
     {
-        InterlockedDecrement(&dev_ctx->state.reader_count);
+        // a read on another handle may be joining at the same time
+        WdfWaitLockAcquire(dev_ctx->capture_lock, NULL);
 
-        // stop capture if no other readers
-        if (!dev_ctx->state.reader_count)
-        {
-            cx_stop_capture(dev_ctx);
-        }
+        // idle the capture if no other readers, a capture into a client ring is stopped by detaching it
+        cx_apply_capture_action(dev_ctx,
+            cx_capture_leave(&dev_ctx->state.capture, &file_ctx->is_reader, dev_ctx->user_sg != NULL,
+                dev_ctx->attrs.keep_alive, (LONG64)KeQueryInterruptTime()), 0);
+
+        WdfWaitLockRelease(dev_ctx->capture_lock);
+    }
+}
+
+// the capture has no reader left, keep it alive for keep_alive or stop it
+// called with capture_lock held
+VOID cx_idle_capture(
+    _Inout_ PDEVICE_CONTEXT dev_ctx
+)
+{
+    cx_apply_capture_action(dev_ctx,
+        cx_capture_idle(&dev_ctx->state.capture, dev_ctx->attrs.keep_alive, (LONG64)KeQueryInterruptTime()), 0);
+}
+
+// carry out a decision of capture.c on the idle timer & device, left is for CX_CAPTURE_WAIT
+// a read carries out its own start & resume, see cx_evt_io_read
+// called with capture_lock held
+VOID cx_apply_capture_action(
+    _Inout_ PDEVICE_CONTEXT dev_ctx,
+    _In_ CX_CAPTURE_ACTION action,
+    _In_ LONG64 left
+)
+{
+    switch (action)
+    {
+    case CX_CAPTURE_KEEP_ALIVE:
+        TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "keeping capture alive for %u ms", dev_ctx->attrs.keep_alive);
+        WdfTimerStart(dev_ctx->idle_timer, WDF_REL_TIMEOUT_IN_MS(dev_ctx->attrs.keep_alive));
+        break;
+
+    case CX_CAPTURE_WAIT:
+        WdfTimerStart(dev_ctx->idle_timer, -left);
+        break;
+
+    case CX_CAPTURE_STOP:
+        cx_stop_capture(dev_ctx);
+        break;
+
+    default:
+        break;
+    }
+}
+
+VOID
+cx_evt_idle_timer(
+    _In_ WDFTIMER timer
+)
+{
+    PDEVICE_CONTEXT dev_ctx = cx_device_get_ctx(WdfTimerGetParentObject(timer));
+    LONG64 left;
+
+    WdfWaitLockAcquire(dev_ctx->capture_lock, NULL);
+
+    CX_CAPTURE_ACTION action = cx_capture_idle_timer(&dev_ctx->state.capture, dev_ctx->attrs.keep_alive,
+        (LONG64)KeQueryInterruptTime(), &left);
+
+    if (action == CX_CAPTURE_STOP)
+    {
+        TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "no reader within keep_alive");
     }
+
+    cx_apply_capture_action(dev_ctx, action, left);
+
+    WdfWaitLockRelease(dev_ctx->capture_lock);
 }
 
 VOID
@@ -73,6 +166,9 @@ cx_evt_file_cleanup(
     PDEVICE_CONTEXT dev_ctx = cx_device_get_ctx(WdfFileObjectGetDevice(file_obj));
     PFILE_CONTEXT file_ctx = cx_file_get_ctx(file_obj);
 
+    // cleanup runs in the process closing the last handle
+    WdfWaitLockAcquire(dev_ctx->capture_lock, NULL);
+
     if (file_ctx->mmap_data.ptr != NULL)
     {
         TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "munmap addr %p", file_ctx->mmap_data.ptr);
@@ -80,6 +176,157 @@ cx_evt_file_cleanup(
         MmUnmapLockedPages(file_ctx->mmap_data.ptr, dev_ctx->user_mdl);
         file_ctx->mmap_data.ptr = NULL;
     }
+
+    cx_munmap_ring(dev_ctx, file_ctx);
+    WdfWaitLockRelease(dev_ctx->capture_lock);
+
+    // the handle attached a client ring and never detached it
+    cx_release_user_ring(dev_ctx, file_obj, STATUS_CANCELLED);
+
+    // the handle sync started captures that never got a reader
+    cx_sync_release(file_ctx);
+}
+
+// mappings into the caller's address space must be made and removed in its process,
+// which a queue callback is not guaranteed to run in, so those ioctls are handled here
+// everything else goes on to the queues
+VOID cx_evt_io_in_caller_context(
+    _In_ WDFDEVICE dev,
+    _In_ WDFREQUEST req
+)
+{
+    NTSTATUS status = STATUS_SUCCESS;
+    WDF_REQUEST_PARAMETERS params;
+
+    WDF_REQUEST_PARAMETERS_INIT(&params);
+    WdfRequestGetParameters(req, &params);
+
+    ULONG ctrl_code = params.Type == WdfRequestTypeDeviceControl ? params.Parameters.DeviceIoControl.IoControlCode : 0;
+
+    switch (ctrl_code)
+    {
+    case CX_IOCTL_MMAP:
+    case CX_IOCTL_MUNMAP:
+    case CX_IOCTL_MMAP_RING:
+    case CX_IOCTL_MUNMAP_RING:
+        cx_map_ctrl(cx_device_get_ctx(dev), req, params.Parameters.DeviceIoControl.OutputBufferLength, ctrl_code);
+        break;
+
+    default:
+        status = WdfDeviceEnqueueRequest(dev, req);
+
+        if (!NT_SUCCESS(status))
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "WdfDeviceEnqueueRequest failed with status %!STATUS!", status);
+            WdfRequestComplete(req, status);
+        }
+
+        break;
+    }
+}
+
+// map & unmap ioctls, in the caller's context
+// they are no longer serialized by the control queue, capture_lock keeps one handle's calls apart
+VOID cx_map_ctrl(
+    _Inout_ PDEVICE_CONTEXT dev_ctx,
+    _In_ WDFREQUEST req,
+    _In_ size_t out_len,
+    _In_ ULONG ctrl_code
+)
+{
+    NTSTATUS status = STATUS_SUCCESS;
+    PUCHAR out_buf = NULL;
+    PFILE_CONTEXT file_ctx = cx_file_get_ctx(WdfRequestGetFileObject(req));
+
+    if (out_len)
+    {
+        status = WdfRequestRetrieveOutputBuffer(req, out_len, &out_buf, NULL);
+
+        if (!NT_SUCCESS(status) || out_buf == NULL)
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "WdfRequestRetrieveOutputBuffer failed with status %!STATUS!", status);
+            WdfRequestComplete(req, status);
+            return;
+        }
+    }
+
+    WdfWaitLockAcquire(dev_ctx->capture_lock, NULL);
+
+    switch (ctrl_code)
+    {
+    case CX_IOCTL_MMAP:
+    {
+        if (out_buf == NULL || out_len != sizeof(MMAP_DATA))
+        {
+            status = STATUS_BUFFER_TOO_SMALL;
+            break;
+        }
+
+        if (file_ctx->mmap_data.ptr == NULL)
+        {
+            file_ctx->mmap_data = (MMAP_DATA)
+            {
+                .ptr = MmMapLockedPagesSpecifyCache(dev_ctx->user_mdl, UserMode, MmNonCached, NULL, FALSE, NormalPagePriority)
+            };
+        }
+
+        TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "mmap addr %p", file_ctx->mmap_data.ptr);
+
+        *(PMMAP_DATA)out_buf = file_ctx->mmap_data;
+        break;
+    }
+
+    case CX_IOCTL_MUNMAP:
+    {
+        if (file_ctx->mmap_data.ptr != NULL)
+        {
+            TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "munmap addr %p", file_ctx->mmap_data.ptr);
+
+            MmUnmapLockedPages(file_ctx->mmap_data.ptr, dev_ctx->user_mdl);
+            file_ctx->mmap_data.ptr = NULL;
+        }
+
+        break;
+    }
+
+    case CX_IOCTL_MMAP_RING:
+    {
+        if (out_buf == NULL || out_len != sizeof(CX_RING_MMAP_DATA))
+        {
+            status = STATUS_BUFFER_TOO_SMALL;
+            break;
+        }
+
+        status = cx_mmap_ring(dev_ctx, file_ctx);
+
+        if (!NT_SUCCESS(status))
+        {
+            break;
+        }
+
+        TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "mmap ring addr %p hdr %p",
+            file_ctx->ring_mmap_data.ring,
+            file_ctx->ring_mmap_data.hdr);
+
+        *(PCX_RING_MMAP_DATA)out_buf = file_ctx->ring_mmap_data;
+        break;
+    }
+
+    case CX_IOCTL_MUNMAP_RING:
+    {
+        cx_munmap_ring(dev_ctx, file_ctx);
+        break;
+    }
+
+    default:
+        status = STATUS_INVALID_DEVICE_REQUEST;
+        break;
+    }
+
+    WdfWaitLockRelease(dev_ctx->capture_lock);
+
+    WdfRequestSetInformation(req, (ULONG_PTR)out_len);
+    WdfRequestComplete(req, status);
 }
 
 VOID cx_evt_io_ctrl(
@@ -95,6 +342,13 @@ VOID cx_evt_io_ctrl(
     PDEVICE_CONTEXT dev_ctx = cx_device_get_ctx(WdfIoQueueGetDevice(queue));
     PFILE_CONTEXT file_ctx = cx_file_get_ctx(WdfRequestGetFileObject(req));
 
+    // the output buffer is the client's ring, it is never mapped into system space
+    if (ctrl_code == CX_IOCTL_ATTACH_USER_RING)
+    {
+        cx_attach_user_ring(dev_ctx, req);
+        return;
+    }
+
     if (out_len)
     {
         status = WdfRequestRetrieveOutputBuffer(req, out_len, &out_buf, NULL);
@@ -129,7 +383,7 @@ VOID cx_evt_io_ctrl(
             break;
         }
 
-        *(PULONG)out_buf = dev_ctx->state.is_capturing;
+        *(PULONG)out_buf = dev_ctx->state.capture.is_capturing;
         break;
     }
 
@@ -145,55 +399,108 @@ VOID cx_evt_io_ctrl(
         break;
     }
 
-    case CX_IOCTL_GET_VMUX:
+    case CX_IOCTL_GET_READER_STATS:
     {
-        if (out_buf == NULL || out_len < sizeof(ULONG))
+        if (out_buf == NULL || out_len < sizeof(CX_READER_STATS))
         {
             status = STATUS_BUFFER_TOO_SMALL;
             break;
         }
 
-        *(PULONG)out_buf = dev_ctx->attrs.vmux;
+        *(PCX_READER_STATS)out_buf = file_ctx->stats;
         break;
     }
 
-    case CX_IOCTL_GET_LEVEL:
+    case CX_IOCTL_GET_STATS:
     {
-        if (out_buf == NULL || out_len < sizeof(ULONG))
+        // at least version & size
+        if (out_buf == NULL || out_len < FIELD_OFFSET(CX_STATS, bytes_produced))
         {
             status = STATUS_BUFFER_TOO_SMALL;
             break;
         }
 
-        *(PULONG)out_buf = dev_ctx->attrs.level;
+        LARGE_INTEGER freq;
+        KeQueryPerformanceCounter(&freq);
+
+        CX_STATS stats = dev_ctx->stats;
+        stats.version = CX_STATS_VERSION;
+        stats.size = (ULONG)min(out_len, sizeof(CX_STATS));
+        stats.timestamp_freq = freq.QuadPart;
+
+        out_len = stats.size;
+        RtlCopyMemory(out_buf, &stats, out_len);
         break;
     }
 
-    case CX_IOCTL_GET_TENBIT:
+    case CX_IOCTL_GET_LATENCY:
     {
-        if (out_buf == NULL || out_len < sizeof(ULONG))
+        if (out_buf == NULL || out_len < sizeof(CX_LATENCY))
         {
             status = STATUS_BUFFER_TOO_SMALL;
             break;
         }
 
-        *(PULONG)out_buf = dev_ctx->attrs.tenbit;
+        LARGE_INTEGER freq;
+        KeQueryPerformanceCounter(&freq);
+
+        PCX_LATENCY latency = (PCX_LATENCY)out_buf;
+        latency->version = CX_LATENCY_VERSION;
+        latency->stage_count = CX_LATENCY_STAGES;
+        latency->timestamp_freq = freq.QuadPart;
+
+        // buckets are read one by one, a snapshot taken during capture may be slightly torn
+        for (ULONG i = 0; i < CX_LATENCY_STAGES; i++)
+        {
+            for (ULONG j = 0; j < CX_LATENCY_BUCKETS; j++)
+            {
+                latency->hist[i].count[j] = InterlockedCompareExchange64(&dev_ctx->latency[i].count[j], 0, 0);
+            }
+        }
+
+        out_len = sizeof(CX_LATENCY);
         break;
     }
 
-    case CX_IOCTL_GET_SIXDB:
+    case CX_IOCTL_GET_EVENTS:
     {
-        if (out_buf == NULL || out_len < sizeof(ULONG))
+        if (in_buf == NULL || in_len != sizeof(ULONG64))
+        {
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        if (out_buf == NULL || out_len < sizeof(CX_EVENTS))
         {
             status = STATUS_BUFFER_TOO_SMALL;
             break;
         }
 
-        *(PULONG)out_buf = dev_ctx->attrs.sixdb;
+        // in & out share the system buffer
+        ULONG64 seq = *(PULONG64)in_buf;
+        PCX_EVENTS events = (PCX_EVENTS)out_buf;
+        ULONG max_count = (ULONG)((out_len - FIELD_OFFSET(CX_EVENTS, events)) / sizeof(CX_EVENT));
+        ULONG lost;
+        LARGE_INTEGER freq;
+
+        KeQueryPerformanceCounter(&freq);
+
+        events->count = cx_event_collect(dev_ctx->events,
+            InterlockedCompareExchange64(&dev_ctx->state.event_seq, 0, 0),
+            &seq,
+            events->events,
+            max_count,
+            &lost);
+
+        events->next_seq = seq;
+        events->lost = lost;
+        events->timestamp_freq = freq.QuadPart;
+
+        out_len = FIELD_OFFSET(CX_EVENTS, events) + events->count * sizeof(CX_EVENT);
         break;
     }
 
-    case CX_IOCTL_GET_CENTER_OFFSET:
+    case CX_IOCTL_GET_OVERRUN_POLICY:
     {
         if (out_buf == NULL || out_len < sizeof(ULONG))
         {
@@ -201,11 +508,11 @@ VOID cx_evt_io_ctrl(
             break;
         }
 
-        *(PULONG)out_buf = dev_ctx->attrs.center_offset;
+        *(PULONG)out_buf = file_ctx->overrun_policy;
         break;
     }
 
-    case CX_IOCTL_GET_BUS_NUMBER:
+    case CX_IOCTL_GET_READ_MODE:
     {
         if (out_buf == NULL || out_len < sizeof(ULONG))
         {
@@ -213,11 +520,11 @@ VOID cx_evt_io_ctrl(
             break;
         }
 
-        *(PULONG)out_buf = dev_ctx->bus_number;
+        *(PULONG)out_buf = file_ctx->read_mode;
         break;
     }
 
-    case CX_IOCTL_GET_DEVICE_ADDRESS:
+    case CX_IOCTL_GET_READ_FORMAT:
     {
         if (out_buf == NULL || out_len < sizeof(ULONG))
         {
@@ -225,332 +532,2486 @@ VOID cx_evt_io_ctrl(
             break;
         }
 
-        *(PULONG)out_buf = dev_ctx->dev_addr;
+        *(PULONG)out_buf = file_ctx->read_format;
         break;
     }
 
-    case CX_IOCTL_GET_REGISTER:
+    case CX_IOCTL_GET_WAIT_POLICY:
     {
-        if (out_buf == NULL || in_buf == NULL || in_len < sizeof(ULONG) || out_len != sizeof(ULONG))
+        if (out_buf == NULL || out_len < sizeof(ULONG))
         {
-            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid data for get register %lld / %lld", in_len, out_len);
-            status = STATUS_INVALID_PARAMETER;
+            status = STATUS_BUFFER_TOO_SMALL;
             break;
         }
 
-        ULONG address = *(PULONG)in_buf;
+        *(PULONG)out_buf = file_ctx->wait_policy;
+        break;
+    }
 
-        if (address < CX_REGISTER_BASE || address > CX_REGISTER_END)
+    case CX_IOCTL_GET_AVAILABLE:
+    {
+        if (out_buf == NULL || out_len < sizeof(CX_AVAILABLE))
         {
-            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "address %08X out of range", address);
-            status = STATUS_INVALID_PARAMETER;
+            status = STATUS_BUFFER_TOO_SMALL;
             break;
         }
 
-        *(PULONG)out_buf = cx_read(dev_ctx, address);
+        cx_get_available(dev_ctx, file_ctx, (PCX_AVAILABLE)out_buf);
+        out_len = sizeof(CX_AVAILABLE);
         break;
     }
 
-    case CX_IOCTL_RESET_OUFLOW_COUNT:
+    case CX_IOCTL_GET_VMUX:
     {
-        TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "resetting over/underflow count (current: %d)", dev_ctx->state.ouflow_count);
-        dev_ctx->state.ouflow_count = 0;
+        if (out_buf == NULL || out_len < sizeof(ULONG))
+        {
+            status = STATUS_BUFFER_TOO_SMALL;
+            break;
+        }
+
+        *(PULONG)out_buf = dev_ctx->attrs.vmux;
         break;
     }
 
-    case CX_IOCTL_SET_VMUX:
+    case CX_IOCTL_GET_LEVEL:
     {
-        if (in_buf == NULL || in_len != sizeof(LONG))
+        if (out_buf == NULL || out_len < sizeof(ULONG))
         {
-            status = STATUS_INVALID_PARAMETER;
+            status = STATUS_BUFFER_TOO_SMALL;
             break;
         }
 
-        LONG value = *(PLONG)in_buf;
+        *(PULONG)out_buf = dev_ctx->attrs.level;
+        break;
+    }
 
-        if (value < CX_IOCTL_VMUX_MIN || value > CX_IOCTL_VMUX_MAX)
+    case CX_IOCTL_GET_TENBIT:
+    {
+        if (out_buf == NULL || out_len < sizeof(ULONG))
         {
-            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid vmux %d", value);
-            status = STATUS_INVALID_PARAMETER;
+            status = STATUS_BUFFER_TOO_SMALL;
             break;
         }
 
-        TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "setting vmux to %d", value);
-        dev_ctx->attrs.vmux = value;
-        cx_set_vmux(dev_ctx);
+        *(PULONG)out_buf = dev_ctx->attrs.tenbit;
         break;
     }
 
-    case CX_IOCTL_SET_LEVEL:
+    case CX_IOCTL_GET_SIXDB:
     {
-        if (in_buf == NULL || in_len != sizeof(LONG))
+        if (out_buf == NULL || out_len < sizeof(ULONG))
         {
-            status = STATUS_INVALID_PARAMETER;
+            status = STATUS_BUFFER_TOO_SMALL;
             break;
         }
 
-        LONG value = *(PLONG)in_buf;
+        *(PULONG)out_buf = dev_ctx->attrs.sixdb;
+        break;
+    }
 
-        if (value < CX_IOCTL_LEVEL_MIN || value > CX_IOCTL_LEVEL_MAX)
+    case CX_IOCTL_GET_CENTER_OFFSET:
+    {
+        if (out_buf == NULL || out_len < sizeof(ULONG))
         {
-            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid level %d", value);
-            status = STATUS_INVALID_PARAMETER;
+            status = STATUS_BUFFER_TOO_SMALL;
             break;
         }
 
-        TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "setting level to %d", value);
-        dev_ctx->attrs.level = value;
-        cx_set_level(dev_ctx);
+        *(PULONG)out_buf = dev_ctx->attrs.center_offset;
         break;
     }
 
-    case CX_IOCTL_SET_TENBIT:
+    case CX_IOCTL_GET_IRQ_PERIOD:
     {
-        if (in_buf == NULL || in_len != sizeof(LONG))
+        if (out_buf == NULL || out_len < sizeof(ULONG))
         {
-            status = STATUS_INVALID_PARAMETER;
+            status = STATUS_BUFFER_TOO_SMALL;
             break;
         }
 
-        LONG value = *(PLONG)in_buf;
+        *(PULONG)out_buf = dev_ctx->attrs.irq_period;
+        break;
+    }
 
-        if (value < CX_IOCTL_TENBIT_MIN || value > CX_IOCTL_TENBIT_MAX)
+    case CX_IOCTL_GET_POLL_RATE:
+    {
+        if (out_buf == NULL || out_len < sizeof(ULONG))
         {
-            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid tenbit %d", value);
-            status = STATUS_INVALID_PARAMETER;
+            status = STATUS_BUFFER_TOO_SMALL;
             break;
         }
 
-        TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "setting tenbit to %d", value);
-        dev_ctx->attrs.tenbit = value;
-        cx_set_tenbit(dev_ctx);
+        *(PULONG)out_buf = dev_ctx->attrs.poll_rate;
         break;
     }
 
-    case CX_IOCTL_SET_SIXDB:
+    case CX_IOCTL_GET_KEEP_ALIVE:
     {
-        if (in_buf == NULL || in_len != sizeof(LONG))
+        if (out_buf == NULL || out_len < sizeof(ULONG))
         {
-            status = STATUS_INVALID_PARAMETER;
+            status = STATUS_BUFFER_TOO_SMALL;
             break;
         }
 
-        LONG value = *(PLONG)in_buf;
+        *(PULONG)out_buf = dev_ctx->attrs.keep_alive;
+        break;
+    }
 
-        if (value < CX_IOCTL_SIXDB_MIN || value > CX_IOCTL_SIXDB_MAX)
+    case CX_IOCTL_GET_CONFIG:
+    {
+        if (out_buf == NULL || out_len < sizeof(CX_CONFIG))
         {
-            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid sixdb %d", value);
-            status = STATUS_INVALID_PARAMETER;
+            status = STATUS_BUFFER_TOO_SMALL;
             break;
         }
 
-        TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "setting sixdb to %d", value);
-        dev_ctx->attrs.sixdb = value;
-        cx_set_level(dev_ctx);
+        *(PCX_CONFIG)out_buf = (CX_CONFIG) {
+            .version = CX_CONFIG_VERSION,
+            .size = sizeof(CX_CONFIG),
+            .vmux = dev_ctx->attrs.vmux,
+            .level = dev_ctx->attrs.level,
+            .tenbit = dev_ctx->attrs.tenbit,
+            .sixdb = dev_ctx->attrs.sixdb,
+            .center_offset = dev_ctx->attrs.center_offset,
+            .irq_period = dev_ctx->attrs.irq_period,
+            .crystal = dev_ctx->attrs.crystal,
+            .ring_size = dev_ctx->ring.size ? dev_ctx->ring.size : dev_ctx->ring_alloc_size,
+            .is_capturing = dev_ctx->state.capture.is_capturing,
+            .ouflow_count = dev_ctx->state.ouflow_count,
+            .bus_number = dev_ctx->bus_number,
+            .dev_addr = dev_ctx->dev_addr,
+            .poll_rate = dev_ctx->attrs.poll_rate,
+            .keep_alive = dev_ctx->attrs.keep_alive,
+            .ring_release = dev_ctx->attrs.ring_release
+        };
+
+        out_len = sizeof(CX_CONFIG);
         break;
     }
 
-    case CX_IOCTL_SET_CENTER_OFFSET:
+    case CX_IOCTL_GET_BUS_NUMBER:
     {
-        if (in_buf == NULL || in_len != sizeof(LONG))
+        if (out_buf == NULL || out_len < sizeof(ULONG))
         {
-            status = STATUS_INVALID_PARAMETER;
+            status = STATUS_BUFFER_TOO_SMALL;
             break;
         }
 
-        LONG value = *(PLONG)in_buf;
+        *(PULONG)out_buf = dev_ctx->bus_number;
+        break;
+    }
 
-        if (value < CX_IOCTL_CENTER_OFFSET_MIN || value > CX_IOCTL_CENTER_OFFSET_MAX)
+    case CX_IOCTL_GET_DEVICE_ADDRESS:
+    {
+        if (out_buf == NULL || out_len < sizeof(ULONG))
         {
-            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid center_offset %d", value);
-            status = STATUS_INVALID_PARAMETER;
+            status = STATUS_BUFFER_TOO_SMALL;
             break;
         }
 
-        TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "setting center_center to %d", value);
-        dev_ctx->attrs.center_offset = value;
-        cx_set_center_offset(dev_ctx);
+        *(PULONG)out_buf = dev_ctx->dev_addr;
         break;
     }
 
-    case CX_IOCTL_SET_REGISTER:
+    case CX_IOCTL_GET_RING_SIZE:
     {
-        if (in_buf == NULL || in_len != sizeof(SET_REGISTER_DATA))
+        if (out_buf == NULL || out_len < sizeof(ULONG))
         {
-            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid data for set register %lld", in_len);
-            status = STATUS_INVALID_PARAMETER;
+            status = STATUS_BUFFER_TOO_SMALL;
             break;
         }
 
-        SET_REGISTER_DATA data = *(PSET_REGISTER_DATA)in_buf;
+        // the size it is allocated at if it is not allocated
+        *(PULONG)out_buf = dev_ctx->ring.size ? dev_ctx->ring.size : dev_ctx->ring_alloc_size;
+        break;
+    }
 
-        if (data.addr < CX_REGISTER_BASE || data.addr  > CX_REGISTER_END)
+    case CX_IOCTL_GET_RING_RELEASE:
+    {
+        if (out_buf == NULL || out_len < sizeof(ULONG))
         {
-            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "address %08X out of range", data.addr);
-            status = STATUS_INVALID_PARAMETER;
+            status = STATUS_BUFFER_TOO_SMALL;
             break;
         }
 
-        TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "writing %08X to %08X", data.val, data.addr);
-        cx_write(dev_ctx, data.addr, data.val);
+        *(PULONG)out_buf = dev_ctx->attrs.ring_release;
         break;
     }
 
-    case CX_IOCTL_MMAP:
+    case CX_IOCTL_GET_FIFO_GEOMETRY:
     {
-        if (out_buf == NULL || out_len != sizeof(MMAP_DATA))
+        if (out_buf == NULL || out_len < sizeof(CX_FIFO_GEOMETRY))
         {
             status = STATUS_BUFFER_TOO_SMALL;
             break;
         }
 
-        if (file_ctx->mmap_data.ptr == NULL)
+        *(PCX_FIFO_GEOMETRY)out_buf = dev_ctx->fifo;
+        out_len = sizeof(CX_FIFO_GEOMETRY);
+        break;
+    }
+
+    case CX_IOCTL_GET_REGISTER:
+    {
+        if (out_buf == NULL || in_buf == NULL || in_len < sizeof(ULONG) || out_len != sizeof(ULONG))
         {
-            file_ctx->mmap_data = (MMAP_DATA)
-            {
-                .ptr = MmMapLockedPagesSpecifyCache(dev_ctx->user_mdl, UserMode, MmNonCached, NULL, FALSE, NormalPagePriority)
-            };
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid data for get register %lld / %lld", in_len, out_len);
+            status = STATUS_INVALID_PARAMETER;
+            break;
         }
 
-        TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "mmap addr %p", file_ctx->mmap_data.ptr);
+        ULONG address = *(PULONG)in_buf;
 
-        *(PMMAP_DATA)out_buf = file_ctx->mmap_data;
+        if (address < CX_REGISTER_BASE || address > CX_REGISTER_END)
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "address %08X out of range", address);
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        *(PULONG)out_buf = cx_read(dev_ctx, address);
         break;
     }
 
-    case CX_IOCTL_MUNMAP:
+    case CX_IOCTL_RESET_OUFLOW_COUNT:
     {
-        if (file_ctx->mmap_data.ptr != NULL)
-        {
-            TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "munmap addr %p", file_ctx->mmap_data.ptr);
+        TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "resetting over/underflow count (current: %d)", dev_ctx->state.ouflow_count);
+        dev_ctx->state.ouflow_count = 0;
+        break;
+    }
 
-            MmUnmapLockedPages(file_ctx->mmap_data.ptr, dev_ctx->user_mdl);
-            file_ctx->mmap_data.ptr = NULL;
-        }
+    case CX_IOCTL_RESET_READER_STATS:
+    {
+        file_ctx->stats = (CX_READER_STATS){ 0 };
+        break;
+    }
 
+    case CX_IOCTL_RESET_STATS:
+    {
+        TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "resetting stats");
+        cx_reset_stats(dev_ctx);
         break;
     }
 
-    default:
-        status = STATUS_INVALID_DEVICE_REQUEST;
+    case CX_IOCTL_RESET_LATENCY:
+    {
+        TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "resetting latency histograms");
+        cx_reset_latency(dev_ctx);
         break;
     }
 
-    WdfRequestSetInformation(req, (ULONG_PTR)out_len);
-    WdfRequestComplete(req, status);
-}
+    case CX_IOCTL_SET_OVERRUN_POLICY:
+    {
+        if (in_buf == NULL || in_len != sizeof(ULONG))
+        {
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
 
-VOID cx_evt_io_read(
-    _In_ WDFQUEUE queue,
-    _In_ WDFREQUEST req,
-    _In_ size_t req_len
-)
-{
-    NTSTATUS status = STATUS_SUCCESS;
-    PDEVICE_CONTEXT dev_ctx = cx_device_get_ctx(WdfIoQueueGetDevice(queue));
-    PFILE_CONTEXT file_ctx = cx_file_get_ctx(WdfRequestGetFileObject(req));
+        ULONG value = *(PULONG)in_buf;
+
+        if (value > CX_IOCTL_OVERRUN_POLICY_MAX)
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid overrun_policy %u", value);
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "setting overrun_policy to %u", value);
+        file_ctx->overrun_policy = value;
+        break;
+    }
 
-    // start capture if idle
-    if (!dev_ctx->state.is_capturing)
+    case CX_IOCTL_SET_WAIT_POLICY:
     {
-        KeClearEvent(&dev_ctx->isr_event);
+        if (in_buf == NULL || in_len != sizeof(ULONG))
+        {
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
 
-        cx_start_capture(dev_ctx);
+        ULONG value = *(PULONG)in_buf;
 
-        status = KeWaitForSingleObject(&dev_ctx->isr_event, Executive, KernelMode, FALSE, NULL);
+        if (value > CX_IOCTL_WAIT_POLICY_MAX)
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid wait_policy %u", value);
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
 
-        if (!NT_SUCCESS(status))
+        TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "setting wait_policy to %u", value);
+        file_ctx->wait_policy = value;
+
+        // reads already waiting on the handle return what they have
+        if (value == CX_WAIT_POLICY_NONE)
         {
-            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "KeWaitForSingleObject failed with status %!STATUS!", status);
+            WdfWorkItemEnqueue(dev_ctx->read_work_item);
         }
 
-        InterlockedExchange(&dev_ctx->state.initial_page, dev_ctx->state.last_gp_cnt);
+        break;
     }
 
-    // new reader, increment count
-    if (!file_ctx->read_offset)
+    case CX_IOCTL_SET_READ_MODE:
     {
-        InterlockedIncrement(&dev_ctx->state.reader_count);
-    }
+        if (in_buf == NULL || in_len != sizeof(ULONG))
+        {
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
 
-    WDFMEMORY mem;
-    status = WdfRequestRetrieveOutputMemory(req, &mem);
+        ULONG value = *(PULONG)in_buf;
 
-    if (!NT_SUCCESS(status))
-    {
-        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "WdfRequestRetrieveOutputMemory failed with status %!STATUS!", status);
-        WdfRequestComplete(req, STATUS_UNSUCCESSFUL);
-        return;
-    }
+        if (value > CX_IOCTL_READ_MODE_MAX)
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid read_mode %u", value);
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        if (value != CX_READ_MODE_RAW && file_ctx->read_format != CX_READ_FORMAT_RAW)
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "read_mode %u needs the raw read_format", value);
+            status = STATUS_INVALID_DEVICE_STATE;
+            break;
+        }
 
-    LONG64 count = req_len;
-    LONG64 offset = file_ctx->read_offset;
-    LONG64 tgt_off = 0;
-    LONG page_no = cx_get_page_no(dev_ctx->state.initial_page, offset);
+        TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "setting read_mode to %u", value);
+        file_ctx->read_mode = value;
+        break;
+    }
 
-    while (count && dev_ctx->state.is_capturing)
+    case CX_IOCTL_SET_READ_FORMAT:
     {
-        while (count > 0 && page_no != dev_ctx->state.last_gp_cnt)
+        if (in_buf == NULL || in_len != sizeof(ULONG))
         {
-            LONG64 page_off = offset % PAGE_SIZE;
-            LONG64 len = page_off ? (PAGE_SIZE - page_off) : PAGE_SIZE;
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
 
-            if (len > count) {
-                len = count;
-            }
+        ULONG value = *(PULONG)in_buf;
 
-            WdfMemoryCopyFromBuffer(mem, tgt_off, &dev_ctx->dma_risc_page[page_no].va[page_off], len);
+        if (value > CX_IOCTL_READ_FORMAT_MAX)
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid read_format %u", value);
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
 
-            if (!NT_SUCCESS(status))
-            {
-                TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "WdfMemoryCopyFromBuffer failed with status %!STATUS!", status);
-                WdfRequestComplete(req, STATUS_UNSUCCESSFUL);
-                return;
-            }
+        if (value != CX_READ_FORMAT_RAW && file_ctx->read_mode != CX_READ_MODE_RAW)
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "read_format %u needs the raw read_mode", value);
+            status = STATUS_INVALID_DEVICE_STATE;
+            break;
+        }
 
-            count -= len;
-            tgt_off += len;
-            offset += len;
+        WdfWaitLockAcquire(dev_ctx->read_lock, NULL);
 
-            page_no = cx_get_page_no(dev_ctx->state.initial_page, offset);
+        // packed reads start on a group boundary
+        if (value == CX_READ_FORMAT_PACKED10)
+        {
+            LONG64 offset = file_ctx->read_offset;
+            InterlockedExchange64(&file_ctx->read_offset, (offset + CX_PACK10_GROUP_IN - 1) & ~(LONG64)(CX_PACK10_GROUP_IN - 1));
         }
 
-        // check over/underflow, increment count if set
-        if (cx_get_ouflow_state(dev_ctx))
+        TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "setting read_format to %u", value);
+        file_ctx->read_format = value;
+
+        WdfWaitLockRelease(dev_ctx->read_lock);
+        break;
+    }
+
+    case CX_IOCTL_SET_READ_POSITION:
+    {
+        if (in_buf == NULL || in_len != sizeof(CX_READ_POSITION))
         {
-            dev_ctx->state.ouflow_count += 1;
-            cx_reset_ouflow_state(dev_ctx);
+            status = STATUS_INVALID_PARAMETER;
+            break;
         }
 
-        if (count)
+        // in & out share the system buffer
+        CX_READ_POSITION data = *(PCX_READ_POSITION)in_buf;
+
+        if (data.origin > CX_READ_ORIGIN_TIME || data.offset < 0)
         {
-            KeClearEvent(&dev_ctx->isr_event);
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid read position %u / %lld", data.origin, data.offset);
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
 
-            // gp_cnt == page_no but read buffer is not filled
-            // wait for interrupt to trigger and continue
-            status = KeWaitForSingleObject(&dev_ctx->isr_event, Executive, KernelMode, FALSE, NULL);
+        CX_READ_POSITION_RESULT result;
+        cx_set_read_position(dev_ctx, file_ctx, data.origin, data.offset, &result);
 
-            if (!NT_SUCCESS(status))
-            {
-                TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "KeWaitForSingleObject failed with status %!STATUS!", status);
-                WdfRequestComplete(req, STATUS_UNSUCCESSFUL);
-                return;
-            }
+        // older clients only take the position
+        if (out_buf != NULL && out_len >= sizeof(LONG64))
+        {
+            out_len = min(out_len, sizeof(CX_READ_POSITION_RESULT));
+            RtlCopyMemory(out_buf, &result, out_len);
+        }
+        else
+        {
+            out_len = 0;
         }
+
+        break;
     }
 
-    // our read request does not contain an offset,
-    // so we keep track of it for the duration of the capture
-    InterlockedExchange64(&file_ctx->read_offset, offset);
+    case CX_IOCTL_SET_VMUX:
+    {
+        if (in_buf == NULL || in_len != sizeof(LONG))
+        {
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        LONG value = *(PLONG)in_buf;
+
+        if (value < CX_IOCTL_VMUX_MIN || value > CX_IOCTL_VMUX_MAX)
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid vmux %d", value);
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "setting vmux to %d", value);
+        dev_ctx->attrs.vmux = value;
+        cx_set_vmux(dev_ctx);
+        break;
+    }
+
+    case CX_IOCTL_SET_LEVEL:
+    {
+        if (in_buf == NULL || in_len != sizeof(LONG))
+        {
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        LONG value = *(PLONG)in_buf;
+
+        if (value < CX_IOCTL_LEVEL_MIN || value > CX_IOCTL_LEVEL_MAX)
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid level %d", value);
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "setting level to %d", value);
+        dev_ctx->attrs.level = value;
+        cx_set_level(dev_ctx);
+        break;
+    }
+
+    case CX_IOCTL_SET_TENBIT:
+    {
+        if (in_buf == NULL || in_len != sizeof(LONG))
+        {
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        LONG value = *(PLONG)in_buf;
+
+        if (value < CX_IOCTL_TENBIT_MIN || value > CX_IOCTL_TENBIT_MAX)
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid tenbit %d", value);
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "setting tenbit to %d", value);
+        dev_ctx->attrs.tenbit = value;
+        cx_set_tenbit(dev_ctx);
+        break;
+    }
+
+    case CX_IOCTL_SET_SIXDB:
+    {
+        if (in_buf == NULL || in_len != sizeof(LONG))
+        {
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        LONG value = *(PLONG)in_buf;
+
+        if (value < CX_IOCTL_SIXDB_MIN || value > CX_IOCTL_SIXDB_MAX)
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid sixdb %d", value);
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "setting sixdb to %d", value);
+        dev_ctx->attrs.sixdb = value;
+        cx_set_level(dev_ctx);
+        break;
+    }
+
+    case CX_IOCTL_SET_CENTER_OFFSET:
+    {
+        if (in_buf == NULL || in_len != sizeof(LONG))
+        {
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        LONG value = *(PLONG)in_buf;
+
+        if (value < CX_IOCTL_CENTER_OFFSET_MIN || value > CX_IOCTL_CENTER_OFFSET_MAX)
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid center_offset %d", value);
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "setting center_center to %d", value);
+        dev_ctx->attrs.center_offset = value;
+        cx_set_center_offset(dev_ctx);
+        break;
+    }
+
+    case CX_IOCTL_SET_IRQ_PERIOD:
+    {
+        if (in_buf == NULL || in_len != sizeof(ULONG))
+        {
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        ULONG value = *(PULONG)in_buf;
+
+        if (value < CX_IOCTL_IRQ_PERIOD_MIN || value > CX_IOCTL_IRQ_PERIOD_MAX || (value & (value - 1)))
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid irq_period %u", value);
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        // takes effect when the next capture starts
+        TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "setting irq_period to %u", value);
+        dev_ctx->attrs.irq_period = value;
+        break;
+    }
+
+    case CX_IOCTL_SET_POLL_RATE:
+    {
+        if (in_buf == NULL || in_len != sizeof(ULONG))
+        {
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        ULONG value = *(PULONG)in_buf;
+
+        if (value && (value < CX_IOCTL_POLL_RATE_MIN || value > CX_IOCTL_POLL_RATE_MAX))
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid poll_rate %u", value);
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        // takes effect when the next capture starts
+        TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "setting poll_rate to %u", value);
+        dev_ctx->attrs.poll_rate = value;
+        break;
+    }
+
+    case CX_IOCTL_SET_KEEP_ALIVE:
+    {
+        if (in_buf == NULL || in_len != sizeof(ULONG))
+        {
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        ULONG value = *(PULONG)in_buf;
+
+        if (value > CX_IOCTL_KEEP_ALIVE_MAX)
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid keep_alive %u", value);
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        cx_set_keep_alive(dev_ctx, value);
+        break;
+    }
+
+    case CX_IOCTL_SET_CONFIG:
+    {
+        if (in_buf == NULL || in_len != sizeof(CX_CONFIG))
+        {
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        status = cx_set_config(dev_ctx, (PCX_CONFIG)in_buf);
+        break;
+    }
+
+    case CX_IOCTL_SET_REGISTER:
+    {
+        if (in_buf == NULL || in_len != sizeof(SET_REGISTER_DATA))
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid data for set register %lld", in_len);
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        SET_REGISTER_DATA data = *(PSET_REGISTER_DATA)in_buf;
+
+        if (data.addr < CX_REGISTER_BASE || data.addr  > CX_REGISTER_END)
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "address %08X out of range", data.addr);
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "writing %08X to %08X", data.val, data.addr);
+        cx_write(dev_ctx, data.addr, data.val);
+        break;
+    }
+
+    case CX_IOCTL_SET_RING_SIZE:
+    {
+        if (in_buf == NULL || in_len != sizeof(ULONG))
+        {
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        ULONG value = *(PULONG)in_buf;
+
+        if (!cx_valid_ring_size(value))
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid ring_size %u", value);
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        status = cx_set_ring_size(dev_ctx, value);
+        break;
+    }
+
+    case CX_IOCTL_SET_RING_RELEASE:
+    {
+        if (in_buf == NULL || in_len != sizeof(ULONG))
+        {
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        ULONG value = *(PULONG)in_buf;
+
+        if (value > CX_IOCTL_RING_RELEASE_MAX)
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid ring_release %u", value);
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        cx_set_ring_release(dev_ctx, value);
+        break;
+    }
+
+    case CX_IOCTL_DETACH_USER_RING:
+    {
+        status = cx_release_user_ring(dev_ctx, WdfRequestGetFileObject(req), STATUS_SUCCESS);
+        break;
+    }
+
+    case CX_IOCTL_SYNC_START:
+    {
+        if (in_buf == NULL || in_len != sizeof(CX_SYNC_START_DATA))
+        {
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        if (out_buf == NULL || out_len < sizeof(CX_SYNC_START_RESULT))
+        {
+            status = STATUS_BUFFER_TOO_SMALL;
+            break;
+        }
+
+        // in & out share the system buffer
+        CX_SYNC_START_DATA data = *(PCX_SYNC_START_DATA)in_buf;
+
+        status = cx_sync_start_capture(file_ctx, &data, (PCX_SYNC_START_RESULT)out_buf);
+        break;
+    }
+
+    case CX_IOCTL_REGISTER_PROGRAM:
+    {
+        ULONG value_count;
+
+        if (in_buf == NULL ||
+            !cx_reg_program_valid((PCX_REG_PROGRAM)in_buf, in_len, CX_REGISTER_BASE, CX_REGISTER_END, &value_count))
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid register program (%lld bytes)", in_len);
+            status = STATUS_INVALID_PARAMETER;
+            break;
+        }
+
+        if (out_buf == NULL || out_len < cx_reg_program_result_size(value_count))
+        {
+            status = STATUS_BUFFER_TOO_SMALL;
+            break;
+        }
+
+        status = cx_run_reg_program(dev_ctx, (PCX_REG_PROGRAM)in_buf, in_len, (PCX_REG_PROGRAM_RESULT)out_buf);
+        out_len = NT_SUCCESS(status) ? cx_reg_program_result_size(value_count) : 0;
+        break;
+    }
+
+    default:
+        status = STATUS_INVALID_DEVICE_REQUEST;
+        break;
+    }
+
+    WdfRequestSetInformation(req, (ULONG_PTR)out_len);
+    WdfRequestComplete(req, status);
+}
+
+VOID cx_evt_io_read(
+    _In_ WDFQUEUE queue,
+    _In_ WDFREQUEST req,
+    _In_ size_t req_len
+)
+{
+    NTSTATUS status = STATUS_SUCCESS;
+    PDEVICE_CONTEXT dev_ctx = cx_device_get_ctx(WdfIoQueueGetDevice(queue));
+    PFILE_CONTEXT file_ctx = cx_file_get_ctx(WdfRequestGetFileObject(req));
+
+    UNREFERENCED_PARAMETER(req_len);
+
+    // the client owns the data while its ring is attached
+    if (dev_ctx->user_sg)
+    {
+        WdfRequestComplete(req, STATUS_INVALID_DEVICE_STATE);
+        return;
+    }
+
+    // packed reads assume raw16 samples
+    if (file_ctx->read_format == CX_READ_FORMAT_PACKED10 && !dev_ctx->attrs.tenbit)
+    {
+        WdfRequestComplete(req, STATUS_INVALID_DEVICE_STATE);
+        return;
+    }
+
+    WDF_REQUEST_PARAMETERS params;
+    WDF_REQUEST_PARAMETERS_INIT(&params);
+    WdfRequestGetParameters(req, &params);
+
+    if (file_ctx->read_mode == CX_READ_MODE_POSITIONAL && params.Parameters.Read.DeviceOffset < 0)
+    {
+        WdfRequestComplete(req, STATUS_INVALID_PARAMETER);
+        return;
+    }
+
+    // reads on several handles, or several reads on one, arrive together
+    // starting the capture, joining as a reader & parking are done as one against the last reader leaving
+    WdfWaitLockAcquire(dev_ctx->capture_lock, NULL);
+
+    // reading back a stopped capture, nothing to start
+    if (file_ctx->history_id)
+    {
+        if (cx_history_lost(dev_ctx, file_ctx))
+        {
+            WdfWaitLockRelease(dev_ctx->capture_lock);
+            WdfRequestComplete(req, STATUS_SUCCESS);
+            return;
+        }
+    }
+    else
+    {
+        CX_CAPTURE_ACTION action = cx_capture_join(&dev_ctx->state.capture);
+
+        // start capture if idle, the first interrupt sets the stream start
+        if (action == CX_CAPTURE_START)
+        {
+            status = cx_ensure_ring(dev_ctx);
+
+            if (!NT_SUCCESS(status))
+            {
+                WdfWaitLockRelease(dev_ctx->capture_lock);
+                WdfRequestComplete(req, status);
+                return;
+            }
+
+            cx_start_capture(dev_ctx);
+        }
+        // kept alive without readers, its start is long overwritten so a new reader takes the head
+        else if (action == CX_CAPTURE_RESUME)
+        {
+            WdfTimerStop(dev_ctx->idle_timer, FALSE);
+
+            if (!file_ctx->is_positioned)
+            {
+                CX_READ_POSITION_RESULT result;
+                cx_set_read_position(dev_ctx, file_ctx, CX_READ_ORIGIN_HEAD, 0, &result);
+            }
+        }
+
+        // new reader, increment count
+        cx_capture_add_reader(&dev_ctx->state.capture, &file_ctx->is_reader);
+    }
+
+    // park the read, it is filled & completed by cx_evt_read_work as data arrives
+    cx_request_get_ctx(req)->done = 0;
+    cx_request_get_ctx(req)->arrival_time = KeQueryPerformanceCounter(NULL).QuadPart;
+    cx_request_get_ctx(req)->pos = file_ctx->read_mode == CX_READ_MODE_POSITIONAL ? params.Parameters.Read.DeviceOffset : -1;
+
+    // a read that does not wait is served here & now, never parked
+    if (file_ctx->wait_policy == CX_WAIT_POLICY_NONE)
+    {
+        WdfWaitLockRelease(dev_ctx->capture_lock);
+
+        WdfWaitLockAcquire(dev_ctx->read_lock, NULL);
+        cx_service_read(dev_ctx, req);
+        WdfWaitLockRelease(dev_ctx->read_lock);
+        return;
+    }
+
+    status = WdfRequestForwardToIoQueue(req, dev_ctx->pending_queue);
+    WdfWaitLockRelease(dev_ctx->capture_lock);
+
+    if (!NT_SUCCESS(status))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "WdfRequestForwardToIoQueue failed with status %!STATUS!", status);
+        WdfRequestComplete(req, status);
+        return;
+    }
+
+    // data may already be available
+    WdfWorkItemEnqueue(dev_ctx->read_work_item);
+}
+
+VOID cx_evt_read_work(
+    _In_ WDFWORKITEM work_item
+)
+{
+    NTSTATUS status;
+    PDEVICE_CONTEXT dev_ctx = cx_device_get_ctx(WdfWorkItemGetParentObject(work_item));
+    WDFREQUEST tag = NULL;
+    WDFREQUEST req;
+    LONG64 wake_pos;
+    LONG64 req_wake_pos;
+
+    WdfWaitLockAcquire(dev_ctx->read_lock, NULL);
+
+    LONG64 dpc_timestamp = InterlockedExchange64(&dev_ctx->state.dpc_timestamp, 0);
+
+    if (dpc_timestamp)
+    {
+        cx_hist_add(&dev_ctx->latency[CX_LATENCY_DPC_TO_WORK], KeQueryPerformanceCounter(NULL).QuadPart - dpc_timestamp);
+    }
+
+    do
+    {
+        // lowest write_pos any read left parked is waiting for
+        wake_pos = MAXLONG64;
+        dev_ctx->state.read_pass++;
+
+        // pending reads are visited in arrival order, so reads on the same handle complete in order
+        // positional reads do not depend on each other and complete as soon as their window is full
+        while (TRUE)
+        {
+            status = WdfIoQueueFindRequest(dev_ctx->pending_queue, tag, NULL, NULL, &req);
+
+            if (tag)
+            {
+                WdfObjectDereference(tag);
+                tag = NULL;
+            }
+
+            // tag was cancelled or completed, start again from the head
+            if (status == STATUS_NOT_FOUND)
+            {
+                dev_ctx->state.read_pass++;
+                continue;
+            }
+
+            if (!NT_SUCCESS(status))
+            {
+                break;
+            }
+
+            if (!cx_read_ready(dev_ctx, req, &req_wake_pos))
+            {
+                wake_pos = min(wake_pos, req_wake_pos);
+                tag = req;
+                continue;
+            }
+
+            WDFREQUEST found_req = req;
+            status = WdfIoQueueRetrieveFoundRequest(dev_ctx->pending_queue, found_req, &req);
+            WdfObjectDereference(found_req);
+
+            if (!NT_SUCCESS(status))
+            {
+                continue;
+            }
+
+            cx_service_read(dev_ctx, req);
+        }
+
+        // the dpc only queues this once write_pos reaches wake_pos, one that published during
+        // the pass may have compared against the old value, so look again rather than miss it
+    } while (cx_wake_set(&dev_ctx->state.write_pos, &dev_ctx->state.wake_pos, wake_pos));
+
+    WdfWaitLockRelease(dev_ctx->read_lock);
+}
+
+BOOLEAN cx_read_ready(
+    _In_ PDEVICE_CONTEXT dev_ctx,
+    _In_ WDFREQUEST req,
+    _Out_ PLONG64 wake_pos
+)
+{
+    WDF_REQUEST_PARAMETERS params;
+    PFILE_CONTEXT file_ctx = cx_file_get_ctx(WdfRequestGetFileObject(req));
+    PREQUEST_CONTEXT req_ctx = cx_request_get_ctx(req);
+    LONG64 len;
+
+    WDF_REQUEST_PARAMETERS_INIT(&params);
+    WdfRequestGetParameters(req, &params);
+
+    *wake_pos = MAXLONG64;
+
+    // completes with what it has
+    if (cx_history_lost(dev_ctx, file_ctx) || file_ctx->wait_policy == CX_WAIT_POLICY_NONE)
+    {
+        return TRUE;
+    }
+
+    BOOLEAN positional = req_ctx->pos >= 0;
+
+    // an earlier read of this handle is still filling, this one continues where that ends
+    if (!positional && file_ctx->parked_pass == dev_ctx->state.read_pass)
+    {
+        return FALSE;
+    }
+
+    BOOLEAN is_capturing = dev_ctx->state.capture.is_capturing;
+    LONG64 write_pos = InterlockedCompareExchange64(&dev_ctx->state.write_pos, 0, 0);
+    LONG64 read_pos = positional ? req_ctx->pos : file_ctx->read_offset;
+    LONG64 remaining = cx_read_space(file_ctx, params.Parameters.Read.Length, req_ctx->done);
+
+    CX_READ_ACTION action = cx_read_step(&dev_ctx->ring,
+        write_pos,
+        read_pos,
+        req_ctx->done,
+        remaining,
+        positional ? CX_OVERRUN_POLICY_FAIL : file_ctx->overrun_policy,
+        is_capturing,
+        &len);
+
+    // a read that is still filling is left alone until it can be filled in one go,
+    // rather than copied into a block at a time
+    if (action == CX_READ_WAIT || (action == CX_READ_COPY && is_capturing))
+    {
+        *wake_pos = cx_read_wake_pos(&dev_ctx->ring, read_pos, remaining);
+
+        if (write_pos < *wake_pos)
+        {
+            if (!positional)
+            {
+                file_ctx->parked_pass = dev_ctx->state.read_pass;
+            }
+
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+VOID cx_service_read(
+    _In_ PDEVICE_CONTEXT dev_ctx,
+    _In_ WDFREQUEST req
+)
+{
+    NTSTATUS status = STATUS_SUCCESS;
+    PFILE_CONTEXT file_ctx = cx_file_get_ctx(WdfRequestGetFileObject(req));
+    PREQUEST_CONTEXT req_ctx = cx_request_get_ctx(req);
+    WDF_REQUEST_PARAMETERS params;
+    WDFMEMORY mem;
+    LONG64 start_time = KeQueryPerformanceCounter(NULL).QuadPart;
+
+    WDF_REQUEST_PARAMETERS_INIT(&params);
+    WdfRequestGetParameters(req, &params);
+
+    status = WdfRequestRetrieveOutputMemory(req, &mem);
+
+    if (!NT_SUCCESS(status))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "WdfRequestRetrieveOutputMemory failed with status %!STATUS!", status);
+        cx_complete_read(dev_ctx, file_ctx, req, STATUS_UNSUCCESSFUL);
+        return;
+    }
+
+    // the stopped capture it was reading was replaced while it waited
+    if (cx_history_lost(dev_ctx, file_ctx))
+    {
+        cx_complete_read(dev_ctx, file_ctx, req, STATUS_SUCCESS);
+        return;
+    }
+
+    // positional reads keep their own position and fail if their window has gone
+    BOOLEAN positional = req_ctx->pos >= 0;
+    LONG64 req_len = params.Parameters.Read.Length;
+    LONG64 offset = positional ? req_ctx->pos : file_ctx->read_offset;
+    ULONG overrun_policy = positional ? CX_OVERRUN_POLICY_FAIL : file_ctx->overrun_policy;
+    LONG64 hdr_len = file_ctx->read_mode == CX_READ_MODE_FRAMED ? sizeof(CX_FRAME_HEADER) : 0;
+    CX_READ_ACTION action;
+
+    do
+    {
+        LONG64 write_pos = InterlockedCompareExchange64(&dev_ctx->state.write_pos, 0, 0);
+        LONG64 len;
+
+        cx_update_reader_lag(dev_ctx, file_ctx, write_pos - offset);
+
+        action = cx_read_step(&dev_ctx->ring, write_pos, offset, req_ctx->done,
+            cx_read_space(file_ctx, req_len, req_ctx->done),
+            overrun_policy, dev_ctx->state.capture.is_capturing, &len);
+
+        switch (action)
+        {
+        case CX_READ_COPY:
+        {
+            // a frame holds data from one block only
+            if (hdr_len)
+            {
+                status = cx_copy_frame_header(dev_ctx, file_ctx, mem, (size_t)req_ctx->done, offset, &len);
+            }
+
+            if (NT_SUCCESS(status) && file_ctx->read_format == CX_READ_FORMAT_PACKED10)
+            {
+                status = cx_pack_from_ring(dev_ctx, mem, (size_t)req_ctx->done, offset, len);
+            }
+            else if (NT_SUCCESS(status))
+            {
+                status = cx_copy_from_ring(dev_ctx, mem, (size_t)(req_ctx->done + hdr_len), offset, len);
+            }
+
+            if (!NT_SUCCESS(status))
+            {
+                TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "WdfMemoryCopyFromBuffer failed with status %!STATUS!", status);
+
+                if (!positional)
+                {
+                    InterlockedExchange64(&file_ctx->read_offset, offset);
+                }
+
+                cx_complete_read(dev_ctx, file_ctx, req, STATUS_UNSUCCESSFUL);
+                return;
+            }
+
+            // the data may have been overwritten while copying, if so drop it and handle the overrun
+            write_pos = InterlockedCompareExchange64(&dev_ctx->state.write_pos, 0, 0);
+
+            if (!cx_ring_lost(&dev_ctx->ring, write_pos, offset))
+            {
+                req_ctx->done += hdr_len + cx_read_out_len(file_ctx, len);
+                offset += len;
+                file_ctx->frame_gap = FALSE;
+            }
+
+            break;
+        }
+
+        case CX_READ_SKIP:
+        case CX_READ_SHORT:
+        case CX_READ_FAIL:
+        {
+            TraceEvents(TRACE_LEVEL_WARNING, DBG_GENERAL, "reader overrun at %lld, lost %lld bytes", offset, len);
+
+            file_ctx->stats.overrun_count += 1;
+            file_ctx->stats.bytes_lost += len;
+            file_ctx->frame_gap = TRUE;
+            offset += len;
+
+            if (action == CX_READ_FAIL)
+            {
+                // data already copied to the request is discarded too
+                file_ctx->stats.bytes_lost += req_ctx->done;
+                req_ctx->done = 0;
+            }
+
+            break;
+        }
+
+        default:
+            break;
+        }
+    } while (action == CX_READ_COPY || action == CX_READ_SKIP);
+
+    // a plain read request does not contain an offset,
+    // so we keep track of it for the duration of the capture
+    if (positional)
+    {
+        req_ctx->pos = offset;
+    }
+    else
+    {
+        InterlockedExchange64(&file_ctx->read_offset, offset);
+    }
+
+    cx_hist_add(&dev_ctx->latency[CX_LATENCY_SERVICE], KeQueryPerformanceCounter(NULL).QuadPart - start_time);
+
+    switch (action)
+    {
+    case CX_READ_WAIT:
+        // nothing more for now & the reader does not wait for it
+        if (file_ctx->wait_policy == CX_WAIT_POLICY_NONE)
+        {
+            cx_complete_read(dev_ctx, file_ctx, req, STATUS_SUCCESS);
+            break;
+        }
+
+        // partially filled, back to the head of the queue until the next interrupt
+        status = WdfRequestRequeue(req);
+
+        if (!NT_SUCCESS(status))
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "WdfRequestRequeue failed with status %!STATUS!", status);
+            cx_complete_read(dev_ctx, file_ctx, req, STATUS_SUCCESS);
+        }
+
+        break;
+
+    case CX_READ_FAIL:
+        cx_complete_read(dev_ctx, file_ctx, req, STATUS_DATA_OVERRUN);
+        break;
+
+    default:
+        cx_complete_read(dev_ctx, file_ctx, req, STATUS_SUCCESS);
+        break;
+    }
+}
+
+// complete a read taken from pending_queue, returning done bytes if it succeeded
+VOID cx_complete_read(
+    _In_ PDEVICE_CONTEXT dev_ctx,
+    _Inout_ PFILE_CONTEXT file_ctx,
+    _In_ WDFREQUEST req,
+    _In_ NTSTATUS status
+)
+{
+    PREQUEST_CONTEXT req_ctx = cx_request_get_ctx(req);
+    LONG64 len = NT_SUCCESS(status) ? req_ctx->done : 0;
+    LONG64 wait_time = KeQueryPerformanceCounter(NULL).QuadPart - req_ctx->arrival_time;
+
+    file_ctx->stats.bytes_copied += len;
+    file_ctx->stats.reads_completed += 1;
+
+    InterlockedAdd64(&dev_ctx->stats.bytes_copied, len);
+    InterlockedIncrement64(&dev_ctx->stats.reads_completed);
+    InterlockedAdd64(&dev_ctx->stats.read_wait_time, wait_time);
+    cx_hist_add(&dev_ctx->latency[CX_LATENCY_READ], wait_time);
+
+    WdfRequestCompleteWithInformation(req, status, (ULONG_PTR)len);
+}
+
+LONG64 cx_read_space(
+    _In_ PFILE_CONTEXT file_ctx,
+    _In_ LONG64 req_len,
+    _In_ LONG64 done
+)
+{
+    LONG64 space = req_len - done;
+
+    // framed reads need room for a header and at least one byte of data
+    if (file_ctx->read_mode == CX_READ_MODE_FRAMED)
+    {
+        space = space > (LONG64)sizeof(CX_FRAME_HEADER) ? space - sizeof(CX_FRAME_HEADER) : 0;
+    }
+
+    // packed reads take whole groups, space is in captured bytes
+    if (file_ctx->read_format == CX_READ_FORMAT_PACKED10)
+    {
+        space = (space / CX_PACK10_GROUP_OUT) * CX_PACK10_GROUP_IN;
+    }
+
+    return space;
+}
+
+// bytes returned to the reader for len captured bytes
+LONG64 cx_read_out_len(
+    _In_ PFILE_CONTEXT file_ctx,
+    _In_ LONG64 len
+)
+{
+    if (file_ctx->read_format == CX_READ_FORMAT_PACKED10)
+    {
+        return (len / CX_PACK10_GROUP_IN) * CX_PACK10_GROUP_OUT;
+    }
+
+    return len;
+}
+
+NTSTATUS cx_copy_frame_header(
+    _In_ PDEVICE_CONTEXT dev_ctx,
+    _Inout_ PFILE_CONTEXT file_ctx,
+    _In_ WDFMEMORY mem,
+    _In_ size_t tgt_off,
+    _In_ LONG64 pos,
+    _Inout_ PLONG64 len
+)
+{
+    CX_FRAME_HEADER hdr;
+    CX_BLOCK_INFO info;
+
+    BOOLEAN found = cx_frame_find_block(dev_ctx->blocks,
+        dev_ctx->block_count,
+        InterlockedCompareExchange64(&dev_ctx->state.block_seq, 0, 0),
+        pos,
+        &file_ctx->frame_seq,
+        &info);
+
+    if (found)
+    {
+        *len = min(*len, info.end_pos - pos);
+    }
+
+    cx_frame_fill_header(&hdr,
+        found ? &info : NULL,
+        pos,
+        (ULONG)*len,
+        file_ctx->frame_gap ? CX_FRAME_FLAG_GAP : 0,
+        dev_ctx->state.timestamp_freq);
+
+    return WdfMemoryCopyFromBuffer(mem, tgt_off, &hdr, sizeof(CX_FRAME_HEADER));
+}
+
+NTSTATUS cx_copy_from_ring(
+    _In_ PDEVICE_CONTEXT dev_ctx,
+    _In_ WDFMEMORY mem,
+    _In_ size_t tgt_off,
+    _In_ LONG64 pos,
+    _In_ LONG64 len
+)
+{
+    RING_COPY_DATA copy =
+    {
+        .dev_ctx = dev_ctx,
+        .mem = mem,
+        .tgt_off = tgt_off,
+        .status = STATUS_SUCCESS
+    };
+
+    cx_ring_copy(&dev_ctx->ring, dev_ctx->state.initial_page, pos, len, cx_copy_span, &copy);
+    return copy.status;
+}
+
+BOOLEAN cx_copy_span(
+    _In_ PVOID ctx,
+    _In_ ULONG chunk_idx,
+    _In_ ULONG chunk_off,
+    _In_ ULONG span,
+    _In_ LONG64 done
+)
+{
+    PRING_COPY_DATA copy = (PRING_COPY_DATA)ctx;
+
+    copy->status = WdfMemoryCopyFromBuffer(copy->mem, copy->tgt_off + (size_t)done,
+        &copy->dev_ctx->dma_risc_chunk[chunk_idx].va[chunk_off], span);
+
+    return NT_SUCCESS(copy->status);
+}
+
+// pack len bytes at stream position pos into mem at tgt_off, len and pos must be whole groups
+NTSTATUS cx_pack_from_ring(
+    _In_ PDEVICE_CONTEXT dev_ctx,
+    _In_ WDFMEMORY mem,
+    _In_ size_t tgt_off,
+    _In_ LONG64 pos,
+    _In_ LONG64 len
+)
+{
+    size_t buf_len;
+    RING_COPY_DATA copy =
+    {
+        .dev_ctx = dev_ctx,
+        .buf = WdfMemoryGetBuffer(mem, &buf_len),
+        .tgt_off = tgt_off,
+        .status = STATUS_SUCCESS
+    };
+
+    if (tgt_off + (size_t)((len / CX_PACK10_GROUP_IN) * CX_PACK10_GROUP_OUT) > buf_len)
+    {
+        return STATUS_BUFFER_TOO_SMALL;
+    }
+
+    cx_ring_copy(&dev_ctx->ring, dev_ctx->state.initial_page, pos, len, cx_pack_span, &copy);
+    return copy.status;
+}
+
+// chunks are whole groups, so a span never splits one
+BOOLEAN cx_pack_span(
+    _In_ PVOID ctx,
+    _In_ ULONG chunk_idx,
+    _In_ ULONG chunk_off,
+    _In_ ULONG span,
+    _In_ LONG64 done
+)
+{
+    PRING_COPY_DATA copy = (PRING_COPY_DATA)ctx;
+
+    cx_pack10(copy->buf + copy->tgt_off + (size_t)(done / CX_PACK10_GROUP_IN) * CX_PACK10_GROUP_OUT,
+        &copy->dev_ctx->dma_risc_chunk[chunk_idx].va[chunk_off],
+        span / CX_PACK10_GROUP_IN);
+
+    return TRUE;
+}
+
+// validate a whole configuration, then apply it
+NTSTATUS cx_set_config(
+    _Inout_ PDEVICE_CONTEXT dev_ctx,
+    _In_ PCX_CONFIG config
+)
+{
+    if (config->version != CX_CONFIG_VERSION || config->size != sizeof(CX_CONFIG))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid config version %u size %u", config->version, config->size);
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    if (config->vmux < CX_IOCTL_VMUX_MIN || config->vmux > CX_IOCTL_VMUX_MAX ||
+        config->level < CX_IOCTL_LEVEL_MIN || config->level > CX_IOCTL_LEVEL_MAX ||
+        config->tenbit < CX_IOCTL_TENBIT_MIN || config->tenbit > CX_IOCTL_TENBIT_MAX ||
+        config->sixdb < CX_IOCTL_SIXDB_MIN || config->sixdb > CX_IOCTL_SIXDB_MAX ||
+        config->center_offset < CX_IOCTL_CENTER_OFFSET_MIN || config->center_offset > CX_IOCTL_CENTER_OFFSET_MAX ||
+        config->irq_period < CX_IOCTL_IRQ_PERIOD_MIN || config->irq_period > CX_IOCTL_IRQ_PERIOD_MAX ||
+        (config->irq_period & (config->irq_period - 1)) ||
+        (config->poll_rate && (config->poll_rate < CX_IOCTL_POLL_RATE_MIN || config->poll_rate > CX_IOCTL_POLL_RATE_MAX)) ||
+        config->keep_alive > CX_IOCTL_KEEP_ALIVE_MAX ||
+        config->ring_release > CX_IOCTL_RING_RELEASE_MAX)
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid config vmux %d level %d tenbit %d sixdb %d center_offset %d irq_period %u poll_rate %u keep_alive %u ring_release %u",
+            config->vmux, config->level, config->tenbit, config->sixdb, config->center_offset, config->irq_period, config->poll_rate,
+            config->keep_alive, config->ring_release);
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "setting config vmux %d level %d tenbit %d sixdb %d center_offset %d irq_period %u poll_rate %u",
+        config->vmux, config->level, config->tenbit, config->sixdb, config->center_offset, config->irq_period, config->poll_rate);
+
+    dev_ctx->attrs.vmux = config->vmux;
+    dev_ctx->attrs.level = config->level;
+    dev_ctx->attrs.tenbit = config->tenbit;
+    dev_ctx->attrs.sixdb = config->sixdb;
+    dev_ctx->attrs.center_offset = config->center_offset;
+    dev_ctx->attrs.irq_period = config->irq_period;
+    dev_ctx->attrs.poll_rate = config->poll_rate;
+
+    // level & sixdb share a register, so they change together
+    cx_set_vmux(dev_ctx);
+    cx_set_tenbit(dev_ctx);
+    cx_set_level(dev_ctx);
+    cx_set_center_offset(dev_ctx);
+
+    // only a change restarts the wait of a capture being kept alive, or of a ring waiting to be released
+    if (config->keep_alive != dev_ctx->attrs.keep_alive)
+    {
+        cx_set_keep_alive(dev_ctx, config->keep_alive);
+    }
+
+    if (config->ring_release != dev_ctx->attrs.ring_release)
+    {
+        cx_set_ring_release(dev_ctx, config->ring_release);
+    }
+
+    return STATUS_SUCCESS;
+}
+
+// a capture being kept alive waits the new time from now, or stops
+VOID cx_set_keep_alive(
+    _Inout_ PDEVICE_CONTEXT dev_ctx,
+    _In_ ULONG keep_alive
+)
+{
+    TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "setting keep_alive to %u", keep_alive);
+
+    WdfWaitLockAcquire(dev_ctx->capture_lock, NULL);
+    dev_ctx->attrs.keep_alive = keep_alive;
+
+    cx_apply_capture_action(dev_ctx,
+        cx_capture_set_keep_alive(&dev_ctx->state.capture, keep_alive, (LONG64)KeQueryInterruptTime()), 0);
+
+    WdfWaitLockRelease(dev_ctx->capture_lock);
+}
+
+// a ring waiting to be released waits the new time from now, 0 keeps it
+VOID cx_set_ring_release(
+    _Inout_ PDEVICE_CONTEXT dev_ctx,
+    _In_ ULONG ring_release
+)
+{
+    TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "setting ring_release to %u", ring_release);
+
+    WdfWaitLockAcquire(dev_ctx->capture_lock, NULL);
+    dev_ctx->attrs.ring_release = ring_release;
+
+    if (dev_ctx->state.release_time)
+    {
+        if (ring_release)
+        {
+            dev_ctx->state.release_time = (LONG64)KeQueryInterruptTime();
+            WdfTimerStart(dev_ctx->release_timer, WDF_REL_TIMEOUT_IN_MS(ring_release));
+        }
+        else
+        {
+            dev_ctx->state.release_time = 0;
+        }
+    }
+
+    WdfWaitLockRelease(dev_ctx->capture_lock);
+}
+
+// move the handle's next read, O(1) from the last published write_pos, see CX_READ_POSITION
+VOID cx_set_read_position(
+    _In_ PDEVICE_CONTEXT dev_ctx,
+    _Inout_ PFILE_CONTEXT file_ctx,
+    _In_ ULONG origin,
+    _In_ LONG64 offset,
+    _Out_ PCX_READ_POSITION_RESULT result
+)
+{
+    WdfWaitLockAcquire(dev_ctx->read_lock, NULL);
+
+    BOOLEAN is_capturing = dev_ctx->state.capture.is_capturing;
+    LONG64 write_pos = InterlockedCompareExchange64(&dev_ctx->state.write_pos, 0, 0);
+    LONG64 pos;
+
+    if (origin == CX_READ_ORIGIN_TIME)
+    {
+        // the dpc stamps blocks with the performance counter, anything too far back is before them all
+        LARGE_INTEGER freq;
+        LONG64 timestamp = KeQueryPerformanceCounter(&freq).QuadPart;
+        timestamp = offset < MAXLONG64 / freq.QuadPart ? timestamp - offset * freq.QuadPart / 1000 : 0;
+
+        pos = cx_frame_time_pos(dev_ctx->blocks, dev_ctx->block_count,
+            InterlockedCompareExchange64(&dev_ctx->state.block_seq, 0, 0), timestamp, write_pos);
+
+        pos = cx_ring_join_pos(&dev_ctx->ring, write_pos, CX_READ_ORIGIN_START, pos);
+    }
+    else
+    {
+        pos = cx_ring_join_pos(&dev_ctx->ring, write_pos, origin, offset);
+    }
+
+    // a position inside the stopped capture reads it back, anything else waits for the next one from 0
+    file_ctx->history_id = 0;
+
+    if (!is_capturing)
+    {
+        if (origin != CX_READ_ORIGIN_START && pos < write_pos)
+        {
+            file_ctx->history_id = dev_ctx->state.capture_id;
+        }
+        else
+        {
+            // the next capture restarts from 0
+            write_pos = 0;
+            pos = cx_ring_join_pos(&dev_ctx->ring, 0, origin == CX_READ_ORIGIN_TIME ? CX_READ_ORIGIN_HEAD : origin, offset);
+        }
+    }
+
+    // packed reads start on a group boundary
+    if (file_ctx->read_format == CX_READ_FORMAT_PACKED10)
+    {
+        pos = (pos + CX_PACK10_GROUP_IN - 1) & ~(LONG64)(CX_PACK10_GROUP_IN - 1);
+    }
+
+    TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "setting read position to %lld (write_pos %lld)", pos, write_pos);
+
+    // a framed reader sees the jump as a gap
+    if (pos != file_ctx->read_offset)
+    {
+        file_ctx->frame_gap = TRUE;
+    }
+
+    InterlockedExchange64(&file_ctx->read_offset, pos);
+    file_ctx->is_positioned = TRUE;
+
+    // reads parked on this handle now wait for another position, have the next dpc look again
+    InterlockedExchange64(&dev_ctx->state.wake_pos, 0);
+
+    result->pos = pos;
+    result->write_pos = write_pos;
+
+    WdfWaitLockRelease(dev_ctx->read_lock);
+}
+
+// what the handle could read now, see CX_IOCTL_GET_AVAILABLE
+VOID cx_get_available(
+    _In_ PDEVICE_CONTEXT dev_ctx,
+    _In_ PFILE_CONTEXT file_ctx,
+    _Out_ PCX_AVAILABLE available
+)
+{
+    LONG64 write_pos = InterlockedCompareExchange64(&dev_ctx->state.write_pos, 0, 0);
+    LONG64 read_pos = InterlockedCompareExchange64(&file_ctx->read_offset, 0, 0);
+
+    *available = (CX_AVAILABLE){
+        .read_pos = read_pos,
+        .write_pos = write_pos,
+        .is_capturing = dev_ctx->state.capture.is_capturing
+    };
+
+    // the history it was reading is gone
+    if (cx_history_lost(dev_ctx, file_ctx))
+    {
+        return;
+    }
+
+    available->bytes = cx_ring_available(&dev_ctx->ring, write_pos, read_pos);
+    available->lost = cx_ring_lost(&dev_ctx->ring, write_pos, read_pos);
+}
+
+// a handle reading back a stopped capture has lost it once another capture or ring replaced it
+BOOLEAN cx_history_lost(
+    _In_ PDEVICE_CONTEXT dev_ctx,
+    _In_ PFILE_CONTEXT file_ctx
+)
+{
+    return file_ctx->history_id && file_ctx->history_id != dev_ctx->state.capture_id;
+}
+
+VOID cx_update_reader_lag(
+    _Inout_ PDEVICE_CONTEXT dev_ctx,
+    _Inout_ PFILE_CONTEXT file_ctx,
+    _In_ LONG64 lag
+)
+{
+    file_ctx->stats.lag = lag;
+
+    if (lag > file_ctx->stats.peak_lag)
+    {
+        file_ctx->stats.peak_lag = lag;
+    }
+
+    if (lag > dev_ctx->stats.max_reader_lag)
+    {
+        dev_ctx->stats.max_reader_lag = lag;
+    }
+}
+
+// map the ring & its header read-only into the calling process, with capture_lock held
+// while a client ring is attached only the header is mapped, the client has the ring it describes
+// and a mapping of the kernel ring would show a ring the header does not describe
+NTSTATUS cx_mmap_ring(
+    _Inout_ PDEVICE_CONTEXT dev_ctx,
+    _Inout_ PFILE_CONTEXT file_ctx
+)
+{
+    NTSTATUS status = STATUS_SUCCESS;
+    BOOLEAN map_ring = !dev_ctx->user_sg && !file_ctx->ring_mmap_data.ring;
+    PVOID hdr = NULL;
+    PVOID ring = NULL;
+
+    // mapping counts as using the ring, it is allocated for it & not released while mapped
+    if (map_ring)
+    {
+        status = cx_ensure_ring(dev_ctx);
+
+        if (!NT_SUCCESS(status) || !dev_ctx->ring_mdl)
+        {
+            return NT_SUCCESS(status) ? STATUS_DEVICE_NOT_READY : status;
+        }
+    }
+
+    // both mappings are read-only, MmMapLockedPagesSpecifyCache raises on failure for UserMode
+    __try
+    {
+        if (!file_ctx->ring_mmap_data.hdr)
+        {
+            hdr = MmMapLockedPagesSpecifyCache(dev_ctx->ring_hdr_mdl,
+                UserMode, MmCached, NULL, FALSE, NormalPagePriority | MdlMappingNoWrite | MdlMappingNoExecute);
+        }
+
+        if (map_ring)
+        {
+            ring = MmMapLockedPagesSpecifyCache(dev_ctx->ring_mdl,
+                UserMode, MmCached, NULL, FALSE, NormalPagePriority | MdlMappingNoWrite | MdlMappingNoExecute);
+        }
+    }
+    __except (EXCEPTION_EXECUTE_HANDLER)
+    {
+        status = GetExceptionCode();
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "MmMapLockedPagesSpecifyCache failed with status %!STATUS!", status);
+    }
+
+    if (!NT_SUCCESS(status) || (!hdr && !file_ctx->ring_mmap_data.hdr) || (map_ring && !ring))
+    {
+        if (ring)
+        {
+            MmUnmapLockedPages(ring, dev_ctx->ring_mdl);
+        }
+
+        if (hdr)
+        {
+            MmUnmapLockedPages(hdr, dev_ctx->ring_hdr_mdl);
+        }
+
+        return NT_SUCCESS(status) ? STATUS_INSUFFICIENT_RESOURCES : status;
+    }
+
+    if (hdr)
+    {
+        file_ctx->ring_mmap_data.hdr = hdr;
+    }
+
+    // the ring can't be resized, released or replaced by a client ring while any user mapping of it exists
+    if (ring)
+    {
+        file_ctx->ring_mmap_data.ring = ring;
+        InterlockedIncrement(&dev_ctx->ring_map_count);
+    }
+
+    return status;
+}
+
+// undo cx_mmap_ring, in the process that mapped it with capture_lock held
+VOID cx_munmap_ring(
+    _Inout_ PDEVICE_CONTEXT dev_ctx,
+    _Inout_ PFILE_CONTEXT file_ctx
+)
+{
+    if (file_ctx->ring_mmap_data.ring != NULL)
+    {
+        TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "munmap ring addr %p", file_ctx->ring_mmap_data.ring);
+
+        MmUnmapLockedPages(file_ctx->ring_mmap_data.ring, dev_ctx->ring_mdl);
+        file_ctx->ring_mmap_data.ring = NULL;
+
+        InterlockedDecrement(&dev_ctx->ring_map_count);
+    }
+
+    if (file_ctx->ring_mmap_data.hdr != NULL)
+    {
+        MmUnmapLockedPages(file_ctx->ring_mmap_data.hdr, dev_ctx->ring_hdr_mdl);
+        file_ctx->ring_mmap_data.hdr = NULL;
+    }
+}
+
+NTSTATUS cx_set_ring_size(
+    _Inout_ PDEVICE_CONTEXT dev_ctx,
+    _In_ ULONG ring_size
+)
+{
+    NTSTATUS status = STATUS_SUCCESS;
+
+    if (dev_ctx->user_sg)
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "user ring attached, cannot resize");
+        return STATUS_DEVICE_BUSY;
+    }
+
+    if (ring_size == dev_ctx->ring_alloc_size)
+    {
+        return status;
+    }
+
+    // no reads may start a capture or touch the ring while it is replaced, nor can the release timer free it
+    WdfIoQueueStopSynchronously(dev_ctx->read_queue);
+    WdfWorkItemFlush(dev_ctx->read_work_item);
+    WdfWaitLockAcquire(dev_ctx->capture_lock, NULL);
+
+    if (dev_ctx->state.capture.is_capturing || dev_ctx->ring_map_count)
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "ring in use, cannot resize (capturing %d, mapped %d)",
+            dev_ctx->state.capture.is_capturing, dev_ctx->ring_map_count);
+        WdfWaitLockRelease(dev_ctx->capture_lock);
+        WdfIoQueueStart(dev_ctx->read_queue);
+        return STATUS_DEVICE_BUSY;
+    }
+
+    // not allocated, the next capture allocates it at the new size
+    if (!dev_ctx->ring.size)
+    {
+        TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "setting ring size to %u kbytes", ring_size / 1024);
+
+        dev_ctx->ring_alloc_size = ring_size;
+        WdfWaitLockRelease(dev_ctx->capture_lock);
+        WdfIoQueueStart(dev_ctx->read_queue);
+        return status;
+    }
+
+    ULONG prev_size = dev_ctx->ring.size;
+
+    TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "resizing ring from %u to %u kbytes", prev_size / 1024, ring_size / 1024);
+
+    // the last capture goes with the old ring
+    InterlockedIncrement(&dev_ctx->state.capture_id);
+    InterlockedExchange64(&dev_ctx->state.write_pos, 0);
+
+    cx_free_ring(dev_ctx);
+    status = cx_alloc_ring(dev_ctx, ring_size);
+
+    if (!NT_SUCCESS(status))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "cx_alloc_ring (%u kbytes) failed with status %!STATUS!, restoring %u kbytes",
+            ring_size / 1024, status, prev_size / 1024);
+
+        // left unallocated otherwise, the next capture tries again
+        NTSTATUS restore_status = cx_alloc_ring(dev_ctx, prev_size);
+
+        if (!NT_SUCCESS(restore_status))
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "cx_alloc_ring (%u kbytes) failed with status %!STATUS!",
+                prev_size / 1024, restore_status);
+        }
+    }
+    else
+    {
+        dev_ctx->ring_alloc_size = ring_size;
+    }
+
+    if (dev_ctx->ring.size)
+    {
+        cx_init_risc(dev_ctx);
+        cx_init_cmds(dev_ctx);
+    }
+
+    WdfWaitLockRelease(dev_ctx->capture_lock);
+    WdfIoQueueStart(dev_ctx->read_queue);
+    return status;
+}
+
+// allocate the ring at ring_alloc_size and build its program, if that has not been done yet
+// called with capture_lock held before anything starts a capture into the ring or maps it
+NTSTATUS cx_ensure_ring(
+    _Inout_ PDEVICE_CONTEXT dev_ctx
+)
+{
+    NTSTATUS status = STATUS_SUCCESS;
+
+    // in use again, a release that is due keeps it
+    dev_ctx->state.release_time = 0;
+
+    if (dev_ctx->ring.size)
+    {
+        return status;
+    }
+
+    LONG64 start_time = KeQueryPerformanceCounter(NULL).QuadPart;
+
+    status = cx_alloc_ring(dev_ctx, dev_ctx->ring_alloc_size);
+
+    if (!NT_SUCCESS(status))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "cx_alloc_ring (%u kbytes) failed with status %!STATUS!",
+            dev_ctx->ring_alloc_size / 1024, status);
+        return status;
+    }
+
+    // the sram is only reachable while the hardware is mapped, d0 entry loads it otherwise
+    cx_init_risc(dev_ctx);
+
+    if (dev_ctx->mmio)
+    {
+        cx_init_cmds(dev_ctx);
+    }
+
+    LONG64 alloc_time = KeQueryPerformanceCounter(NULL).QuadPart - start_time;
+
+    InterlockedIncrement64(&dev_ctx->stats.ring_allocs);
+    InterlockedExchange64(&dev_ctx->stats.ring_alloc_time, alloc_time);
+
+    TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "allocated %u kbyte ring in %lld ticks",
+        dev_ctx->ring.size / 1024, alloc_time);
+
+    return status;
+}
+
+// free the kernel ring if nothing uses it, the stopped capture in it is lost to readers
+// called with capture_lock held
+VOID cx_release_ring(
+    _Inout_ PDEVICE_CONTEXT dev_ctx
+)
+{
+    dev_ctx->state.release_time = 0;
+
+    if (!dev_ctx->ring.size || dev_ctx->user_sg || dev_ctx->state.capture.is_capturing || dev_ctx->ring_map_count)
+    {
+        return;
+    }
+
+    TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "releasing %u kbyte ring", dev_ctx->ring.size / 1024);
+
+    // reads serviced inline or by the work item copy out of the ring under read_lock
+    WdfWaitLockAcquire(dev_ctx->read_lock, NULL);
+
+    InterlockedIncrement(&dev_ctx->state.capture_id);
+    InterlockedExchange64(&dev_ctx->state.write_pos, 0);
+
+    cx_free_ring(dev_ctx);
+
+    WdfWaitLockRelease(dev_ctx->read_lock);
+}
+
+VOID cx_evt_release_timer(
+    _In_ WDFTIMER timer
+)
+{
+    PDEVICE_CONTEXT dev_ctx = cx_device_get_ctx(WdfTimerGetParentObject(timer));
+
+    WdfWaitLockAcquire(dev_ctx->capture_lock, NULL);
+
+    // the ring was used since the timer was armed
+    if (dev_ctx->state.release_time)
+    {
+        // a tick that was already running when a capture came & went again is early for the new wait
+        LONG64 left = dev_ctx->state.release_time + WDF_ABS_TIMEOUT_IN_MS(dev_ctx->attrs.ring_release) - (LONG64)KeQueryInterruptTime();
+
+        if (left > 0)
+        {
+            WdfTimerStart(dev_ctx->release_timer, -left);
+        }
+        else
+        {
+            cx_release_ring(dev_ctx);
+        }
+    }
+
+    WdfWaitLockRelease(dev_ctx->capture_lock);
+}
+
+// point the risc program at the pages of the client's buffer and start capturing into it
+// the request stays pending on user_ring_queue while attached, its locked mdl keeps the pages resident
+VOID cx_attach_user_ring(
+    _Inout_ PDEVICE_CONTEXT dev_ctx,
+    _In_ WDFREQUEST req
+)
+{
+    NTSTATUS status = STATUS_SUCCESS;
+    PMDL mdl = NULL;
+    CX_RING ring;
+
+    status = WdfRequestRetrieveOutputWdmMdl(req, &mdl);
+
+    if (!NT_SUCCESS(status))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "WdfRequestRetrieveOutputWdmMdl failed with status %!STATUS!", status);
+        WdfRequestComplete(req, status);
+        return;
+    }
+
+    ULONG ring_size = MmGetMdlByteCount(mdl);
+
+    if (MmGetMdlByteOffset(mdl) || !cx_valid_ring_size(ring_size) || !cx_ring_init(&ring, ring_size, PAGE_SIZE))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid user ring %p (%u bytes)", MmGetMdlVirtualAddress(mdl), ring_size);
+        WdfRequestComplete(req, STATUS_INVALID_PARAMETER);
+        return;
+    }
+
+    // worst case every page is its own segment
+    ULONG page_count = ring_size / PAGE_SIZE;
+    PCX_SG_ENTRY sg = (PCX_SG_ENTRY)ExAllocatePoolZero(NonPagedPoolNx, page_count * sizeof(CX_SG_ENTRY), CX_POOL_TAG);
+
+    if (!sg)
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "ExAllocatePoolZero failed");
+        WdfRequestComplete(req, STATUS_INSUFFICIENT_RESOURCES);
+        return;
+    }
+
+    // the engine is given the logical addresses the adapter maps the pages at
+    PSCATTER_GATHER_LIST sg_list = NULL;
+    ULONG sg_count = 0;
+
+    status = cx_get_user_sg_list(dev_ctx, mdl, ring_size, &sg_list);
+
+    if (!NT_SUCCESS(status))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "cx_get_user_sg_list failed with status %!STATUS!", status);
+        ExFreePoolWithTag(sg, CX_POOL_TAG);
+        WdfRequestComplete(req, status);
+        return;
+    }
+
+    for (ULONG i = 0; i < sg_list->NumberOfElements && NT_SUCCESS(status); i++)
+    {
+        if (!cx_risc_sg_add(sg, &sg_count, sg_list->Elements[i].Address.QuadPart, sg_list->Elements[i].Length))
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "user ring element %u at %llx (%u bytes) is not usable",
+                i, sg_list->Elements[i].Address.QuadPart, sg_list->Elements[i].Length);
+            status = STATUS_INSUFFICIENT_RESOURCES;
+        }
+    }
+
+    // data in a bounce buffer would only reach the client's pages at detach
+    if (NT_SUCCESS(status) && cx_risc_sg_bounced(sg, sg_count, MmGetMdlPfnArray(mdl), page_count))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "user ring has pages above 4 GB and dma is not remapped");
+        status = STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    RISC_PROG_DATA risc_prog = { 0 };
+
+    if (NT_SUCCESS(status))
+    {
+        status = cx_alloc_risc_prog(dev_ctx, ring_size, &risc_prog);
+
+        if (!NT_SUCCESS(status))
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "cx_alloc_risc_prog failed with status %!STATUS!", status);
+        }
+    }
+
+    if (!NT_SUCCESS(status))
+    {
+        cx_put_user_sg_list(dev_ctx, sg_list);
+        ExFreePoolWithTag(sg, CX_POOL_TAG);
+        WdfRequestComplete(req, status);
+        return;
+    }
+
+    // no read can start a capture or touch the ring while it is replaced, nor can the release timer free it
+    // the kernel ring need not be allocated, it is set aside as it is
+    WdfIoQueueStopSynchronously(dev_ctx->read_queue);
+    WdfWorkItemFlush(dev_ctx->read_work_item);
+    WdfWaitLockAcquire(dev_ctx->capture_lock, NULL);
+
+    // a mapping of the kernel ring would be left showing the wrong ring
+    if (dev_ctx->user_sg || dev_ctx->state.capture.is_capturing || dev_ctx->ring_map_count)
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "device in use, cannot attach user ring (capturing %d, attached %d, mapped %d)",
+            dev_ctx->state.capture.is_capturing, dev_ctx->user_sg != NULL, dev_ctx->ring_map_count);
+
+        WdfWaitLockRelease(dev_ctx->capture_lock);
+        WdfIoQueueStart(dev_ctx->read_queue);
+        cx_free_risc_prog(&risc_prog);
+        cx_put_user_sg_list(dev_ctx, sg_list);
+        ExFreePoolWithTag(sg, CX_POOL_TAG);
+        WdfRequestComplete(req, STATUS_DEVICE_BUSY);
+        return;
+    }
+
+    dev_ctx->kernel_ring = dev_ctx->ring;
+    dev_ctx->kernel_risc_prog = dev_ctx->risc_prog;
+    dev_ctx->ring = ring;
+    dev_ctx->risc_prog = risc_prog;
+    dev_ctx->user_sg = sg;
+    dev_ctx->user_sg_count = sg_count;
+    dev_ctx->user_sg_list = sg_list;
+
+    dev_ctx->ring_hdr->ring_size = dev_ctx->ring.size;
+    dev_ctx->ring_hdr->gp_size = dev_ctx->ring.gp_size;
+
+    cx_init_risc(dev_ctx);
+    cx_init_cmds(dev_ctx);
+
+    TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "attached %u kbyte user ring in %u segments",
+        ring_size / 1024, sg_count);
+
+    // the capture runs for as long as the ring is attached
+    cx_start_capture(dev_ctx);
+    WdfWaitLockRelease(dev_ctx->capture_lock);
+    WdfIoQueueStart(dev_ctx->read_queue);
+
+    status = WdfRequestForwardToIoQueue(req, dev_ctx->user_ring_queue);
+
+    if (!NT_SUCCESS(status))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "WdfRequestForwardToIoQueue failed with status %!STATUS!", status);
+        cx_detach_user_ring(dev_ctx);
+        WdfRequestComplete(req, status);
+    }
+}
+
+// stop capturing into the client's buffer and put the kernel ring back
+// must run before the attach request completes and its pages are unlocked
+VOID cx_detach_user_ring(
+    _Inout_ PDEVICE_CONTEXT dev_ctx
+)
+{
+    if (!dev_ctx->user_sg)
+    {
+        return;
+    }
+
+    WdfIoQueueStopSynchronously(dev_ctx->read_queue);
+    WdfWaitLockAcquire(dev_ctx->capture_lock, NULL);
+
+    // already stopped if the device left D0
+    if (dev_ctx->state.capture.is_capturing)
+    {
+        cx_stop_capture(dev_ctx);
+    }
+
+    // nothing may still be using the client ring's geometry
+    KeFlushQueuedDpcs();
+    WdfWorkItemFlush(dev_ctx->read_work_item);
+
+    cx_free_risc_prog(&dev_ctx->risc_prog);
+    cx_put_user_sg_list(dev_ctx, dev_ctx->user_sg_list);
+    ExFreePoolWithTag(dev_ctx->user_sg, CX_POOL_TAG);
+
+    // the last capture stays in the client's buffer
+    InterlockedIncrement(&dev_ctx->state.capture_id);
+    InterlockedExchange64(&dev_ctx->state.write_pos, 0);
+
+    dev_ctx->ring = dev_ctx->kernel_ring;
+    dev_ctx->risc_prog = dev_ctx->kernel_risc_prog;
+    dev_ctx->kernel_ring = (CX_RING){ 0 };
+    dev_ctx->kernel_risc_prog = (RISC_PROG_DATA){ 0 };
+    dev_ctx->user_sg = NULL;
+    dev_ctx->user_sg_count = 0;
+    dev_ctx->user_sg_list = NULL;
+
+    dev_ctx->ring_hdr->ring_size = dev_ctx->ring.size;
+    dev_ctx->ring_hdr->gp_size = dev_ctx->ring.gp_size;
+
+    // the sram is only reachable while the hardware is mapped, d0 entry reloads it otherwise
+    // a kernel ring that was never allocated gets its program from cx_ensure_ring
+    if (dev_ctx->ring.size)
+    {
+        cx_init_risc(dev_ctx);
+
+        if (dev_ctx->mmio)
+        {
+            cx_init_cmds(dev_ctx);
+        }
+    }
+
+    TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "detached user ring");
+
+    WdfWaitLockRelease(dev_ctx->capture_lock);
+    WdfIoQueueStart(dev_ctx->read_queue);
+}
+
+typedef struct _CX_SG_LIST_WAIT
+{
+    KEVENT event;
+    PSCATTER_GATHER_LIST sg_list;
+} CX_SG_LIST_WAIT, *PCX_SG_LIST_WAIT;
+
+// map the locked pages of a client ring for the device to write, the list is held until cx_put_user_sg_list
+// the adapter may run out of map registers for a large ring without dma remapping
+NTSTATUS cx_get_user_sg_list(
+    _In_ PDEVICE_CONTEXT dev_ctx,
+    _In_ PMDL mdl,
+    _In_ ULONG len,
+    _Out_ PSCATTER_GATHER_LIST* sg_list
+)
+{
+    PDMA_ADAPTER adapter = WdfDmaEnablerWdmGetDmaAdapter(dev_ctx->user_dma_enabler, WdfDmaDirectionReadFromDevice);
+    CX_SG_LIST_WAIT wait = { .sg_list = NULL };
+    KIRQL irql;
+
+    *sg_list = NULL;
+    KeInitializeEvent(&wait.event, NotificationEvent, FALSE);
+
+    KeRaiseIrql(DISPATCH_LEVEL, &irql);
+
+    NTSTATUS status = adapter->DmaOperations->GetScatterGatherList(adapter,
+        WdfDeviceWdmGetDeviceObject(dev_ctx->dev),
+        mdl,
+        MmGetMdlVirtualAddress(mdl),
+        len,
+        cx_user_sg_list_ready,
+        &wait,
+        FALSE);
+
+    KeLowerIrql(irql);
+
+    if (!NT_SUCCESS(status))
+    {
+        return status;
+    }
+
+    // called back once map registers are free, which may be right away
+    KeWaitForSingleObject(&wait.event, Executive, KernelMode, FALSE, NULL);
+
+    *sg_list = wait.sg_list;
+    return status;
+}
+
+VOID cx_user_sg_list_ready(
+    _In_ PDEVICE_OBJECT dev_obj,
+    _In_ PIRP irp,
+    _In_ PSCATTER_GATHER_LIST sg_list,
+    _In_ PVOID ctx
+)
+{
+    PCX_SG_LIST_WAIT wait = (PCX_SG_LIST_WAIT)ctx;
+
+    UNREFERENCED_PARAMETER(dev_obj);
+    UNREFERENCED_PARAMETER(irp);
+
+    wait->sg_list = sg_list;
+    KeSetEvent(&wait->event, IO_NO_INCREMENT, FALSE);
+}
+
+// give back a list from cx_get_user_sg_list, the device must no longer write to it
+VOID cx_put_user_sg_list(
+    _In_ PDEVICE_CONTEXT dev_ctx,
+    _In_ PSCATTER_GATHER_LIST sg_list
+)
+{
+    PDMA_ADAPTER adapter = WdfDmaEnablerWdmGetDmaAdapter(dev_ctx->user_dma_enabler, WdfDmaDirectionReadFromDevice);
+    KIRQL irql;
+
+    KeRaiseIrql(DISPATCH_LEVEL, &irql);
+    adapter->DmaOperations->PutScatterGatherList(adapter, sg_list, FALSE);
+    KeLowerIrql(irql);
+}
+
+// detach the ring attached through file_obj and complete its request with status
+NTSTATUS cx_release_user_ring(
+    _Inout_ PDEVICE_CONTEXT dev_ctx,
+    _In_ WDFFILEOBJECT file_obj,
+    _In_ NTSTATUS status
+)
+{
+    WDFREQUEST ring_req;
+
+    // once retrieved the request can no longer be canceled on the queue
+    NTSTATUS retrieve_status = WdfIoQueueRetrieveRequestByFileObject(dev_ctx->user_ring_queue, file_obj, &ring_req);
+
+    if (!NT_SUCCESS(retrieve_status))
+    {
+        return STATUS_INVALID_DEVICE_STATE;
+    }
+
+    cx_detach_user_ring(dev_ctx);
+    WdfRequestComplete(ring_req, status);
+
+    return STATUS_SUCCESS;
+}
+
+VOID cx_evt_user_ring_canceled(
+    _In_ WDFQUEUE queue,
+    _In_ WDFREQUEST req
+)
+{
+    PDEVICE_CONTEXT dev_ctx = cx_device_get_ctx(WdfIoQueueGetDevice(queue));
+
+    cx_detach_user_ring(dev_ctx);
+    WdfRequestComplete(req, STATUS_CANCELLED);
+}
+
+// the isr, dpc & read work item keep counting while these run, so each counter is cleared on its own
+// a count that lands during the reset may survive it, none is ever torn
+VOID cx_reset_stats(
+    _Inout_ PDEVICE_CONTEXT dev_ctx
+)
+{
+    PCX_STATS stats = &dev_ctx->stats;
+
+    InterlockedExchange64(&stats->bytes_produced, 0);
+    InterlockedExchange64(&stats->interrupts, 0);
+    InterlockedExchange64(&stats->unknown_interrupts, 0);
+    InterlockedExchange64(&stats->dpc_count, 0);
+    InterlockedExchange64(&stats->bytes_copied, 0);
+    InterlockedExchange64(&stats->reads_completed, 0);
+    InterlockedExchange64(&stats->read_wait_time, 0);
+    InterlockedExchange64(&stats->max_reader_lag, 0);
+    InterlockedExchange64(&stats->ring_allocs, 0);
+    InterlockedExchange64(&stats->ring_alloc_time, 0);
+}
+
+VOID cx_reset_latency(
+    _Inout_ PDEVICE_CONTEXT dev_ctx
+)
+{
+    for (ULONG i = 0; i < CX_LATENCY_STAGES; i++)
+    {
+        for (ULONG j = 0; j < CX_LATENCY_BUCKETS; j++)
+        {
+            InterlockedExchange64(&dev_ctx->latency[i].count[j], 0);
+        }
+    }
+}
+
+// start several devices together, see CX_IOCTL_SYNC_START
+// every device's capture_lock is held in dev_idx order from allocating its ring until it is started,
+// so no read, attach or ring size change on another handle gets in between
+// the devices are owned by file_ctx until it is cleaned up or sync starts again, see cx_sync_release
+NTSTATUS cx_sync_start_capture(
+    _Inout_ PFILE_CONTEXT file_ctx,
+    _In_ PCX_SYNC_START_DATA data,
+    _Out_ PCX_SYNC_START_RESULT result
+)
+{
+    NTSTATUS status = STATUS_SUCCESS;
+    PVOID devs[CX_SYNC_START_MAX_DEVICES] = { 0 };
+    ULONG lock_order[CX_SYNC_START_MAX_DEVICES];
+    ULONG found = 0;
+    CX_SYNC_OPS ops =
+    {
+        .arm = cx_sync_arm,
+        .disarm = cx_sync_disarm,
+        .begin = cx_sync_begin,
+        .run = cx_sync_run,
+        .end = cx_sync_end
+    };
+    KIRQL irql;
+
+    *result = (CX_SYNC_START_RESULT){ 0 };
+
+    if (!cx_sync_valid_list(data->dev_idx, data->count))
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "invalid sync start list (count %u)", data->count);
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    // a handle owns one sync start at a time
+    cx_sync_release(file_ctx);
+
+    for (; found < data->count; found++)
+    {
+        PDEVICE_CONTEXT dev_ctx = cx_get_device(data->dev_idx[found]);
+
+        if (!dev_ctx)
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "sync start device %u not found", data->dev_idx[found]);
+            status = STATUS_NO_SUCH_DEVICE;
+            break;
+        }
+
+        devs[found] = dev_ctx;
+    }
+
+    cx_sync_lock_order(data->dev_idx, found, lock_order);
+
+    for (ULONG i = 0; i < found; i++)
+    {
+        WdfWaitLockAcquire(((PDEVICE_CONTEXT)devs[lock_order[i]])->capture_lock, NULL);
+    }
+
+    for (ULONG i = 0; i < found && NT_SUCCESS(status); i++)
+    {
+        PDEVICE_CONTEXT dev_ctx = devs[i];
+
+        if (!dev_ctx->mmio)
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "sync start device %u not ready", data->dev_idx[i]);
+            status = STATUS_DEVICE_NOT_READY;
+            break;
+        }
+
+        // allocated here, not between the starts
+        status = cx_ensure_ring(dev_ctx);
+
+        if (!NT_SUCCESS(status))
+        {
+            TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "sync start device %u has no ring", data->dev_idx[i]);
+        }
+    }
+
+    if (NT_SUCCESS(status))
+    {
+        if (cx_sync_start(&ops, &irql, devs, data->count, result->cards))
+        {
+            result->count = data->count;
+            result->skew = cx_sync_skew(result->cards, data->count);
+        }
+        else
+        {
+            status = STATUS_DEVICE_BUSY;
+        }
+    }
+
+    for (ULONG i = 0; i < found; i++)
+    {
+        PDEVICE_CONTEXT dev_ctx = devs[i];
+
+        if (NT_SUCCESS(status))
+        {
+            result->cards[i].dev_idx = dev_ctx->dev_idx;
+            result->timestamp_freq = dev_ctx->state.timestamp_freq;
+            cx_start_poll(dev_ctx);
+            cx_update_ring_hdr(dev_ctx);
+
+            file_ctx->sync_dev_idx[i] = dev_ctx->dev_idx;
+            file_ctx->sync_capture_id[i] = dev_ctx->state.capture_id;
+
+            TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "sync started device %u at %lld gp_cnt %u",
+                dev_ctx->dev_idx, result->cards[i].timestamp, result->cards[i].gp_cnt);
+        }
+    }
+
+    if (NT_SUCCESS(status))
+    {
+        file_ctx->sync_count = data->count;
+    }
+
+    for (ULONG i = found; i--;)
+    {
+        WdfWaitLockRelease(((PDEVICE_CONTEXT)devs[lock_order[i]])->capture_lock);
+    }
+
+    for (ULONG i = 0; i < found; i++)
+    {
+        cx_put_device(devs[i]);
+    }
+
+    return status;
+}
+
+// stop the captures file_ctx sync started that are still running without a reader
+// a capture that was stopped, restarted or got a reader since is left alone
+VOID cx_sync_release(
+    _Inout_ PFILE_CONTEXT file_ctx
+)
+{
+    for (ULONG i = 0; i < file_ctx->sync_count; i++)
+    {
+        PDEVICE_CONTEXT dev_ctx = cx_get_device(file_ctx->sync_dev_idx[i]);
+
+        if (!dev_ctx)
+        {
+            continue;
+        }
+
+        WdfWaitLockAcquire(dev_ctx->capture_lock, NULL);
+
+        if (dev_ctx->state.capture.is_capturing &&
+            dev_ctx->state.capture_id == file_ctx->sync_capture_id[i] &&
+            !dev_ctx->state.capture.reader_count &&
+            !dev_ctx->state.capture.idle_time &&
+            !dev_ctx->user_sg)
+        {
+            TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "sync started device %u has no reader", dev_ctx->dev_idx);
+            cx_idle_capture(dev_ctx);
+        }
+
+        WdfWaitLockRelease(dev_ctx->capture_lock);
+        cx_put_device(dev_ctx);
+    }
+
+    file_ctx->sync_count = 0;
+}
+
+// run a validated register program, see CX_IOCTL_REGISTER_PROGRAM
+NTSTATUS cx_run_reg_program(
+    _Inout_ PDEVICE_CONTEXT dev_ctx,
+    _In_ PCX_REG_PROGRAM prog,
+    _In_ size_t prog_len,
+    _Out_ PCX_REG_PROGRAM_RESULT result
+)
+{
+    CX_REG_PROGRAM_OPS ops =
+    {
+        .read = cx_reg_program_read,
+        .write = cx_reg_program_write,
+        .wait = cx_reg_program_wait
+    };
+
+    // in & out share the system buffer
+    PCX_REG_PROGRAM copy = (PCX_REG_PROGRAM)ExAllocatePoolZero(NonPagedPoolNx, prog_len, CX_POOL_TAG);
+
+    if (!copy)
+    {
+        TraceEvents(TRACE_LEVEL_ERROR, DBG_GENERAL, "ExAllocatePoolZero failed");
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    RtlCopyMemory(copy, prog, prog_len);
+
+    cx_reg_program_run(&ops, dev_ctx, copy, result);
+
+    TraceEvents(TRACE_LEVEL_INFORMATION, DBG_GENERAL, "register program ran %u of %u ops", result->done, copy->count);
+
+    ExFreePoolWithTag(copy, CX_POOL_TAG);
+    return STATUS_SUCCESS;
+}
+
+ULONG cx_reg_program_read(
+    _In_ PVOID ctx,
+    _In_ ULONG addr
+)
+{
+    return cx_read((PDEVICE_CONTEXT)ctx, addr);
+}
+
+VOID cx_reg_program_write(
+    _In_ PVOID ctx,
+    _In_ ULONG addr,
+    _In_ ULONG value
+)
+{
+    cx_write((PDEVICE_CONTEXT)ctx, addr, value);
+}
+
+// sleep when the caller can, a delay is rounded up to the system timer so the time is measured
+ULONG cx_reg_program_wait(
+    _In_ PVOID ctx,
+    _In_ ULONG us
+)
+{
+    LARGE_INTEGER freq;
+    LONG64 start = KeQueryPerformanceCounter(&freq).QuadPart;
+
+    UNREFERENCED_PARAMETER(ctx);
+
+    if (KeGetCurrentIrql() == PASSIVE_LEVEL)
+    {
+        LARGE_INTEGER interval = { .QuadPart = -(LONG64)us * 10 };
+        KeDelayExecutionThread(KernelMode, FALSE, &interval);
+    }
+    else
+    {
+        KeStallExecutionProcessor(us);
+    }
+
+    LONG64 waited = (KeQueryPerformanceCounter(NULL).QuadPart - start) * 1000000 / freq.QuadPart;
+
+    return (ULONG)max(waited, (LONG64)us);
+}
+
+BOOLEAN cx_sync_arm(
+    _In_ PVOID ctx,
+    _In_ PVOID dev
+)
+{
+    UNREFERENCED_PARAMETER(ctx);
+    return cx_arm_capture((PDEVICE_CONTEXT)dev);
+}
+
+VOID cx_sync_disarm(
+    _In_ PVOID ctx,
+    _In_ PVOID dev
+)
+{
+    UNREFERENCED_PARAMETER(ctx);
+    cx_disarm_capture((PDEVICE_CONTEXT)dev);
+}
+
+// no interrupts or preemption on this cpu between the starts
+VOID cx_sync_begin(
+    _In_ PVOID ctx
+)
+{
+    KeRaiseIrql(HIGH_LEVEL, (PKIRQL)ctx);
+}
+
+VOID cx_sync_run(
+    _In_ PVOID ctx,
+    _In_ PVOID dev,
+    _Out_ PLONG64 timestamp,
+    _Out_ PULONG gp_cnt
+)
+{
+    PDEVICE_CONTEXT dev_ctx = (PDEVICE_CONTEXT)dev;
+
+    UNREFERENCED_PARAMETER(ctx);
 
-    WdfRequestCompleteWithInformation(req, status, req_len - count);
+    cx_run_capture(dev_ctx);
+    *timestamp = dev_ctx->state.start_timestamp;
+    *gp_cnt = dev_ctx->state.start_gp_cnt;
 }
 
-__inline
-ULONG cx_get_page_no(
-    _In_ ULONG initial_page,
-    _In_ size_t off
+VOID cx_sync_end(
+    _In_ PVOID ctx
 )
 {
-    return (((off % CX_VBI_BUF_SIZE) / PAGE_SIZE) + initial_page) % CX_VBI_BUF_COUNT;
+    KeLowerIrql(*(PKIRQL)ctx);
 }
@@ -18,11 +18,102 @@
 EVT_WDF_DEVICE_FILE_CREATE cx_evt_file_create;
 EVT_WDF_FILE_CLOSE cx_evt_file_close;
 EVT_WDF_FILE_CLEANUP cx_evt_file_cleanup;
+EVT_WDF_TIMER cx_evt_idle_timer;
+VOID cx_idle_capture(_Inout_ PDEVICE_CONTEXT dev_ctx);
+VOID cx_apply_capture_action(_Inout_ PDEVICE_CONTEXT dev_ctx, _In_ CX_CAPTURE_ACTION action, _In_ LONG64 left);
+EVT_WDF_TIMER cx_evt_release_timer;
 
+EVT_WDF_IO_IN_CALLER_CONTEXT cx_evt_io_in_caller_context;
+VOID cx_map_ctrl(_Inout_ PDEVICE_CONTEXT dev_ctx, _In_ WDFREQUEST req, _In_ size_t out_len, _In_ ULONG ctrl_code);
 VOID cx_evt_io_ctrl(_In_ WDFQUEUE queue, _In_ WDFREQUEST req, _In_ size_t out_len, _In_ size_t in_len, _In_ ULONG ctrl_code);
 VOID cx_evt_io_read(_In_ WDFQUEUE queue, _In_ WDFREQUEST req, _In_ size_t len);
 
-__inline ULONG cx_get_page_no(_In_ ULONG initial_page, _In_ size_t off);
+EVT_WDF_WORKITEM cx_evt_read_work;
+BOOLEAN cx_read_ready(_In_ PDEVICE_CONTEXT dev_ctx, _In_ WDFREQUEST req, _Out_ PLONG64 wake_pos);
+VOID cx_service_read(_In_ PDEVICE_CONTEXT dev_ctx, _In_ WDFREQUEST req);
+VOID cx_complete_read(_In_ PDEVICE_CONTEXT dev_ctx, _Inout_ PFILE_CONTEXT file_ctx, _In_ WDFREQUEST req, _In_ NTSTATUS status);
+LONG64 cx_read_space(_In_ PFILE_CONTEXT file_ctx, _In_ LONG64 req_len, _In_ LONG64 done);
+LONG64 cx_read_out_len(_In_ PFILE_CONTEXT file_ctx, _In_ LONG64 len);
+NTSTATUS cx_copy_frame_header(
+    _In_ PDEVICE_CONTEXT dev_ctx,
+    _Inout_ PFILE_CONTEXT file_ctx,
+    _In_ WDFMEMORY mem,
+    _In_ size_t tgt_off,
+    _In_ LONG64 pos,
+    _Inout_ PLONG64 len
+);
+NTSTATUS cx_copy_from_ring(
+    _In_ PDEVICE_CONTEXT dev_ctx,
+    _In_ WDFMEMORY mem,
+    _In_ size_t tgt_off,
+    _In_ LONG64 pos,
+    _In_ LONG64 len
+);
+NTSTATUS cx_pack_from_ring(
+    _In_ PDEVICE_CONTEXT dev_ctx,
+    _In_ WDFMEMORY mem,
+    _In_ size_t tgt_off,
+    _In_ LONG64 pos,
+    _In_ LONG64 len
+);
+BOOLEAN cx_copy_span(_In_ PVOID ctx, _In_ ULONG chunk_idx, _In_ ULONG chunk_off, _In_ ULONG span, _In_ LONG64 done);
+BOOLEAN cx_pack_span(_In_ PVOID ctx, _In_ ULONG chunk_idx, _In_ ULONG chunk_off, _In_ ULONG span, _In_ LONG64 done);
+
+NTSTATUS cx_mmap_ring(_Inout_ PDEVICE_CONTEXT dev_ctx, _Inout_ PFILE_CONTEXT file_ctx);
+VOID cx_munmap_ring(_Inout_ PDEVICE_CONTEXT dev_ctx, _Inout_ PFILE_CONTEXT file_ctx);
+VOID cx_set_read_position(
+    _In_ PDEVICE_CONTEXT dev_ctx,
+    _Inout_ PFILE_CONTEXT file_ctx,
+    _In_ ULONG origin,
+    _In_ LONG64 offset,
+    _Out_ PCX_READ_POSITION_RESULT result
+);
+BOOLEAN cx_history_lost(_In_ PDEVICE_CONTEXT dev_ctx, _In_ PFILE_CONTEXT file_ctx);
+VOID cx_get_available(_In_ PDEVICE_CONTEXT dev_ctx, _In_ PFILE_CONTEXT file_ctx, _Out_ PCX_AVAILABLE available);
+VOID cx_update_reader_lag(_Inout_ PDEVICE_CONTEXT dev_ctx, _Inout_ PFILE_CONTEXT file_ctx, _In_ LONG64 lag);
+NTSTATUS cx_set_ring_size(_Inout_ PDEVICE_CONTEXT dev_ctx, _In_ ULONG ring_size);
+NTSTATUS cx_ensure_ring(_Inout_ PDEVICE_CONTEXT dev_ctx);
+VOID cx_release_ring(_Inout_ PDEVICE_CONTEXT dev_ctx);
+VOID cx_attach_user_ring(_Inout_ PDEVICE_CONTEXT dev_ctx, _In_ WDFREQUEST req);
+VOID cx_detach_user_ring(_Inout_ PDEVICE_CONTEXT dev_ctx);
+NTSTATUS cx_get_user_sg_list(_In_ PDEVICE_CONTEXT dev_ctx, _In_ PMDL mdl, _In_ ULONG len, _Out_ PSCATTER_GATHER_LIST* sg_list);
+DRIVER_LIST_CONTROL cx_user_sg_list_ready;
+VOID cx_put_user_sg_list(_In_ PDEVICE_CONTEXT dev_ctx, _In_ PSCATTER_GATHER_LIST sg_list);
+NTSTATUS cx_release_user_ring(_Inout_ PDEVICE_CONTEXT dev_ctx, _In_ WDFFILEOBJECT file_obj, _In_ NTSTATUS status);
+EVT_WDF_IO_QUEUE_IO_CANCELED_ON_QUEUE cx_evt_user_ring_canceled;
+NTSTATUS cx_set_config(_Inout_ PDEVICE_CONTEXT dev_ctx, _In_ PCX_CONFIG config);
+VOID cx_set_keep_alive(_Inout_ PDEVICE_CONTEXT dev_ctx, _In_ ULONG keep_alive);
+VOID cx_set_ring_release(_Inout_ PDEVICE_CONTEXT dev_ctx, _In_ ULONG ring_release);
+VOID cx_reset_stats(_Inout_ PDEVICE_CONTEXT dev_ctx);
+VOID cx_reset_latency(_Inout_ PDEVICE_CONTEXT dev_ctx);
+
+NTSTATUS cx_sync_start_capture(_Inout_ PFILE_CONTEXT file_ctx, _In_ PCX_SYNC_START_DATA data, _Out_ PCX_SYNC_START_RESULT result);
+VOID cx_sync_release(_Inout_ PFILE_CONTEXT file_ctx);
+BOOLEAN cx_sync_arm(_In_ PVOID ctx, _In_ PVOID dev);
+VOID cx_sync_disarm(_In_ PVOID ctx, _In_ PVOID dev);
+VOID cx_sync_begin(_In_ PVOID ctx);
+VOID cx_sync_run(_In_ PVOID ctx, _In_ PVOID dev, _Out_ PLONG64 timestamp, _Out_ PULONG gp_cnt);
+VOID cx_sync_end(_In_ PVOID ctx);
+
+NTSTATUS cx_run_reg_program(
+    _Inout_ PDEVICE_CONTEXT dev_ctx,
+    _In_ PCX_REG_PROGRAM prog,
+    _In_ size_t prog_len,
+    _Out_ PCX_REG_PROGRAM_RESULT result
+);
+ULONG cx_reg_program_read(_In_ PVOID ctx, _In_ ULONG addr);
+VOID cx_reg_program_write(_In_ PVOID ctx, _In_ ULONG addr, _In_ ULONG value);
+ULONG cx_reg_program_wait(_In_ PVOID ctx, _In_ ULONG us);
+
+// a cx_ring_copy into a read's buffer, mem for a copy and buf for a pack
+typedef struct _RING_COPY_DATA
+{
+    PDEVICE_CONTEXT dev_ctx;
+    WDFMEMORY mem;
+    PUCHAR buf;
+    size_t tgt_off;
+    NTSTATUS status;
+} RING_COPY_DATA, *PRING_COPY_DATA;
 
 typedef struct _SET_REGISTER_DATA
 {
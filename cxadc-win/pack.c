@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#include "pack.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#include <emmintrin.h>
+#define CX_PACK10_SSE2
+#endif
+
+// samples are 16-bit little-endian with the 10 significant bits at the top,
+// a group is packed big-endian, s0 in the top 10 bits of the first byte pair, as in ld-decode .lds files
+VOID cx_pack10_scalar(
+    _Out_writes_bytes_(groups * CX_PACK10_GROUP_OUT) PUCHAR dst,
+    _In_reads_bytes_(groups * CX_PACK10_GROUP_IN) const UCHAR* src,
+    _In_ size_t groups
+)
+{
+    for (size_t i = 0; i < groups; i++)
+    {
+        ULONG64 v = 0;
+
+        for (ULONG j = 0; j < 4; j++)
+        {
+            USHORT s = (USHORT)(src[j * 2] | (src[j * 2 + 1] << 8));
+            v = (v << 10) | (s >> 6);
+        }
+
+        dst[0] = (UCHAR)(v >> 32);
+        dst[1] = (UCHAR)(v >> 24);
+        dst[2] = (UCHAR)(v >> 16);
+        dst[3] = (UCHAR)(v >> 8);
+        dst[4] = (UCHAR)v;
+
+        src += CX_PACK10_GROUP_IN;
+        dst += CX_PACK10_GROUP_OUT;
+    }
+}
+
+VOID cx_pack10(
+    _Out_writes_bytes_(groups * CX_PACK10_GROUP_OUT) PUCHAR dst,
+    _In_reads_bytes_(groups * CX_PACK10_GROUP_IN) const UCHAR* src,
+    _In_ size_t groups
+)
+{
+#ifdef CX_PACK10_SSE2
+    const __m128i pair_mul = _mm_set1_epi32(0x00010400); // s0 * 1024 + s1
+    const __m128i lo_mask = _mm_set_epi32(0, -1, 0, -1);
+
+    // 2 groups per step, each 8-byte store writes 3 bytes past its group that the next step overwrites,
+    // so stop while a group is left for the scalar tail
+    while (groups >= 3)
+    {
+        __m128i x = _mm_srli_epi16(_mm_loadu_si128((const __m128i*)src), 6);
+
+        // 20 bits per 32-bit lane, (s0 << 10) | s1 and (s2 << 10) | s3
+        x = _mm_madd_epi16(x, pair_mul);
+
+        // 40 bits per 64-bit lane, shifted to the top
+        x = _mm_or_si128(_mm_slli_epi64(_mm_and_si128(x, lo_mask), 20), _mm_srli_epi64(x, 32));
+        x = _mm_slli_epi64(x, 24);
+
+        // byte swap each 64-bit lane, the group is then in its low 5 bytes
+        x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+        x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(0, 1, 2, 3));
+        x = _mm_shufflehi_epi16(x, _MM_SHUFFLE(0, 1, 2, 3));
+
+        _mm_storel_epi64((__m128i*)dst, x);
+        _mm_storel_epi64((__m128i*)(dst + CX_PACK10_GROUP_OUT), _mm_srli_si128(x, 8));
+
+        src += CX_PACK10_GROUP_IN * 2;
+        dst += CX_PACK10_GROUP_OUT * 2;
+        groups -= 2;
+    }
+#endif
+
+    cx_pack10_scalar(dst, src, groups);
+}
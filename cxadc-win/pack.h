@@ -0,0 +1,25 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#pragma once
+
+#include "portable.h"
+
+// 10-bit packing for CX_READ_FORMAT_PACKED10
+
+// a group is 4 raw16 samples in the ring and 5 packed bytes in the output
+#define CX_PACK10_GROUP_IN      8
+#define CX_PACK10_GROUP_OUT     5
+
+VOID cx_pack10(_Out_writes_bytes_(groups * CX_PACK10_GROUP_OUT) PUCHAR dst, _In_reads_bytes_(groups * CX_PACK10_GROUP_IN) const UCHAR* src, _In_ size_t groups);
+VOID cx_pack10_scalar(_Out_writes_bytes_(groups * CX_PACK10_GROUP_OUT) PUCHAR dst, _In_reads_bytes_(groups * CX_PACK10_GROUP_IN) const UCHAR* src, _In_ size_t groups);
@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#pragma once
+
+// types for the modules that make no kernel/WDF calls
+// ring, sched, frame, event, hist, pack, fifo, regprog, risc, sync & capture include this instead of precomp.h,
+// so they build in the driver from the kernel headers and anywhere else from the C runtime,
+// see cxadc-win-test
+
+#if defined(_KERNEL_MODE)
+
+#include <ntddk.h>
+
+#elif defined(_WIN32)
+
+#include <windows.h>
+
+#else
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef void VOID, *PVOID;
+typedef uint8_t UCHAR, *PUCHAR;
+typedef uint8_t BOOLEAN, *PBOOLEAN;
+typedef uint16_t USHORT, *PUSHORT;
+typedef int32_t LONG, *PLONG;
+typedef uint32_t ULONG, *PULONG;
+typedef int64_t LONG64, *PLONG64;
+typedef uint64_t ULONG64, *PULONG64;
+
+typedef struct _GUID
+{
+    ULONG data1;
+    USHORT data2;
+    USHORT data3;
+    UCHAR data4[8];
+} GUID;
+
+#define TRUE                            1
+#define FALSE                           0
+
+#define FIELD_OFFSET(type, field)       ((LONG)offsetof(type, field))
+#define DEFINE_GUID(name, l, w1, w2, b1, b2, b3, b4, b5, b6, b7, b8) extern const GUID name
+
+#define min(a, b)                       (((a) < (b)) ? (a) : (b))
+#define max(a, b)                       (((a) > (b)) ? (a) : (b))
+
+#define InterlockedExchange(target, value) __atomic_exchange_n((target), (value), __ATOMIC_SEQ_CST)
+#define InterlockedIncrement(addend)    __atomic_add_fetch((addend), 1, __ATOMIC_SEQ_CST)
+#define InterlockedDecrement(addend)    __atomic_sub_fetch((addend), 1, __ATOMIC_SEQ_CST)
+#define InterlockedExchange64(target, value) __atomic_exchange_n((target), (value), __ATOMIC_SEQ_CST)
+#define InterlockedIncrement64(addend)  __atomic_add_fetch((addend), 1, __ATOMIC_SEQ_CST)
+#define InterlockedAdd64(addend, value) __atomic_add_fetch((addend), (value), __ATOMIC_SEQ_CST)
+
+static inline LONG InterlockedCompareExchange(volatile LONG* dest, LONG exchange, LONG comparand)
+{
+    __atomic_compare_exchange_n(dest, &comparand, exchange, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return comparand;
+}
+
+static inline LONG64 InterlockedCompareExchange64(volatile LONG64* dest, LONG64 exchange, LONG64 comparand)
+{
+    __atomic_compare_exchange_n(dest, &comparand, exchange, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return comparand;
+}
+
+// annotations are only checked by the msvc analyzer
+#define _In_
+#define _In_opt_
+#define _Out_
+#define _Inout_
+#define _In_reads_(n)
+#define _In_reads_bytes_(n)
+#define _Out_writes_(n)
+#define _Out_writes_bytes_(n)
+#define _Inout_updates_(n)
+
+#endif
+
+// user mode has no PAGE_SIZE, the driver only runs with 4 KB pages
+#ifndef PAGE_SIZE
+#define PAGE_SIZE                       0x1000
+#endif
+
+#ifndef PAGE_SHIFT
+#define PAGE_SHIFT                      12
+#endif
+
+#include "public.h"
@@ -22,6 +22,33 @@ DEFINE_GUID(GUID_DEVINTERFACE_CXADCWIN,
 #define CX_IOCTL_GET_OUFLOW_COUNT \
     CTL_CODE(FILE_DEVICE_UNKNOWN, 0x810, METHOD_BUFFERED, FILE_READ_DATA)
 
+#define CX_IOCTL_GET_READER_STATS \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x811, METHOD_BUFFERED, FILE_READ_DATA)
+
+#define CX_IOCTL_GET_OVERRUN_POLICY \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x812, METHOD_BUFFERED, FILE_READ_DATA)
+
+#define CX_IOCTL_GET_READ_MODE \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x813, METHOD_BUFFERED, FILE_READ_DATA)
+
+#define CX_IOCTL_GET_STATS \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x814, METHOD_BUFFERED, FILE_READ_DATA)
+
+#define CX_IOCTL_GET_LATENCY \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x815, METHOD_BUFFERED, FILE_READ_DATA)
+
+#define CX_IOCTL_GET_READ_FORMAT \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x816, METHOD_BUFFERED, FILE_READ_DATA)
+
+#define CX_IOCTL_GET_EVENTS \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x817, METHOD_BUFFERED, FILE_READ_DATA)
+
+#define CX_IOCTL_GET_WAIT_POLICY \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x818, METHOD_BUFFERED, FILE_READ_DATA)
+
+#define CX_IOCTL_GET_AVAILABLE \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x819, METHOD_BUFFERED, FILE_READ_DATA)
+
 #define CX_IOCTL_GET_CRYSTAL \
     CTL_CODE(FILE_DEVICE_UNKNOWN, 0x820, METHOD_BUFFERED, FILE_READ_DATA)
 
@@ -40,18 +67,63 @@ DEFINE_GUID(GUID_DEVINTERFACE_CXADCWIN,
 #define CX_IOCTL_GET_CENTER_OFFSET \
     CTL_CODE(FILE_DEVICE_UNKNOWN, 0x825, METHOD_BUFFERED, FILE_READ_DATA)
 
+#define CX_IOCTL_GET_IRQ_PERIOD \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x826, METHOD_BUFFERED, FILE_READ_DATA)
+
+#define CX_IOCTL_GET_CONFIG \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x827, METHOD_BUFFERED, FILE_READ_DATA)
+
+#define CX_IOCTL_GET_POLL_RATE \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x828, METHOD_BUFFERED, FILE_READ_DATA)
+
+#define CX_IOCTL_GET_KEEP_ALIVE \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x829, METHOD_BUFFERED, FILE_READ_DATA)
+
 #define CX_IOCTL_GET_BUS_NUMBER \
     CTL_CODE(FILE_DEVICE_UNKNOWN, 0x830, METHOD_BUFFERED, FILE_READ_DATA)
 
 #define CX_IOCTL_GET_DEVICE_ADDRESS \
     CTL_CODE(FILE_DEVICE_UNKNOWN, 0x831, METHOD_BUFFERED, FILE_READ_DATA)
 
+#define CX_IOCTL_GET_RING_SIZE \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x840, METHOD_BUFFERED, FILE_READ_DATA)
+
+#define CX_IOCTL_GET_FIFO_GEOMETRY \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x841, METHOD_BUFFERED, FILE_READ_DATA)
+
+#define CX_IOCTL_GET_RING_RELEASE \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x842, METHOD_BUFFERED, FILE_READ_DATA)
+
 #define CX_IOCTL_GET_REGISTER \
     CTL_CODE(FILE_DEVICE_UNKNOWN, 0x82F, METHOD_BUFFERED, FILE_READ_DATA)
 
 #define CX_IOCTL_RESET_OUFLOW_COUNT \
     CTL_CODE(FILE_DEVICE_UNKNOWN, 0x910, METHOD_BUFFERED, FILE_WRITE_DATA)
 
+#define CX_IOCTL_RESET_READER_STATS \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x911, METHOD_BUFFERED, FILE_WRITE_DATA)
+
+#define CX_IOCTL_SET_OVERRUN_POLICY \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x912, METHOD_BUFFERED, FILE_WRITE_DATA)
+
+#define CX_IOCTL_SET_READ_MODE \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x913, METHOD_BUFFERED, FILE_WRITE_DATA)
+
+#define CX_IOCTL_RESET_STATS \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x914, METHOD_BUFFERED, FILE_WRITE_DATA)
+
+#define CX_IOCTL_RESET_LATENCY \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x915, METHOD_BUFFERED, FILE_WRITE_DATA)
+
+#define CX_IOCTL_SET_READ_FORMAT \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x916, METHOD_BUFFERED, FILE_WRITE_DATA)
+
+#define CX_IOCTL_SET_READ_POSITION \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x917, METHOD_BUFFERED, FILE_WRITE_DATA)
+
+#define CX_IOCTL_SET_WAIT_POLICY \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x918, METHOD_BUFFERED, FILE_WRITE_DATA)
+
 #define CX_IOCTL_SET_CRYSTAL \
     CTL_CODE(FILE_DEVICE_UNKNOWN, 0x920, METHOD_BUFFERED, FILE_WRITE_DATA)
 
@@ -70,15 +142,51 @@ DEFINE_GUID(GUID_DEVINTERFACE_CXADCWIN,
 #define CX_IOCTL_SET_CENTER_OFFSET \
     CTL_CODE(FILE_DEVICE_UNKNOWN, 0x925, METHOD_BUFFERED, FILE_WRITE_DATA)
 
+#define CX_IOCTL_SET_IRQ_PERIOD \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x926, METHOD_BUFFERED, FILE_WRITE_DATA)
+
+#define CX_IOCTL_SET_CONFIG \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x927, METHOD_BUFFERED, FILE_WRITE_DATA)
+
+#define CX_IOCTL_SET_POLL_RATE \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x928, METHOD_BUFFERED, FILE_WRITE_DATA)
+
+#define CX_IOCTL_SET_KEEP_ALIVE \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x929, METHOD_BUFFERED, FILE_WRITE_DATA)
+
 #define CX_IOCTL_SET_REGISTER \
     CTL_CODE(FILE_DEVICE_UNKNOWN, 0x92F, METHOD_BUFFERED, FILE_WRITE_DATA)
 
+#define CX_IOCTL_SET_RING_SIZE \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x940, METHOD_BUFFERED, FILE_WRITE_DATA)
+
+#define CX_IOCTL_SET_RING_RELEASE \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x942, METHOD_BUFFERED, FILE_WRITE_DATA)
+
 #define CX_IOCTL_MMAP \
     CTL_CODE(FILE_DEVICE_UNKNOWN, 0xA00, METHOD_BUFFERED, FILE_READ_DATA)
 
 #define CX_IOCTL_MUNMAP \
     CTL_CODE(FILE_DEVICE_UNKNOWN, 0xA01, METHOD_BUFFERED, FILE_WRITE_DATA)
 
+#define CX_IOCTL_MMAP_RING \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0xA02, METHOD_BUFFERED, FILE_READ_DATA)
+
+#define CX_IOCTL_MUNMAP_RING \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0xA03, METHOD_BUFFERED, FILE_WRITE_DATA)
+
+#define CX_IOCTL_ATTACH_USER_RING \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0xA04, METHOD_OUT_DIRECT, FILE_READ_DATA)
+
+#define CX_IOCTL_DETACH_USER_RING \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0xA05, METHOD_BUFFERED, FILE_WRITE_DATA)
+
+#define CX_IOCTL_SYNC_START \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0xA10, METHOD_BUFFERED, FILE_READ_DATA)
+
+#define CX_IOCTL_REGISTER_PROGRAM \
+    CTL_CODE(FILE_DEVICE_UNKNOWN, 0xA20, METHOD_BUFFERED, FILE_READ_DATA | FILE_WRITE_DATA)
+
 // vmux 0-3
 #define CX_IOCTL_VMUX_DEFAULT           2
 #define CX_IOCTL_VMUX_MIN               0
@@ -103,3 +211,404 @@ DEFINE_GUID(GUID_DEVINTERFACE_CXADCWIN,
 #define CX_IOCTL_CENTER_OFFSET_DEFAULT  0
 #define CX_IOCTL_CENTER_OFFSET_MIN      0
 #define CX_IOCTL_CENTER_OFFSET_MAX      63
+
+// irq_period 64 KB - 8 MB, power of 2, applied at capture start
+#define CX_IOCTL_IRQ_PERIOD_DEFAULT     (1024 * 1024 * 2)
+#define CX_IOCTL_IRQ_PERIOD_MIN         (1024 * 64)
+#define CX_IOCTL_IRQ_PERIOD_MAX         (1024 * 1024 * 8)
+
+// poll_rate 0 or 50-10000 Hz, applied at capture start
+// 0 publishes data on the risc interrupt every irq_period bytes
+// otherwise the risc interrupts are masked and a high resolution timer samples the gp counter
+// poll_rate times a second, publishing all but the last gp unit it has reached
+// the card may be up to two ticks of data at its highest rate ahead of what was published, so a
+// reader more than ring_size less that margin behind the head is lapped, the margin is 4 MB at 50 Hz
+// (irq_period with the risc interrupt). a block is the data published by one tick, so framed reads
+// of older data may carry no block info
+#define CX_IOCTL_POLL_RATE_DEFAULT      0
+#define CX_IOCTL_POLL_RATE_MIN          50
+#define CX_IOCTL_POLL_RATE_MAX          10000
+
+// keep_alive 0-3600000 ms a capture keeps running after its last reader closes
+// 0 stops it with the last reader, otherwise a reader that opens in time joins it at the live head
+// without a restart, unless the handle set its own read position
+// setting it while a capture is being kept alive restarts the wait, 0 stops the capture now
+#define CX_IOCTL_KEEP_ALIVE_DEFAULT     0
+#define CX_IOCTL_KEEP_ALIVE_MAX         (1000 * 60 * 60)
+
+// ring_size 16 MB - 1 GB, multiple of 2 MB
+#define CX_IOCTL_RING_SIZE_DEFAULT      (1024 * 1024 * 64)
+#define CX_IOCTL_RING_SIZE_MIN          (1024 * 1024 * 16)
+#define CX_IOCTL_RING_SIZE_MAX          (1024 * 1024 * 1024)
+#define CX_IOCTL_RING_SIZE_ALIGN        (1024 * 1024 * 2)
+
+// the ring is allocated by the first capture or ring mapping, not when the device loads
+// ring_release 0-86400000 ms after a capture stops the ring is freed if nothing has used it since,
+// along with the stopped capture in it, 0 keeps it until the device unloads
+#define CX_IOCTL_RING_RELEASE_DEFAULT   0
+#define CX_IOCTL_RING_RELEASE_MAX       (1000 * 60 * 60 * 24)
+
+// on-chip fifo, returned by CX_IOCTL_GET_FIFO_GEOMETRY
+// cdt_count clusters of cdt_len bytes fill sram from buf_base to its end, the cdt describing them
+// is at cdt_base, every RISC WRITE moves one cluster
+// fixed per device at init by the FifoPreset registry value, or CdtBufLen & CdtBufCount if both are set
+// more sram rides out longer PCI stalls at high sample rates before the fifo overflows
+#define CX_FIFO_PRESET_DEFAULT          0 // 8 x 2048, 16 KB
+#define CX_FIFO_PRESET_40MHZ            1 // 12 x 2048, 24 KB
+#define CX_FIFO_PRESET_50MHZ            2 // 13 x 2048, 26 KB, all the sram there is
+
+#define CX_CDT_LEN_MIN                  256
+#define CX_CDT_LEN_MAX                  2048
+#define CX_CDT_COUNT_MIN                2
+
+typedef struct _CX_FIFO_GEOMETRY
+{
+    ULONG cdt_len;
+    ULONG cdt_count;
+    ULONG cdt_base;
+    ULONG buf_base;
+    ULONG size;             // cdt_len * cdt_count
+} CX_FIFO_GEOMETRY, *PCX_FIFO_GEOMETRY;
+
+// device configuration, returned by CX_IOCTL_GET_CONFIG and applied by CX_IOCTL_SET_CONFIG
+// SET validates every settable field before any is applied, then programs the registers in one pass
+// crystal, ring_size and the capture state & pci location after it are ignored by SET
+#define CX_CONFIG_VERSION               2
+
+typedef struct _CX_CONFIG
+{
+    ULONG version;
+    ULONG size;             // sizeof(CX_CONFIG)
+    LONG vmux;
+    LONG level;
+    LONG tenbit;
+    LONG sixdb;
+    LONG center_offset;
+    ULONG irq_period;       // applied at capture start
+    LONG crystal;
+    ULONG ring_size;
+    LONG is_capturing;
+    ULONG ouflow_count;
+    ULONG bus_number;
+    ULONG dev_addr;
+    ULONG poll_rate;        // applied at capture start, version 2
+    ULONG keep_alive;       // version 2
+    ULONG ring_release;     // version 2
+} CX_CONFIG, *PCX_CONFIG;
+
+// overrun_policy, what a read does when the capture has lapped the handle's position
+// the handle always moves forward to the oldest valid data
+// FAIL:  complete the read with STATUS_DATA_OVERRUN
+// SKIP:  continue the read from the oldest valid data
+// SHORT: return what was read before the gap, the next read continues after it
+#define CX_OVERRUN_POLICY_FAIL          0
+#define CX_OVERRUN_POLICY_SKIP          1
+#define CX_OVERRUN_POLICY_SHORT         2
+
+#define CX_IOCTL_OVERRUN_POLICY_DEFAULT CX_OVERRUN_POLICY_SKIP
+#define CX_IOCTL_OVERRUN_POLICY_MIN     CX_OVERRUN_POLICY_FAIL
+#define CX_IOCTL_OVERRUN_POLICY_MAX     CX_OVERRUN_POLICY_SHORT
+
+// wait_policy, per handle, how long a read waits for data
+// FULL: until the read is full or the capture stops
+// NONE: not at all, the read returns what is available now, 0 bytes while capturing if nothing is
+//       CX_IOCTL_GET_AVAILABLE tells how much that is, so one thread can poll several devices
+#define CX_WAIT_POLICY_FULL             0
+#define CX_WAIT_POLICY_NONE             1
+
+#define CX_IOCTL_WAIT_POLICY_DEFAULT    CX_WAIT_POLICY_FULL
+#define CX_IOCTL_WAIT_POLICY_MAX        CX_WAIT_POLICY_NONE
+
+// returned by CX_IOCTL_GET_AVAILABLE for the calling handle, all in captured bytes
+typedef struct _CX_AVAILABLE
+{
+    LONG64 bytes;           // readable now, from the handle's position or the oldest data if it was lapped
+    LONG64 lost;            // overwritten ahead of the handle's position, the next read handles the overrun
+    LONG64 read_pos;        // the handle's position
+    LONG64 write_pos;       // the live head
+    LONG is_capturing;
+    ULONG reserved;
+} CX_AVAILABLE, *PCX_AVAILABLE;
+
+// read position, CX_IOCTL_SET_READ_POSITION moves the handle's next read to offset from origin
+// START: offset bytes from the start of the capture
+// HEAD:  offset bytes back from the live head, 0 joins at the head
+// TIME:  offset milliseconds before now, located through the per-block timestamps
+// the position is clamped to the oldest data still in the ring, output is a CX_READ_POSITION_RESULT
+// or as much of it as fits, opening \\.\cxadcN\head joins at the head too
+// while idle, a HEAD or TIME position inside the last capture reads back its history without starting
+// a new capture, reads return 0 bytes once it is drained or a new capture has overwritten it
+// any other position waits for the next capture
+#define CX_READ_ORIGIN_START            0
+#define CX_READ_ORIGIN_HEAD             1
+#define CX_READ_ORIGIN_TIME             2
+
+typedef struct _CX_READ_POSITION
+{
+    ULONG origin;
+    ULONG reserved;
+    LONG64 offset;
+} CX_READ_POSITION, *PCX_READ_POSITION;
+
+typedef struct _CX_READ_POSITION_RESULT
+{
+    LONG64 pos;             // where the next read starts
+    LONG64 write_pos;       // head at the time, pos < write_pos is already in the ring
+} CX_READ_POSITION_RESULT, *PCX_READ_POSITION_RESULT;
+
+// per-handle read statistics, returned by CX_IOCTL_GET_READER_STATS
+// lag is write_pos - read position, in bytes
+typedef struct _CX_READER_STATS
+{
+    LONG64 bytes_lost;
+    LONG64 lag;
+    LONG64 peak_lag;
+    ULONG overrun_count;
+    ULONG reserved;
+    LONG64 bytes_copied;
+    LONG64 reads_completed;
+} CX_READER_STATS, *PCX_READER_STATS;
+
+// device statistics since load or CX_IOCTL_RESET_STATS, returned by CX_IOCTL_GET_STATS
+// fields are only ever appended, a smaller buffer receives the leading fields and size says how many are valid
+#define CX_STATS_VERSION                1
+
+typedef struct _CX_STATS
+{
+    ULONG version;
+    ULONG size;                 // bytes returned
+    LONG64 bytes_produced;      // bytes published to the ring
+    LONG64 interrupts;          // isr calls with an interrupt pending
+    LONG64 unknown_interrupts;  // of those, none of vbi_risci1, vbif_of, vbi_sync or opc_err
+    LONG64 dpc_count;
+    LONG64 bytes_copied;        // returned by reads, all handles
+    LONG64 reads_completed;
+    LONG64 read_wait_time;      // performance counter ticks reads spent pending, from arrival to completion
+    LONG64 max_reader_lag;      // bytes, any handle
+    LONG64 timestamp_freq;      // performance counter frequency
+    LONG64 ring_allocs;         // ring allocations, by the first capture or the first after a release
+    LONG64 ring_alloc_time;     // performance counter ticks the last one took, including the risc program
+} CX_STATS, *PCX_STATS;
+
+// latency histograms, returned by CX_IOCTL_GET_LATENCY
+// times are performance counter ticks, bucket 0 counts 0 ticks and bucket n counts [2^(n-1), 2^n) ticks,
+// the last bucket also counts everything above it
+#define CX_LATENCY_VERSION              1
+#define CX_LATENCY_BUCKETS              32
+
+#define CX_LATENCY_ISR_TO_DPC           0 // isr to dpc, from the first interrupt a dpc handles
+#define CX_LATENCY_DPC_TO_WORK          1 // dpc to the read work item that services its data
+#define CX_LATENCY_READ                 2 // read arrival to completion
+#define CX_LATENCY_SERVICE              3 // one pass of servicing a read, mostly the copy
+#define CX_LATENCY_STAGES               4
+
+typedef struct _CX_LATENCY_HIST
+{
+    LONG64 count[CX_LATENCY_BUCKETS];
+} CX_LATENCY_HIST, *PCX_LATENCY_HIST;
+
+typedef struct _CX_LATENCY
+{
+    ULONG version;
+    ULONG stage_count;
+    LONG64 timestamp_freq;
+    CX_LATENCY_HIST hist[CX_LATENCY_STAGES];
+} CX_LATENCY, *PCX_LATENCY;
+
+// error interrupts, returned by CX_IOCTL_GET_EVENTS
+// the isr records each error interrupt in a per-device ring of CX_EVENT_RING_SIZE events
+// input is the ULONG64 sequence of the first event wanted, 0 for the oldest still held
+// output is a CX_EVENTS followed by count events in sequence order, pass next_seq to continue from there
+// stream_pos is the position the engine had reached, to a gp_size unit, -1 outside a capture or before its first interrupt
+#define CX_EVENT_RING_SIZE              256
+
+#define CX_EVENT_FIFO_OVERFLOW          0x00000001 // vbif_of
+#define CX_EVENT_SYNC_ERROR             0x00000002 // vbi_sync
+#define CX_EVENT_OPCODE_ERROR           0x00000004 // opc_err
+
+typedef struct _CX_EVENT
+{
+    ULONG64 sequence;
+    ULONG cause;            // CX_EVENT_*
+    ULONG gp_cnt;           // raw CX_VIDEO_VBI_GP_COUNTER read by the isr
+    LONG64 stream_pos;
+    LONG64 timestamp;       // performance counter
+} CX_EVENT, *PCX_EVENT;
+
+typedef struct _CX_EVENTS
+{
+    ULONG64 next_seq;       // sequence after the last event returned
+    ULONG count;
+    ULONG lost;             // events before the first returned that were overwritten
+    LONG64 timestamp_freq;
+    CX_EVENT events[1];
+} CX_EVENTS, *PCX_EVENTS;
+
+// read_mode, per handle
+// RAW:        reads return sample data only
+// FRAMED:     reads return frames, a CX_FRAME_HEADER followed by data_size bytes of sample data
+// POSITIONAL: reads return sample data from the stream position in their ByteOffset (OVERLAPPED.Offset)
+//             instead of the handle's position, which they leave alone, so reads of different windows
+//             can be in flight together and a range can be read again while it is in the ring
+//             a read completes once it is full or the capture stops, a window that has left the ring
+//             fails with STATUS_DATA_OVERRUN whatever the overrun_policy, the RAW read_format only
+#define CX_READ_MODE_RAW                0
+#define CX_READ_MODE_FRAMED             1
+#define CX_READ_MODE_POSITIONAL         2
+
+#define CX_IOCTL_READ_MODE_DEFAULT      CX_READ_MODE_RAW
+#define CX_IOCTL_READ_MODE_MAX          CX_READ_MODE_POSITIONAL
+
+// read_format, per handle
+// RAW:      samples as captured
+// PACKED10: tenbit only, every 4 samples are packed into 5 bytes, the top 10 bits of each sample
+//           big-endian with the first sample in the top bits, as in ld-decode .lds files
+//           reads return whole groups and need tenbit set, the RAW read_mode only
+// lag and bytes_lost stay in captured bytes, bytes_copied counts packed bytes
+#define CX_READ_FORMAT_RAW              0
+#define CX_READ_FORMAT_PACKED10         1
+
+#define CX_IOCTL_READ_FORMAT_DEFAULT    CX_READ_FORMAT_RAW
+#define CX_IOCTL_READ_FORMAT_MAX        CX_READ_FORMAT_PACKED10
+
+// framed reads
+// a block is the data published by one interrupt, normally irq_period bytes, or one tick with poll_rate set
+// a frame holds all or part of one block, frames split across reads and blocks split across frames
+// frames of a handle are contiguous in the stream, stream_pos == previous stream_pos + data_size,
+// unless CX_FRAME_FLAG_GAP is set, in which case the data in between was lost to an overrun
+// all fields are little-endian, the header is 8-byte aligned when the read buffer is
+#define CX_FRAME_MAGIC                  0x52465843 // "CXFR"
+#define CX_FRAME_VERSION                1
+
+#define CX_FRAME_FLAG_OUFLOW            0x00000001 // fifo overflow (vbif_of) interrupt seen since the previous block was published
+#define CX_FRAME_FLAG_GAP               0x00000002 // data between the previous frame and this one was lost
+#define CX_FRAME_FLAG_NO_INFO           0x00000004 // block info was unavailable, sequence/timestamp/gp_cnt/attrs are not valid
+
+typedef struct _CX_FRAME_ATTRS
+{
+    LONG vmux;
+    LONG level;
+    LONG tenbit;
+    LONG sixdb;
+    LONG center_offset;
+    ULONG irq_period;
+} CX_FRAME_ATTRS, *PCX_FRAME_ATTRS;
+
+typedef struct _CX_FRAME_HEADER
+{
+    ULONG magic;
+    USHORT version;
+    USHORT header_size;     // sizeof(CX_FRAME_HEADER), data follows at this offset
+    ULONG data_size;        // bytes of sample data in this frame
+    ULONG flags;            // CX_FRAME_FLAG_*
+    ULONG64 sequence;       // block number since capture start
+    LONG64 block_pos;       // stream position of the first byte of the block
+    LONG64 stream_pos;      // stream position of the first byte of this frame
+    ULONG block_size;       // bytes in the block
+    ULONG gp_cnt;           // raw CX_VIDEO_VBI_GP_COUNTER read by the interrupt
+    LONG64 timestamp;       // performance counter when the interrupt published the block
+    LONG64 timestamp_freq;  // performance counter frequency
+    CX_FRAME_ATTRS attrs;   // device attrs when the block was published
+} CX_FRAME_HEADER, *PCX_FRAME_HEADER;
+
+// shared ring header, mapped read-only by CX_IOCTL_MMAP_RING along with the ring
+// while a client ring is attached only the header is mapped and ring is returned as NULL
+// write_pos is the number of bytes produced since initial_page and is updated last,
+// data in [write_pos - ring_size, write_pos) is at ring offset
+// ((initial_page * gp_size) + pos) % ring_size
+#define CX_RING_HEADER_VERSION          1
+
+typedef struct _CX_RING_HEADER
+{
+    ULONG version;
+    ULONG ring_size;
+    LONG is_capturing;
+    LONG initial_page;
+    LONG last_gp_cnt;
+    ULONG gp_size;
+    volatile LONG64 write_pos;
+} CX_RING_HEADER, *PCX_RING_HEADER;
+
+// client ring, CX_IOCTL_ATTACH_USER_RING must be sent overlapped and stays pending while attached
+// its output buffer becomes the ring: page aligned and a valid ring_size, its pages are mapped through the dma adapter
+// with dma remapping any buffer will do, without it every page must be below 4 GB as the card is a 32-bit bus master
+// the device is claimed and captures straight into the buffer, there is no copy and ReadFile fails
+// the kernel ring must not be mapped by any handle, CX_IOCTL_MUNMAP_RING first
+// the shared ring header describes the client ring, data up to write_pos is in the buffer at
+// ((initial_page * gp_size) + pos) % ring_size
+// capture stops and the request completes on CX_IOCTL_DETACH_USER_RING from the same handle,
+// on cancel or when the handle is closed
+
+// synchronized start, CX_IOCTL_SYNC_START can be sent to any device
+// every listed device (the N of \\.\cxadcN) must be idle, they are armed and then started back to back
+// with interrupts masked on the calling cpu, timestamp is the performance counter right after a device
+// was started and gp_cnt the raw CX_VIDEO_VBI_GP_COUNTER read with it
+// capture continues until the last reader of each device closes, as for a capture started by a read
+// a device that never gets a reader captures until the handle that sent CX_IOCTL_SYNC_START is closed
+// or sends it again, keep_alive applies from then on
+#define CX_SYNC_START_MAX_DEVICES       8
+
+typedef struct _CX_SYNC_START_DATA
+{
+    ULONG count;
+    ULONG dev_idx[CX_SYNC_START_MAX_DEVICES];
+} CX_SYNC_START_DATA, *PCX_SYNC_START_DATA;
+
+typedef struct _CX_SYNC_START_CARD
+{
+    ULONG dev_idx;
+    ULONG gp_cnt;
+    LONG64 timestamp;
+} CX_SYNC_START_CARD, *PCX_SYNC_START_CARD;
+
+typedef struct _CX_SYNC_START_RESULT
+{
+    ULONG count;
+    ULONG reserved;
+    LONG64 timestamp_freq;
+    LONG64 skew;            // last timestamp - first timestamp
+    CX_SYNC_START_CARD cards[CX_SYNC_START_MAX_DEVICES];
+} CX_SYNC_START_RESULT, *PCX_SYNC_START_RESULT;
+
+// register program, CX_IOCTL_REGISTER_PROGRAM runs a list of register ops in order
+// input is a CX_REG_PROGRAM followed by count CX_REG_OPs, every op is checked before any of them runs
+// output is a CX_REG_PROGRAM_RESULT followed by one ULONG per READ, MODIFY and POLL op:
+// READ the value read, MODIFY the value before it was modified, POLL the last value read
+// a POLL that times out stops the program, done says how many ops ran
+// the POLL ops of one program wait CX_REG_PROGRAM_TIME_MAX in total, a POLL still waiting then times out
+#define CX_REG_OP_READ                  0 // read addr
+#define CX_REG_OP_WRITE                 1 // write value to addr
+#define CX_REG_OP_MODIFY                2 // write (old & ~mask) | (value & mask) to addr
+#define CX_REG_OP_POLL                  3 // read addr until (reg & mask) == value, or poll_timeout
+
+#define CX_REG_PROGRAM_MAX_OPS          1024
+#define CX_REG_POLL_TIMEOUT_MAX         100000 // microseconds
+#define CX_REG_PROGRAM_TIME_MAX         1000000 // microseconds
+
+typedef struct _CX_REG_OP
+{
+    ULONG op;
+    ULONG addr;
+    ULONG mask;
+    ULONG value;
+} CX_REG_OP, *PCX_REG_OP;
+
+typedef struct _CX_REG_PROGRAM
+{
+    ULONG count;
+    ULONG poll_timeout;     // microseconds per POLL op
+    CX_REG_OP ops[1];
+} CX_REG_PROGRAM, *PCX_REG_PROGRAM;
+
+typedef struct _CX_REG_PROGRAM_RESULT
+{
+    ULONG done;             // ops run, count unless a POLL timed out
+    ULONG value_count;      // ULONGs following in values
+    ULONG values[1];
+} CX_REG_PROGRAM_RESULT, *PCX_REG_PROGRAM_RESULT;
+
+typedef struct _CX_RING_MMAP_DATA
+{
+    PVOID hdr;
+    PVOID ring;
+} CX_RING_MMAP_DATA, *PCX_RING_MMAP_DATA;
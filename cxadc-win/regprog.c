@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#include "regprog.h"
+
+// input holds exactly count ops, each a known op on an aligned address in [addr_min, addr_max]
+// value_count is the number of ULONGs the program returns
+BOOLEAN cx_reg_program_valid(
+    _In_reads_bytes_(in_len) PCX_REG_PROGRAM prog,
+    _In_ size_t in_len,
+    _In_ ULONG addr_min,
+    _In_ ULONG addr_max,
+    _Out_ PULONG value_count
+)
+{
+    *value_count = 0;
+
+    if (in_len < FIELD_OFFSET(CX_REG_PROGRAM, ops))
+    {
+        return FALSE;
+    }
+
+    if (!prog->count || prog->count > CX_REG_PROGRAM_MAX_OPS ||
+        in_len != FIELD_OFFSET(CX_REG_PROGRAM, ops) + (size_t)prog->count * sizeof(CX_REG_OP) ||
+        prog->poll_timeout > CX_REG_POLL_TIMEOUT_MAX)
+    {
+        return FALSE;
+    }
+
+    for (ULONG i = 0; i < prog->count; i++)
+    {
+        PCX_REG_OP op = &prog->ops[i];
+
+        if (op->op > CX_REG_OP_POLL || op->addr < addr_min || op->addr > addr_max || (op->addr & 3))
+        {
+            return FALSE;
+        }
+
+        if (op->op != CX_REG_OP_WRITE)
+        {
+            *value_count += 1;
+        }
+    }
+
+    return TRUE;
+}
+
+size_t cx_reg_program_result_size(
+    _In_ ULONG value_count
+)
+{
+    return FIELD_OFFSET(CX_REG_PROGRAM_RESULT, values) + (size_t)value_count * sizeof(ULONG);
+}
+
+// run a validated program, result must hold cx_reg_program_result_size bytes
+// POLL ops wait poll_timeout each and CX_REG_PROGRAM_TIME_MAX between them, whichever runs out first
+VOID cx_reg_program_run(
+    _In_ PCX_REG_PROGRAM_OPS ops,
+    _In_ PVOID ctx,
+    _In_ PCX_REG_PROGRAM prog,
+    _Out_ PCX_REG_PROGRAM_RESULT result
+)
+{
+    ULONG total = 0;
+
+    result->done = 0;
+    result->value_count = 0;
+
+    for (ULONG i = 0; i < prog->count; i++)
+    {
+        PCX_REG_OP op = &prog->ops[i];
+
+        switch (op->op)
+        {
+        case CX_REG_OP_READ:
+            result->values[result->value_count++] = ops->read(ctx, op->addr);
+            break;
+
+        case CX_REG_OP_WRITE:
+            ops->write(ctx, op->addr, op->value);
+            break;
+
+        case CX_REG_OP_MODIFY:
+        {
+            ULONG old = ops->read(ctx, op->addr);
+            ops->write(ctx, op->addr, (old & ~op->mask) | (op->value & op->mask));
+            result->values[result->value_count++] = old;
+            break;
+        }
+
+        case CX_REG_OP_POLL:
+        {
+            ULONG waited = 0;
+            ULONG reg = ops->read(ctx, op->addr);
+
+            while ((reg & op->mask) != op->value && waited < prog->poll_timeout && total < CX_REG_PROGRAM_TIME_MAX)
+            {
+                ULONG us = ops->wait(ctx, CX_REG_POLL_INTERVAL);
+
+                waited += us;
+                total += us;
+                reg = ops->read(ctx, op->addr);
+            }
+
+            result->values[result->value_count++] = reg;
+
+            if ((reg & op->mask) != op->value)
+            {
+                return;
+            }
+
+            break;
+        }
+
+        default:
+            return;
+        }
+
+        result->done += 1;
+    }
+}
@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#pragma once
+
+#include "portable.h"
+
+// register programs, CX_IOCTL_REGISTER_PROGRAM
+// register access is done through CX_REG_PROGRAM_OPS
+
+#define CX_REG_POLL_INTERVAL        10 // microseconds between POLL reads
+
+typedef struct _CX_REG_PROGRAM_OPS
+{
+    ULONG (*read)(_In_ PVOID ctx, _In_ ULONG addr);
+    VOID (*write)(_In_ PVOID ctx, _In_ ULONG addr, _In_ ULONG value);
+    ULONG (*wait)(_In_ PVOID ctx, _In_ ULONG us);      // wait at least us, returns the microseconds waited
+} CX_REG_PROGRAM_OPS, *PCX_REG_PROGRAM_OPS;
+
+BOOLEAN cx_reg_program_valid(
+    _In_reads_bytes_(in_len) PCX_REG_PROGRAM prog,
+    _In_ size_t in_len,
+    _In_ ULONG addr_min,
+    _In_ ULONG addr_max,
+    _Out_ PULONG value_count
+);
+size_t cx_reg_program_result_size(_In_ ULONG value_count);
+VOID cx_reg_program_run(
+    _In_ PCX_REG_PROGRAM_OPS ops,
+    _In_ PVOID ctx,
+    _In_ PCX_REG_PROGRAM prog,
+    _Out_ PCX_REG_PROGRAM_RESULT result
+);
@@ -0,0 +1,240 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#include "ring.h"
+
+// set up the geometry of a ring of size bytes, built from chunk_size chunks
+// size must be a multiple of chunk_size, which must be a power of 2 >= PAGE_SIZE
+BOOLEAN cx_ring_init(
+    _Out_ PCX_RING ring,
+    _In_ ULONG size,
+    _In_ ULONG chunk_size
+)
+{
+    *ring = (CX_RING) { 0 };
+
+    if (chunk_size < PAGE_SIZE || (chunk_size & (chunk_size - 1)) || !size || (size % chunk_size))
+    {
+        return FALSE;
+    }
+
+    ULONG gp_size = PAGE_SIZE;
+
+    while ((size / gp_size) > CX_GP_CNT_MAX)
+    {
+        gp_size *= 2;
+    }
+
+    if (size % gp_size)
+    {
+        return FALSE;
+    }
+
+    ring->size = size;
+    ring->chunk_size = chunk_size;
+    ring->chunk_count = size / chunk_size;
+    ring->gp_size = gp_size;
+
+    return TRUE;
+}
+
+// byte offset into the ring of stream position pos, for a capture that started at initial_page
+ULONG cx_ring_offset(
+    _In_ PCX_RING ring,
+    _In_ LONG initial_page,
+    _In_ LONG64 pos
+)
+{
+    return (ULONG)((((ULONG64)initial_page * ring->gp_size) + (ULONG64)pos) % ring->size);
+}
+
+// contiguous bytes readable at ring_off, limited to len and the end of its chunk
+ULONG cx_ring_span(
+    _In_ PCX_RING ring,
+    _In_ ULONG ring_off,
+    _In_ LONG64 len,
+    _Out_ PULONG chunk_idx,
+    _Out_ PULONG chunk_off
+)
+{
+    *chunk_idx = ring_off / ring->chunk_size;
+    *chunk_off = ring_off % ring->chunk_size;
+
+    ULONG span = ring->chunk_size - *chunk_off;
+
+    if ((LONG64)span > len)
+    {
+        span = (ULONG)len;
+    }
+
+    return span;
+}
+
+// copy len bytes at stream position pos, for a capture that started at initial_page
+// fn is handed whole contiguous spans, a span ends at the end of a chunk or len
+// returns FALSE if fn stopped the copy
+BOOLEAN cx_ring_copy(
+    _In_ PCX_RING ring,
+    _In_ LONG initial_page,
+    _In_ LONG64 pos,
+    _In_ LONG64 len,
+    _In_ CX_RING_SPAN_FN fn,
+    _In_ PVOID ctx
+)
+{
+    ULONG ring_off = cx_ring_offset(ring, initial_page, pos);
+
+    for (LONG64 done = 0; done < len;)
+    {
+        ULONG chunk_idx, chunk_off;
+        ULONG span = cx_ring_span(ring, ring_off, len - done, &chunk_idx, &chunk_off);
+
+        if (!fn(ctx, chunk_idx, chunk_off, span, done))
+        {
+            return FALSE;
+        }
+
+        ring_off = (ring_off + span) % ring->size;
+        done += span;
+    }
+
+    return TRUE;
+}
+
+// set the bytes between IRQ1s, must be a power of 2
+// clamped so that it covers at least one gp_cnt unit and no more than the ring
+ULONG cx_ring_set_irq_period(
+    _Inout_ PCX_RING ring,
+    _In_ ULONG irq_period
+)
+{
+    while (irq_period > ring->size && irq_period > ring->gp_size)
+    {
+        irq_period /= 2;
+    }
+
+    ring->irq_period = max(irq_period, ring->gp_size);
+    ring->margin = ring->irq_period;
+    return ring->irq_period;
+}
+
+// set the publishing mode, 0 for the risc interrupt, otherwise polls a second
+// returns the margin, how far the engine may be ahead of write_pos
+// an interrupt publishes each period as it completes, so the engine is at most irq_period ahead
+// a poll holds back the unit the counter points at, and the engine moves on at up to
+// CX_RING_BYTE_RATE_MAX for a poll period plus however late the next tick is, allowed one more period
+ULONG cx_ring_set_poll_rate(
+    _Inout_ PCX_RING ring,
+    _In_ ULONG poll_rate
+)
+{
+    if (!poll_rate)
+    {
+        ring->margin = ring->irq_period;
+        return ring->margin;
+    }
+
+    ULONG64 margin = ring->gp_size + 2ULL * CX_RING_BYTE_RATE_MAX / poll_rate;
+    margin = (margin + ring->gp_size - 1) / ring->gp_size * ring->gp_size;
+
+    ring->margin = (ULONG)min(margin, (ULONG64)ring->size);
+    return ring->margin;
+}
+
+// round gp_cnt down to the last IRQ1 boundary, or the end of the ring
+LONG cx_ring_gp_round(
+    _In_ PCX_RING ring,
+    _In_ LONG gp_cnt
+)
+{
+    return gp_cnt & ~(LONG)((ring->irq_period / ring->gp_size) - 1);
+}
+
+// gp_cnt a poll can publish, stepped back over the unit the counter points at
+// without an IRQ1 nothing guarantees that unit is resident yet, see cx_evt_dpc
+// the first poll of a capture (last_gp_cnt < 0) starts the stream at the unit being written,
+// a counter that has not moved since then publishes nothing
+LONG cx_ring_gp_poll(
+    _In_ PCX_RING ring,
+    _In_ LONG last_gp_cnt,
+    _In_ LONG gp_cnt
+)
+{
+    LONG gp_count = (LONG)(ring->size / ring->gp_size);
+
+    if (last_gp_cnt < 0 || gp_cnt == last_gp_cnt)
+    {
+        return gp_cnt;
+    }
+
+    return (gp_cnt - 1 + gp_count) % gp_count;
+}
+
+// bytes written between two gp_cnt values, gp_cnt resets to 0 at the end of the ring
+ULONG cx_ring_gp_delta(
+    _In_ PCX_RING ring,
+    _In_ LONG prev_gp_cnt,
+    _In_ LONG gp_cnt
+)
+{
+    LONG gp_count = (LONG)(ring->size / ring->gp_size);
+    return (ULONG)((gp_cnt - prev_gp_cnt + gp_count) % gp_count) * ring->gp_size;
+}
+
+// oldest stream position that is still intact at write_pos
+// the engine may already be filling up to margin bytes after write_pos, which hold the oldest data in the ring
+LONG64 cx_ring_oldest_pos(
+    _In_ PCX_RING ring,
+    _In_ LONG64 write_pos
+)
+{
+    LONG64 oldest = write_pos - ring->size + ring->margin;
+    return oldest > 0 ? oldest : 0;
+}
+
+// bytes overwritten ahead of a reader at read_pos, 0 if it has not been lapped
+LONG64 cx_ring_lost(
+    _In_ PCX_RING ring,
+    _In_ LONG64 write_pos,
+    _In_ LONG64 read_pos
+)
+{
+    LONG64 oldest = cx_ring_oldest_pos(ring, write_pos);
+    return read_pos < oldest ? oldest - read_pos : 0;
+}
+
+// bytes a reader at read_pos can take at write_pos, after skipping what has been overwritten
+// 0 for a position the capture has not reached yet
+LONG64 cx_ring_available(
+    _In_ PCX_RING ring,
+    _In_ LONG64 write_pos,
+    _In_ LONG64 read_pos
+)
+{
+    LONG64 start = read_pos + cx_ring_lost(ring, write_pos, read_pos);
+    return write_pos > start ? write_pos - start : 0;
+}
+
+// stream position offset bytes from origin (CX_READ_ORIGIN_*) at write_pos
+// clamped to the oldest intact data, a position past write_pos waits for the capture to reach it
+LONG64 cx_ring_join_pos(
+    _In_ PCX_RING ring,
+    _In_ LONG64 write_pos,
+    _In_ ULONG origin,
+    _In_ LONG64 offset
+)
+{
+    LONG64 pos = origin == CX_READ_ORIGIN_HEAD ? write_pos - offset : offset;
+    LONG64 oldest = cx_ring_oldest_pos(ring, write_pos);
+    return pos > oldest ? pos : oldest;
+}
@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#pragma once
+
+#include "portable.h"
+
+// ring index & wrap math
+
+// gp_cnt is 16 bits, so one count covers gp_size bytes (PAGE_SIZE up to 256 MB)
+#define CX_GP_CNT_MAX               0x10000
+
+// fastest the card can fill the ring, 16-bit samples at a 50 MHz clock
+#define CX_RING_BYTE_RATE_MAX       (50000000 * 2)
+
+typedef struct _CX_RING
+{
+    ULONG size;
+    ULONG chunk_size;
+    ULONG chunk_count;
+    ULONG gp_size;
+    ULONG irq_period;
+    ULONG margin;               // bytes the engine may be ahead of write_pos, overwriting the oldest data
+} CX_RING, *PCX_RING;
+
+// copies one contiguous span of a cx_ring_copy, span bytes at chunk_off in chunk chunk_idx,
+// done bytes into the copy, returns FALSE to stop it
+typedef BOOLEAN (*CX_RING_SPAN_FN)(_In_ PVOID ctx, _In_ ULONG chunk_idx, _In_ ULONG chunk_off, _In_ ULONG span, _In_ LONG64 done);
+
+BOOLEAN cx_ring_init(_Out_ PCX_RING ring, _In_ ULONG size, _In_ ULONG chunk_size);
+ULONG cx_ring_offset(_In_ PCX_RING ring, _In_ LONG initial_page, _In_ LONG64 pos);
+ULONG cx_ring_span(_In_ PCX_RING ring, _In_ ULONG ring_off, _In_ LONG64 len, _Out_ PULONG chunk_idx, _Out_ PULONG chunk_off);
+BOOLEAN cx_ring_copy(
+    _In_ PCX_RING ring,
+    _In_ LONG initial_page,
+    _In_ LONG64 pos,
+    _In_ LONG64 len,
+    _In_ CX_RING_SPAN_FN fn,
+    _In_ PVOID ctx
+);
+ULONG cx_ring_set_irq_period(_Inout_ PCX_RING ring, _In_ ULONG irq_period);
+ULONG cx_ring_set_poll_rate(_Inout_ PCX_RING ring, _In_ ULONG poll_rate);
+LONG cx_ring_gp_round(_In_ PCX_RING ring, _In_ LONG gp_cnt);
+LONG cx_ring_gp_poll(_In_ PCX_RING ring, _In_ LONG last_gp_cnt, _In_ LONG gp_cnt);
+ULONG cx_ring_gp_delta(_In_ PCX_RING ring, _In_ LONG prev_gp_cnt, _In_ LONG gp_cnt);
+LONG64 cx_ring_oldest_pos(_In_ PCX_RING ring, _In_ LONG64 write_pos);
+LONG64 cx_ring_lost(_In_ PCX_RING ring, _In_ LONG64 write_pos, _In_ LONG64 read_pos);
+LONG64 cx_ring_available(_In_ PCX_RING ring, _In_ LONG64 write_pos, _In_ LONG64 read_pos);
+LONG64 cx_ring_join_pos(_In_ PCX_RING ring, _In_ LONG64 write_pos, _In_ ULONG origin, _In_ LONG64 offset);
@@ -0,0 +1,248 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#include "risc.h"
+
+// emit the write_len byte WRITEs filling one contiguous chunk that starts at ring_off
+// write_len is the fifo cluster size, a power of 2 that divides a page
+// returns the next free instruction
+PCX_RISC_INSTR_WRITE cx_risc_write_chunk(
+    _Out_ PCX_RISC_INSTR_WRITE write_instr,
+    _In_ PCX_RING ring,
+    _In_ ULONG write_len,
+    _In_ ULONG ring_off,
+    _In_ ULONG chunk_addr,
+    _In_ ULONG chunk_len
+)
+{
+    // Each WRITE is write_len bytes, the chunk is contiguous so
+    // no WRITE ever has to be split.
+    for (ULONG off = 0; off < chunk_len; off += write_len)
+    {
+        ULONG end = ring_off + off + write_len;
+
+        *write_instr = (CX_RISC_INSTR_WRITE)
+        {
+            .opcode = CX_RISC_INSTR_WRITE_OPCODE,
+            .sol = 1,
+            .eol = 1,
+            .byte_count = write_len,
+            .pci_target_address = chunk_addr + off
+        };
+
+        // gp_cnt counts units of gp_size bytes
+        if ((end % ring->gp_size) == 0)
+        {
+            // always increment final write of a unit
+            write_instr->cnt_ctl = 1;
+
+            // reset counter on last unit
+            if (end == ring->size)
+            {
+                write_instr->cnt_ctl = 3;
+            }
+
+            // trigger IRQ1
+            if ((end % ring->irq_period) == 0 || end == ring->size)
+            {
+                write_instr->irq1 = 1;
+            }
+        }
+
+        write_instr++;
+    }
+
+    return write_instr;
+}
+
+// append an element of the scatter/gather list the dma adapter built for a client buffer,
+// merging it with the last segment when they are contiguous on the bus
+// returns FALSE if it is not whole pages or out of reach of the 32-bit bus master
+BOOLEAN cx_risc_sg_add(
+    _Inout_updates_(*sg_count + 1) PCX_SG_ENTRY sg,
+    _Inout_ PULONG sg_count,
+    _In_ ULONG64 addr,
+    _In_ ULONG len
+)
+{
+    if (((addr | len) & (PAGE_SIZE - 1)) || !len || addr + len > 0x100000000ULL)
+    {
+        return FALSE;
+    }
+
+    if (*sg_count && (ULONG64)sg[*sg_count - 1].addr + sg[*sg_count - 1].len == addr)
+    {
+        sg[*sg_count - 1].len += len;
+        return TRUE;
+    }
+
+    sg[(*sg_count)++] = (CX_SG_ENTRY)
+    {
+        .addr = (ULONG)addr,
+        .len = len
+    };
+
+    return TRUE;
+}
+
+// TRUE if the adapter gave part of the buffer a bounce buffer, which only copies to the pages when the list is put back
+// without dma remapping a page below 4 GB keeps its physical address, and a page above it can only have been bounced
+// pfns are the buffer's pages, the list covers them in order
+BOOLEAN cx_risc_sg_bounced(
+    _In_reads_(sg_count) PCX_SG_ENTRY sg,
+    _In_ ULONG sg_count,
+    _In_reads_(page_count) const ULONG64* pfns,
+    _In_ ULONG page_count
+)
+{
+    BOOLEAN remapped = FALSE;
+    BOOLEAN high = FALSE;
+    ULONG page = 0;
+
+    for (ULONG i = 0; i < sg_count; i++)
+    {
+        for (ULONG off = 0; off < sg[i].len && page < page_count; off += PAGE_SIZE, page++)
+        {
+            ULONG64 phys = pfns[page] << PAGE_SHIFT;
+
+            if (phys >= 0x100000000ULL)
+            {
+                high = TRUE;
+            }
+            else if (phys != (ULONG64)sg[i].addr + off)
+            {
+                remapped = TRUE;
+            }
+        }
+    }
+
+    return high && !remapped;
+}
+
+// program buffers needed for a ring_size ring of write_len byte WRITEs
+ULONG cx_risc_buf_count(
+    _In_ ULONG ring_size,
+    _In_ ULONG write_len
+)
+{
+    ULONG writes = ring_size / write_len;
+
+    return writes ? (writes + CX_RISC_BUF_WRITES - 1) / CX_RISC_BUF_WRITES : 1;
+}
+
+static VOID cx_risc_prog_buf(
+    _Inout_ PCX_RISC_PROG prog
+)
+{
+    prog->write_instr = (PCX_RISC_INSTR_WRITE)(prog->bufs[prog->buf_idx].va + sizeof(CX_RISC_INSTR_SYNC));
+    prog->buf_end = prog->write_instr + CX_RISC_BUF_WRITES;
+}
+
+static VOID cx_risc_jump(
+    _Out_ PCX_RISC_INSTR_WRITE instr,
+    _In_ PCX_RISC_BUF buf
+)
+{
+    // the SYNC slot is skipped, in the first buffer it is only run once
+    *(PCX_RISC_INSTR_JUMP)instr = (CX_RISC_INSTR_JUMP)
+    {
+        .opcode = CX_RISC_INSTR_JUMP_OPCODE,
+        .jump_address = buf->addr + sizeof(CX_RISC_INSTR_SYNC)
+    };
+}
+
+// start a program in buf_count buffers of CX_RISC_BUF_SIZE, from cx_risc_buf_count
+VOID cx_risc_prog_begin(
+    _Out_ PCX_RISC_PROG prog,
+    _In_reads_(buf_count) PCX_RISC_BUF bufs,
+    _In_ ULONG buf_count
+)
+{
+    *prog = (CX_RISC_PROG)
+    {
+        .bufs = bufs,
+        .buf_count = buf_count
+    };
+
+    *(PCX_RISC_INSTR_SYNC)bufs[0].va = (CX_RISC_INSTR_SYNC)
+    {
+        .opcode = CX_RISC_INSTR_SYNC_OPCODE,
+        .cnt_ctl = 3,
+    };
+
+    cx_risc_prog_buf(prog);
+}
+
+// append the WRITEs filling the next len bytes of the ring, contiguous on the bus at addr
+// a run that does not fit in the current buffer carries on in the next one
+// returns FALSE if the program needs more buffers than it was given
+BOOLEAN cx_risc_prog_write(
+    _Inout_ PCX_RISC_PROG prog,
+    _In_ PCX_RING ring,
+    _In_ ULONG write_len,
+    _In_ ULONG addr,
+    _In_ ULONG len
+)
+{
+    for (ULONG off = 0; off < len;)
+    {
+        if (prog->write_instr == prog->buf_end)
+        {
+            if (prog->buf_idx + 1 >= prog->buf_count)
+            {
+                return FALSE;
+            }
+
+            cx_risc_jump(prog->buf_end, &prog->bufs[++prog->buf_idx]);
+            cx_risc_prog_buf(prog);
+        }
+
+        ULONG part = min(len - off, (ULONG)(prog->buf_end - prog->write_instr) * write_len);
+
+        prog->write_instr = cx_risc_write_chunk(prog->write_instr, ring, write_len, prog->ring_off, addr + off, part);
+        prog->ring_off += part;
+        off += part;
+    }
+
+    return TRUE;
+}
+
+// close the program with a JUMP back to the first WRITE
+VOID cx_risc_prog_end(
+    _Inout_ PCX_RISC_PROG prog
+)
+{
+    cx_risc_jump(prog->write_instr, &prog->bufs[0]);
+}
+
+// append the WRITEs filling a ring made of sg_count segments, laid out in order from ring offset 0
+// returns FALSE if the program needs more buffers than it was given
+BOOLEAN cx_risc_write_sg(
+    _Inout_ PCX_RISC_PROG prog,
+    _In_ PCX_RING ring,
+    _In_ ULONG write_len,
+    _In_reads_(sg_count) PCX_SG_ENTRY sg,
+    _In_ ULONG sg_count
+)
+{
+    // segments are whole pages, so every WRITE still fits inside one
+    for (ULONG i = 0; i < sg_count; i++)
+    {
+        if (!cx_risc_prog_write(prog, ring, write_len, sg[i].addr, sg[i].len))
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#pragma once
+
+#include "cx2388x_regs.h"
+#include "ring.h"
+
+// RISC program generation
+
+// the program is split over buffers of CX_RISC_BUF_SIZE, each a separate common buffer,
+// so even a large ring with small clusters needs no large contiguous allocation for it
+// every buffer has room for a SYNC, used in the first only, CX_RISC_BUF_WRITES WRITEs and
+// a JUMP to the next buffer, the last one jumps back to the first WRITE
+#define CX_RISC_BUF_SIZE        (1024 * 64)
+#define CX_RISC_BUF_WRITES      ((ULONG)((CX_RISC_BUF_SIZE - sizeof(CX_RISC_INSTR_SYNC) - sizeof(CX_RISC_INSTR_JUMP)) / sizeof(CX_RISC_INSTR_WRITE)))
+
+typedef struct _CX_RISC_BUF
+{
+    PUCHAR va;
+    ULONG addr;     // bus address
+} CX_RISC_BUF, *PCX_RISC_BUF;
+
+// a program being written, see cx_risc_prog_begin
+typedef struct _CX_RISC_PROG
+{
+    PCX_RISC_BUF bufs;
+    ULONG buf_count;
+    ULONG buf_idx;
+    ULONG ring_off;
+    PCX_RISC_INSTR_WRITE write_instr;   // next free WRITE
+    PCX_RISC_INSTR_WRITE buf_end;       // where the current buffer's JUMP goes
+} CX_RISC_PROG, *PCX_RISC_PROG;
+
+// run of pages of a client buffer that is contiguous on the bus
+typedef struct _CX_SG_ENTRY
+{
+    ULONG addr;
+    ULONG len;
+} CX_SG_ENTRY, *PCX_SG_ENTRY;
+
+PCX_RISC_INSTR_WRITE cx_risc_write_chunk(
+    _Out_ PCX_RISC_INSTR_WRITE write_instr,
+    _In_ PCX_RING ring,
+    _In_ ULONG write_len,
+    _In_ ULONG ring_off,
+    _In_ ULONG chunk_addr,
+    _In_ ULONG chunk_len
+);
+
+BOOLEAN cx_risc_sg_add(
+    _Inout_updates_(*sg_count + 1) PCX_SG_ENTRY sg,
+    _Inout_ PULONG sg_count,
+    _In_ ULONG64 addr,
+    _In_ ULONG len
+);
+
+BOOLEAN cx_risc_sg_bounced(
+    _In_reads_(sg_count) PCX_SG_ENTRY sg,
+    _In_ ULONG sg_count,
+    _In_reads_(page_count) const ULONG64* pfns,
+    _In_ ULONG page_count
+);
+
+ULONG cx_risc_buf_count(_In_ ULONG ring_size, _In_ ULONG write_len);
+
+VOID cx_risc_prog_begin(
+    _Out_ PCX_RISC_PROG prog,
+    _In_reads_(buf_count) PCX_RISC_BUF bufs,
+    _In_ ULONG buf_count
+);
+
+BOOLEAN cx_risc_prog_write(
+    _Inout_ PCX_RISC_PROG prog,
+    _In_ PCX_RING ring,
+    _In_ ULONG write_len,
+    _In_ ULONG addr,
+    _In_ ULONG len
+);
+
+VOID cx_risc_prog_end(_Inout_ PCX_RISC_PROG prog);
+
+BOOLEAN cx_risc_write_sg(
+    _Inout_ PCX_RISC_PROG prog,
+    _In_ PCX_RING ring,
+    _In_ ULONG write_len,
+    _In_reads_(sg_count) PCX_SG_ENTRY sg,
+    _In_ ULONG sg_count
+);
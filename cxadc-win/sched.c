@@ -0,0 +1,103 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#include "sched.h"
+
+// next step for a read at read_pos that has done bytes filled and remaining bytes left
+// the caller applies the step and calls again until WAIT or a completing action
+CX_READ_ACTION cx_read_step(
+    _In_ PCX_RING ring,
+    _In_ LONG64 write_pos,
+    _In_ LONG64 read_pos,
+    _In_ LONG64 done,
+    _In_ LONG64 remaining,
+    _In_ ULONG overrun_policy,
+    _In_ BOOLEAN is_capturing,
+    _Out_ PLONG64 len
+)
+{
+    *len = 0;
+
+    if (!remaining)
+    {
+        return CX_READ_COMPLETE;
+    }
+
+    LONG64 lost = cx_ring_lost(ring, write_pos, read_pos);
+
+    if (lost)
+    {
+        *len = lost;
+
+        switch (overrun_policy)
+        {
+        case CX_OVERRUN_POLICY_FAIL:
+            return CX_READ_FAIL;
+
+        case CX_OVERRUN_POLICY_SHORT:
+            // nothing before the gap, carry on after it
+            return done ? CX_READ_SHORT : CX_READ_SKIP;
+
+        default:
+            return CX_READ_SKIP;
+        }
+    }
+
+    if (read_pos < write_pos)
+    {
+        *len = min(remaining, write_pos - read_pos);
+        return CX_READ_COPY;
+    }
+
+    // nothing more will arrive
+    if (!is_capturing)
+    {
+        return CX_READ_COMPLETE;
+    }
+
+    return CX_READ_WAIT;
+}
+
+// write_pos at which a read at read_pos with remaining bytes left is next worth servicing
+// it waits for all of them at once, or for half the ring when it is larger, which leaves the
+// copy half a ring of headroom before the capture laps it
+LONG64 cx_read_wake_pos(
+    _In_ PCX_RING ring,
+    _In_ LONG64 read_pos,
+    _In_ LONG64 remaining
+)
+{
+    return read_pos + min(remaining, (LONG64)(ring->size / 2));
+}
+
+// after publishing write_pos, TRUE if a parked read can now be filled and the read work item must run
+BOOLEAN cx_wake_due(
+    _In_ volatile LONG64* write_pos,
+    _In_ volatile LONG64* wake_pos
+)
+{
+    return InterlockedCompareExchange64(write_pos, 0, 0) >= InterlockedCompareExchange64(wake_pos, 0, 0);
+}
+
+// at the end of a pass of the read work item, store pos, the lowest write_pos a parked read waits for
+// a publisher that ran during the pass compared against the old wake_pos and may not have queued
+// the work item, so TRUE if write_pos has already reached pos and the pass must be repeated
+BOOLEAN cx_wake_set(
+    _In_ volatile LONG64* write_pos,
+    _Inout_ volatile LONG64* wake_pos,
+    _In_ LONG64 pos
+)
+{
+    InterlockedExchange64(wake_pos, pos);
+    return InterlockedCompareExchange64(write_pos, 0, 0) >= pos;
+}
@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#pragma once
+
+#include "ring.h"
+
+// read scheduling, decides the next step for a pending read
+
+typedef enum _CX_READ_ACTION
+{
+    CX_READ_WAIT,           // no data at read_pos yet
+    CX_READ_COPY,           // len bytes at read_pos are ready to copy
+    CX_READ_SKIP,           // lapped, move read_pos forward by len and continue
+    CX_READ_SHORT,          // lapped, move read_pos forward by len and complete with what was copied
+    CX_READ_FAIL,           // lapped, move read_pos forward by len and fail the read
+    CX_READ_COMPLETE        // read is full, or capture stopped
+} CX_READ_ACTION;
+
+CX_READ_ACTION cx_read_step(
+    _In_ PCX_RING ring,
+    _In_ LONG64 write_pos,
+    _In_ LONG64 read_pos,
+    _In_ LONG64 done,
+    _In_ LONG64 remaining,
+    _In_ ULONG overrun_policy,
+    _In_ BOOLEAN is_capturing,
+    _Out_ PLONG64 len
+);
+
+LONG64 cx_read_wake_pos(
+    _In_ PCX_RING ring,
+    _In_ LONG64 read_pos,
+    _In_ LONG64 remaining
+);
+
+// wake protocol between the publisher (dpc or poll tick) and the read work item
+
+BOOLEAN cx_wake_due(
+    _In_ volatile LONG64* write_pos,
+    _In_ volatile LONG64* wake_pos
+);
+
+BOOLEAN cx_wake_set(
+    _In_ volatile LONG64* write_pos,
+    _Inout_ volatile LONG64* wake_pos,
+    _In_ LONG64 pos
+);
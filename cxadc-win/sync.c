@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#include "sync.h"
+
+// 1 to CX_SYNC_START_MAX_DEVICES device indexes, each listed once
+BOOLEAN cx_sync_valid_list(
+    _In_reads_(count) PULONG dev_idx,
+    _In_ ULONG count
+)
+{
+    if (!count || count > CX_SYNC_START_MAX_DEVICES)
+    {
+        return FALSE;
+    }
+
+    for (ULONG i = 0; i < count; i++)
+    {
+        for (ULONG j = i + 1; j < count; j++)
+        {
+            if (dev_idx[i] == dev_idx[j])
+            {
+                return FALSE;
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+// positions of dev_idx in ascending order, the order their locks are taken in
+VOID cx_sync_lock_order(
+    _In_reads_(count) PULONG dev_idx,
+    _In_ ULONG count,
+    _Out_writes_(count) PULONG order
+)
+{
+    for (ULONG i = 0; i < count; i++)
+    {
+        ULONG j = i;
+
+        for (; j > 0 && dev_idx[order[j - 1]] > dev_idx[i]; j--)
+        {
+            order[j] = order[j - 1];
+        }
+
+        order[j] = i;
+    }
+}
+
+// arm every device, then start them back to back inside one begin/end window
+// cards[i] receives the start timestamp & gp_cnt of devs[i], dev_idx is left to the caller
+// if a device fails to arm, the devices armed before it are disarmed and nothing is started
+BOOLEAN cx_sync_start(
+    _In_ PCX_SYNC_OPS ops,
+    _In_ PVOID ctx,
+    _In_reads_(count) PVOID* devs,
+    _In_ ULONG count,
+    _Out_writes_(count) PCX_SYNC_START_CARD cards
+)
+{
+    for (ULONG i = 0; i < count; i++)
+    {
+        if (!ops->arm(ctx, devs[i]))
+        {
+            while (i--)
+            {
+                ops->disarm(ctx, devs[i]);
+            }
+
+            return FALSE;
+        }
+    }
+
+    // nothing but the starts happen in the window, so the spread of the timestamps is the start skew
+    ops->begin(ctx);
+
+    for (ULONG i = 0; i < count; i++)
+    {
+        ops->run(ctx, devs[i], &cards[i].timestamp, &cards[i].gp_cnt);
+    }
+
+    ops->end(ctx);
+
+    return TRUE;
+}
+
+// time between the first and last start
+LONG64 cx_sync_skew(
+    _In_reads_(count) PCX_SYNC_START_CARD cards,
+    _In_ ULONG count
+)
+{
+    LONG64 first = count ? cards[0].timestamp : 0;
+    LONG64 last = first;
+
+    for (ULONG i = 1; i < count; i++)
+    {
+        first = min(first, cards[i].timestamp);
+        last = max(last, cards[i].timestamp);
+    }
+
+    return last - first;
+}
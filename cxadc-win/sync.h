@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * cxadc-win - CX2388x ADC DMA driver for Windows
+ *
+ * Copyright (C) 2024 Jitterbug
+ *
+ * Based on the Linux version created by
+ * Copyright (C) 2005-2007 Hew How Chee <how_chee@yahoo.com>
+ * Copyright (C) 2013-2015 Chad Page <Chad.Page@gmail.com>
+ * Copyright (C) 2019-2023 Adam Sampson <ats@offog.org>
+ * Copyright (C) 2020-2022 Tony Anderson <tandersn@cs.washington.edu>
+ */
+
+#pragma once
+
+#include "portable.h"
+
+// synchronized start of several devices
+// the device work is done through CX_SYNC_OPS
+
+typedef struct _CX_SYNC_OPS
+{
+    BOOLEAN (*arm)(_In_ PVOID ctx, _In_ PVOID dev);     // prepare dev to start, FALSE if it is busy
+    VOID (*disarm)(_In_ PVOID ctx, _In_ PVOID dev);     // undo arm for a dev that was not started
+    VOID (*begin)(_In_ PVOID ctx);                      // enter the start window, e.g. raise irql
+    VOID (*run)(_In_ PVOID ctx, _In_ PVOID dev, _Out_ PLONG64 timestamp, _Out_ PULONG gp_cnt);
+    VOID (*end)(_In_ PVOID ctx);                        // leave the start window
+} CX_SYNC_OPS, *PCX_SYNC_OPS;
+
+BOOLEAN cx_sync_valid_list(_In_reads_(count) PULONG dev_idx, _In_ ULONG count);
+VOID cx_sync_lock_order(_In_reads_(count) PULONG dev_idx, _In_ ULONG count, _Out_writes_(count) PULONG order);
+BOOLEAN cx_sync_start(
+    _In_ PCX_SYNC_OPS ops,
+    _In_ PVOID ctx,
+    _In_reads_(count) PVOID* devs,
+    _In_ ULONG count,
+    _Out_writes_(count) PCX_SYNC_START_CARD cards
+);
+LONG64 cx_sync_skew(_In_reads_(count) PCX_SYNC_START_CARD cards, _In_ ULONG count);